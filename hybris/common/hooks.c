@@ -18,14 +18,17 @@
  */
 
 #include <hybris/common/binding.h>
+#include <hybris/common/dlfcn.h>
 
 #include "hooks_shm.h"
+#include "hooks_pool.h"
 
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdio_ext.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <malloc.h>
@@ -64,6 +67,7 @@
 #include <sys/prctl.h>
 
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <libgen.h>
 #include <mntent.h>
 
@@ -87,11 +91,13 @@ static void (*_android_linker_init)(int sdk_version, void* (*get_hooked_symbol)(
 #endif
 
 static void* (*_android_dlopen)(const char *filename, int flags) = NULL;
+static void* (*_android_dlopen_ext)(const char *filename, int flags, const hybris_dlextinfo *extinfo) = NULL;
 static void* (*_android_dlsym)(void *handle, const char *symbol) = NULL;
 static void* (*_android_dlvsym)(void *handle, const char *symbol, const char* version) = NULL;
 static void* (*_android_dladdr)(void *addr, Dl_info *info) = NULL;
 static int (*_android_dlclose)(void *handle) = NULL;
 static const char* (*_android_dlerror)(void) = NULL;
+static void (*_android_linker_hook_callback_changed)(int has_callback) = NULL;
 
 static int use_vsnprintf_blacklist = 0;
 
@@ -153,6 +159,17 @@ static int use_vsnprintf_blacklist = 0;
  */
 #define HOOK_INDIRECT(symbol) {#symbol, _hybris_hook_##symbol, _hybris_hook_##symbol}
 
+/*
+ * symbols whose hook only protects against callers misusing them (like
+ * passing NULL to strlen) shall use HOOK_QUIRK: they are hooked indirectly,
+ * unless built with --enable-direct-hooks, where they behave as HOOK_DIRECT
+ */
+#ifdef WANT_DIRECT_HOOKS
+#define HOOK_QUIRK(symbol) HOOK_DIRECT(symbol)
+#else
+#define HOOK_QUIRK(symbol) HOOK_INDIRECT(symbol)
+#endif
+
 /* we have a value p:
  *  - if p <= ANDROID_TOP_ADDR_VALUE_MUTEX then it is an android mutex, not one we processed
  *  - if p > VMALLOC_END, then the pointer is not a result of malloc ==> it is an shm offset
@@ -258,7 +275,7 @@ static void hybris_set_mutex_attr(unsigned int android_value, pthread_mutexattr_
 
 static pthread_mutex_t* hybris_alloc_init_mutex(unsigned int android_mutex)
 {
-    pthread_mutex_t *realmutex = malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_t *realmutex = hybris_pool_alloc(HYBRIS_POOL_MUTEX);
     pthread_mutexattr_t attr;
     hybris_set_mutex_attr(android_mutex, &attr);
     pthread_mutex_init(realmutex, &attr);
@@ -267,7 +284,7 @@ static pthread_mutex_t* hybris_alloc_init_mutex(unsigned int android_mutex)
 
 static pthread_cond_t* hybris_alloc_init_cond(void)
 {
-    pthread_cond_t *realcond = malloc(sizeof(pthread_cond_t));
+    pthread_cond_t *realcond = hybris_pool_alloc(HYBRIS_POOL_COND);
     pthread_condattr_t attr;
     pthread_condattr_init(&attr);
     pthread_cond_init(realcond, &attr);
@@ -276,13 +293,76 @@ static pthread_cond_t* hybris_alloc_init_cond(void)
 
 static pthread_rwlock_t* hybris_alloc_init_rwlock(void)
 {
-    pthread_rwlock_t *realrwlock = malloc(sizeof(pthread_rwlock_t));
+    pthread_rwlock_t *realrwlock = hybris_pool_alloc(HYBRIS_POOL_RWLOCK);
     pthread_rwlockattr_t attr;
     pthread_rwlockattr_init(&attr);
     pthread_rwlock_init(realrwlock, &attr);
     return realrwlock;
 }
 
+/*
+ * Statically initialized Android objects are only translated into a glibc
+ * object on first use, and several threads can race on that. The object is
+ * published with a compare-and-swap against the static initializer value
+ * that was observed, so exactly one of them wins and the others free their
+ * copy and use the winner's. Once published, reading the object is a plain
+ * acquire load.
+ */
+static inline unsigned int hybris_load_value(const void *obj)
+{
+    return __atomic_load_n((const unsigned int *) obj, __ATOMIC_ACQUIRE);
+}
+
+static inline int hybris_publish_value(void *obj, unsigned int *expected,
+                                       void *realobj)
+{
+    return __atomic_compare_exchange_n((unsigned int *) obj, expected,
+                                       (unsigned int) realobj, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static pthread_mutex_t* hybris_publish_mutex(pthread_mutex_t *mutex,
+                                             unsigned int android_mutex)
+{
+    pthread_mutex_t *realmutex = hybris_alloc_init_mutex(android_mutex);
+
+    if (!hybris_publish_value(mutex, &android_mutex, realmutex)) {
+        pthread_mutex_destroy(realmutex);
+        hybris_pool_free(HYBRIS_POOL_MUTEX, realmutex);
+        realmutex = (pthread_mutex_t *) android_mutex;
+    }
+
+    return realmutex;
+}
+
+static pthread_cond_t* hybris_publish_cond(pthread_cond_t *cond,
+                                           unsigned int android_cond)
+{
+    pthread_cond_t *realcond = hybris_alloc_init_cond();
+
+    if (!hybris_publish_value(cond, &android_cond, realcond)) {
+        pthread_cond_destroy(realcond);
+        hybris_pool_free(HYBRIS_POOL_COND, realcond);
+        realcond = (pthread_cond_t *) android_cond;
+    }
+
+    return realcond;
+}
+
+static pthread_rwlock_t* hybris_publish_rwlock(pthread_rwlock_t *rwlock,
+                                               unsigned int android_rwlock)
+{
+    pthread_rwlock_t *realrwlock = hybris_alloc_init_rwlock();
+
+    if (!hybris_publish_value(rwlock, &android_rwlock, realrwlock)) {
+        pthread_rwlock_destroy(realrwlock);
+        hybris_pool_free(HYBRIS_POOL_RWLOCK, realrwlock);
+        realrwlock = (pthread_rwlock_t *) android_rwlock;
+    }
+
+    return realrwlock;
+}
+
 /*
  * utils, such as malloc, memcpy
  *
@@ -614,8 +694,8 @@ static int _hybris_hook_pthread_mutex_init(pthread_mutex_t *__mutex,
         pthread_mutexattr_getpshared(__mutexattr, &pshared);
 
     if (!pshared) {
-        /* non shared, standard mutex: use malloc */
-        realmutex = malloc(sizeof(pthread_mutex_t));
+        /* non shared, standard mutex: use the object pool */
+        realmutex = hybris_pool_alloc(HYBRIS_POOL_MUTEX);
 
         *((unsigned int *)__mutex) = (unsigned int) realmutex;
     }
@@ -625,8 +705,10 @@ static int _hybris_hook_pthread_mutex_init(pthread_mutex_t *__mutex,
 
         *((hybris_shm_pointer_t *)__mutex) = handle;
 
-        if (handle)
-            realmutex = (pthread_mutex_t *)hybris_get_shmpointer(handle);
+        if (!handle)
+            return ENOMEM;
+
+        realmutex = (pthread_mutex_t *)hybris_get_shmpointer(handle);
     }
 
     return pthread_mutex_init(realmutex, __mutexattr);
@@ -648,11 +730,14 @@ static int _hybris_hook_pthread_mutex_destroy(pthread_mutex_t *__mutex)
 
     if (!hybris_is_pointer_in_shm((void*)realmutex)) {
         ret = pthread_mutex_destroy(realmutex);
-        free(realmutex);
+        hybris_pool_free(HYBRIS_POOL_MUTEX, realmutex);
     }
     else {
-        realmutex = (pthread_mutex_t *)hybris_get_shmpointer((hybris_shm_pointer_t)realmutex);
+        hybris_shm_pointer_t handle = (hybris_shm_pointer_t)realmutex;
+
+        realmutex = (pthread_mutex_t *)hybris_get_shmpointer(handle);
         ret = pthread_mutex_destroy(realmutex);
+        hybris_shm_free(handle, sizeof(pthread_mutex_t));
     }
 
     *((unsigned int *)__mutex) = 0;
@@ -669,7 +754,7 @@ static int _hybris_hook_pthread_mutex_lock(pthread_mutex_t *__mutex)
         return 0;
     }
 
-    unsigned int value = (*(unsigned int *) __mutex);
+    unsigned int value = hybris_load_value(__mutex);
     if (hybris_check_android_shared_mutex(value)) {
         LOGD("Shared mutex with Android, not locking.");
         return 0;
@@ -681,8 +766,7 @@ static int _hybris_hook_pthread_mutex_lock(pthread_mutex_t *__mutex)
 
     if (value <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
         TRACE("value %p <= ANDROID_TOP_ADDR_VALUE_MUTEX 0x%x", value, ANDROID_TOP_ADDR_VALUE_MUTEX);
-        realmutex = hybris_alloc_init_mutex(value);
-        *((unsigned int *)__mutex) = (unsigned int) realmutex;
+        realmutex = hybris_publish_mutex(__mutex, value);
     }
 
     return pthread_mutex_lock(realmutex);
@@ -690,7 +774,7 @@ static int _hybris_hook_pthread_mutex_lock(pthread_mutex_t *__mutex)
 
 static int _hybris_hook_pthread_mutex_trylock(pthread_mutex_t *__mutex)
 {
-    unsigned int value = (*(unsigned int *) __mutex);
+    unsigned int value = hybris_load_value(__mutex);
 
     TRACE_HOOK("mutex %p", __mutex);
 
@@ -704,8 +788,7 @@ static int _hybris_hook_pthread_mutex_trylock(pthread_mutex_t *__mutex)
         realmutex = (pthread_mutex_t *)hybris_get_shmpointer((hybris_shm_pointer_t)value);
 
     if (value <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
-        realmutex = hybris_alloc_init_mutex(value);
-        *((unsigned int *)__mutex) = (unsigned int) realmutex;
+        realmutex = hybris_publish_mutex(__mutex, value);
     }
 
     return pthread_mutex_trylock(realmutex);
@@ -720,7 +803,7 @@ static int _hybris_hook_pthread_mutex_unlock(pthread_mutex_t *__mutex)
         return 0;
     }
 
-    unsigned int value = (*(unsigned int *) __mutex);
+    unsigned int value = hybris_load_value(__mutex);
     if (hybris_check_android_shared_mutex(value)) {
         LOGD("Shared mutex with Android, not unlocking.");
         return 0;
@@ -743,7 +826,7 @@ static int _hybris_hook_pthread_mutex_lock_timeout_np(pthread_mutex_t *__mutex,
 {
     struct timespec tv;
     pthread_mutex_t *realmutex;
-    unsigned int value = (*(unsigned int *) __mutex);
+    unsigned int value = hybris_load_value(__mutex);
 
     TRACE_HOOK("mutex %p msecs %u", __mutex, __msecs);
 
@@ -755,8 +838,7 @@ static int _hybris_hook_pthread_mutex_lock_timeout_np(pthread_mutex_t *__mutex,
     realmutex = (pthread_mutex_t *) value;
 
     if (value <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
-        realmutex = hybris_alloc_init_mutex(value);
-        *((int *)__mutex) = (int) realmutex;
+        realmutex = hybris_publish_mutex(__mutex, value);
     }
 
     clock_gettime(CLOCK_REALTIME, &tv);
@@ -780,7 +862,7 @@ static int _hybris_hook_pthread_mutex_timedlock(pthread_mutex_t *__mutex,
         return 0;
     }
 
-    unsigned int value = (*(unsigned int *) __mutex);
+    unsigned int value = hybris_load_value(__mutex);
     if (hybris_check_android_shared_mutex(value)) {
         LOGD("Shared mutex with Android, not lock timeout np.");
         return 0;
@@ -788,8 +870,7 @@ static int _hybris_hook_pthread_mutex_timedlock(pthread_mutex_t *__mutex,
 
     pthread_mutex_t *realmutex = (pthread_mutex_t *) value;
     if (value <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
-        realmutex = hybris_alloc_init_mutex(value);
-        *((int *)__mutex) = (int) realmutex;
+        realmutex = hybris_publish_mutex(__mutex, value);
     }
 
     return pthread_mutex_timedlock(realmutex, __abs_timeout);
@@ -824,8 +905,8 @@ static int _hybris_hook_pthread_cond_init(pthread_cond_t *cond,
         pthread_condattr_getpshared(attr, &pshared);
 
     if (!pshared) {
-        /* non shared, standard cond: use malloc */
-        realcond = malloc(sizeof(pthread_cond_t));
+        /* non shared, standard cond: use the object pool */
+        realcond = hybris_pool_alloc(HYBRIS_POOL_COND);
 
         *((unsigned int *) cond) = (unsigned int) realcond;
     }
@@ -835,8 +916,10 @@ static int _hybris_hook_pthread_cond_init(pthread_cond_t *cond,
 
         *((unsigned int *)cond) = (unsigned int) handle;
 
-        if (handle)
-            realcond = (pthread_cond_t *)hybris_get_shmpointer(handle);
+        if (!handle)
+            return ENOMEM;
+
+        realcond = (pthread_cond_t *)hybris_get_shmpointer(handle);
     }
 
     return pthread_cond_init(realcond, attr);
@@ -855,11 +938,14 @@ static int _hybris_hook_pthread_cond_destroy(pthread_cond_t *cond)
 
     if (!hybris_is_pointer_in_shm((void*)realcond)) {
         ret = pthread_cond_destroy(realcond);
-        free(realcond);
+        hybris_pool_free(HYBRIS_POOL_COND, realcond);
     }
     else {
-        realcond = (pthread_cond_t *)hybris_get_shmpointer((hybris_shm_pointer_t)realcond);
+        hybris_shm_pointer_t handle = (hybris_shm_pointer_t)realcond;
+
+        realcond = (pthread_cond_t *)hybris_get_shmpointer(handle);
         ret = pthread_cond_destroy(realcond);
+        hybris_shm_free(handle, sizeof(pthread_cond_t));
     }
 
     *((unsigned int *)cond) = 0;
@@ -869,7 +955,7 @@ static int _hybris_hook_pthread_cond_destroy(pthread_cond_t *cond)
 
 static int _hybris_hook_pthread_cond_broadcast(pthread_cond_t *cond)
 {
-    unsigned int value = (*(unsigned int *) cond);
+    unsigned int value = hybris_load_value(cond);
 
     TRACE_HOOK("cond %p", cond);
 
@@ -883,8 +969,7 @@ static int _hybris_hook_pthread_cond_broadcast(pthread_cond_t *cond)
         realcond = (pthread_cond_t *)hybris_get_shmpointer((hybris_shm_pointer_t)value);
 
     if (value <= ANDROID_TOP_ADDR_VALUE_COND) {
-        realcond = hybris_alloc_init_cond();
-        *((unsigned int *) cond) = (unsigned int) realcond;
+        realcond = hybris_publish_cond(cond, value);
     }
 
     return pthread_cond_broadcast(realcond);
@@ -892,7 +977,7 @@ static int _hybris_hook_pthread_cond_broadcast(pthread_cond_t *cond)
 
 static int _hybris_hook_pthread_cond_signal(pthread_cond_t *cond)
 {
-    unsigned int value = (*(unsigned int *) cond);
+    unsigned int value = hybris_load_value(cond);
 
     TRACE_HOOK("cond %p", cond);
 
@@ -906,8 +991,7 @@ static int _hybris_hook_pthread_cond_signal(pthread_cond_t *cond)
         realcond = (pthread_cond_t *)hybris_get_shmpointer((hybris_shm_pointer_t)value);
 
     if (value <= ANDROID_TOP_ADDR_VALUE_COND) {
-        realcond = hybris_alloc_init_cond();
-        *((unsigned int *) cond) = (unsigned int) realcond;
+        realcond = hybris_publish_cond(cond, value);
     }
 
     return pthread_cond_signal(realcond);
@@ -916,8 +1000,8 @@ static int _hybris_hook_pthread_cond_signal(pthread_cond_t *cond)
 static int _hybris_hook_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
 {
     /* Both cond and mutex can be statically initialized, check for both */
-    unsigned int cvalue = (*(unsigned int *) cond);
-    unsigned int mvalue = (*(unsigned int *) mutex);
+    unsigned int cvalue = hybris_load_value(cond);
+    unsigned int mvalue = hybris_load_value(mutex);
 
     TRACE_HOOK("cond %p mutex %p", cond, mutex);
 
@@ -932,8 +1016,7 @@ static int _hybris_hook_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t
         realcond = (pthread_cond_t *)hybris_get_shmpointer((hybris_shm_pointer_t)cvalue);
 
     if (cvalue <= ANDROID_TOP_ADDR_VALUE_COND) {
-        realcond = hybris_alloc_init_cond();
-        *((unsigned int *) cond) = (unsigned int) realcond;
+        realcond = hybris_publish_cond(cond, cvalue);
     }
 
     pthread_mutex_t *realmutex = (pthread_mutex_t *) mvalue;
@@ -941,8 +1024,7 @@ static int _hybris_hook_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t
         realmutex = (pthread_mutex_t *)hybris_get_shmpointer((hybris_shm_pointer_t)mvalue);
 
     if (mvalue <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
-        realmutex = hybris_alloc_init_mutex(mvalue);
-        *((unsigned int *) mutex) = (unsigned int) realmutex;
+        realmutex = hybris_publish_mutex(mutex, mvalue);
     }
 
     return pthread_cond_wait(realcond, realmutex);
@@ -952,8 +1034,8 @@ static int _hybris_hook_pthread_cond_timedwait(pthread_cond_t *cond,
                 pthread_mutex_t *mutex, const struct timespec *abstime)
 {
     /* Both cond and mutex can be statically initialized, check for both */
-    unsigned int cvalue = (*(unsigned int *) cond);
-    unsigned int mvalue = (*(unsigned int *) mutex);
+    unsigned int cvalue = hybris_load_value(cond);
+    unsigned int mvalue = hybris_load_value(mutex);
 
     TRACE_HOOK("cond %p mutex %p abstime %p", cond, mutex, abstime);
 
@@ -968,8 +1050,7 @@ static int _hybris_hook_pthread_cond_timedwait(pthread_cond_t *cond,
         realcond = (pthread_cond_t *)hybris_get_shmpointer((hybris_shm_pointer_t)cvalue);
 
     if (cvalue <= ANDROID_TOP_ADDR_VALUE_COND) {
-        realcond = hybris_alloc_init_cond();
-        *((unsigned int *) cond) = (unsigned int) realcond;
+        realcond = hybris_publish_cond(cond, cvalue);
     }
 
     pthread_mutex_t *realmutex = (pthread_mutex_t *) mvalue;
@@ -977,8 +1058,7 @@ static int _hybris_hook_pthread_cond_timedwait(pthread_cond_t *cond,
         realmutex = (pthread_mutex_t *)hybris_get_shmpointer((hybris_shm_pointer_t)mvalue);
 
     if (mvalue <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
-        realmutex = hybris_alloc_init_mutex(mvalue);
-        *((unsigned int *) mutex) = (unsigned int) realmutex;
+        realmutex = hybris_publish_mutex(mutex, mvalue);
     }
 
     return pthread_cond_timedwait(realcond, realmutex, abstime);
@@ -988,8 +1068,8 @@ static int _hybris_hook_pthread_cond_timedwait_relative_np(pthread_cond_t *cond,
                 pthread_mutex_t *mutex, const struct timespec *reltime)
 {
     /* Both cond and mutex can be statically initialized, check for both */
-    unsigned int cvalue = (*(unsigned int *) cond);
-    unsigned int mvalue = (*(unsigned int *) mutex);
+    unsigned int cvalue = hybris_load_value(cond);
+    unsigned int mvalue = hybris_load_value(mutex);
 
     TRACE_HOOK("cond %p mutex %p reltime %p", cond, mutex, reltime);
 
@@ -1004,8 +1084,7 @@ static int _hybris_hook_pthread_cond_timedwait_relative_np(pthread_cond_t *cond,
         realcond = (pthread_cond_t *)hybris_get_shmpointer((hybris_shm_pointer_t)cvalue);
 
     if (cvalue <= ANDROID_TOP_ADDR_VALUE_COND) {
-        realcond = hybris_alloc_init_cond();
-        *((unsigned int *) cond) = (unsigned int) realcond;
+        realcond = hybris_publish_cond(cond, cvalue);
     }
 
     pthread_mutex_t *realmutex = (pthread_mutex_t *) mvalue;
@@ -1013,8 +1092,7 @@ static int _hybris_hook_pthread_cond_timedwait_relative_np(pthread_cond_t *cond,
         realmutex = (pthread_mutex_t *)hybris_get_shmpointer((hybris_shm_pointer_t)mvalue);
 
     if (mvalue <= ANDROID_TOP_ADDR_VALUE_MUTEX) {
-        realmutex = hybris_alloc_init_mutex(mvalue);
-        *((unsigned int *) mutex) = (unsigned int) realmutex;
+        realmutex = hybris_publish_mutex(mutex, mvalue);
     }
 
     struct timespec tv;
@@ -1147,8 +1225,8 @@ static int _hybris_hook_pthread_rwlock_init(pthread_rwlock_t *__rwlock,
         pthread_rwlockattr_getpshared(realattr, &pshared);
 
     if (!pshared) {
-        /* non shared, standard rwlock: use malloc */
-        realrwlock = malloc(sizeof(pthread_rwlock_t));
+        /* non shared, standard rwlock: use the object pool */
+        realrwlock = hybris_pool_alloc(HYBRIS_POOL_RWLOCK);
 
         *((unsigned int *) __rwlock) = (unsigned int) realrwlock;
     }
@@ -1158,8 +1236,10 @@ static int _hybris_hook_pthread_rwlock_init(pthread_rwlock_t *__rwlock,
 
         *((unsigned int *)__rwlock) = (unsigned int) handle;
 
-        if (handle)
-            realrwlock = (pthread_rwlock_t *)hybris_get_shmpointer(handle);
+        if (!handle)
+            return ENOMEM;
+
+        realrwlock = (pthread_rwlock_t *)hybris_get_shmpointer(handle);
     }
 
     return pthread_rwlock_init(realrwlock, realattr);
@@ -1174,27 +1254,31 @@ static int _hybris_hook_pthread_rwlock_destroy(pthread_rwlock_t *__rwlock)
 
     if (!hybris_is_pointer_in_shm((void*)realrwlock)) {
         ret = pthread_rwlock_destroy(realrwlock);
-        free(realrwlock);
+        hybris_pool_free(HYBRIS_POOL_RWLOCK, realrwlock);
     }
     else {
+        hybris_shm_pointer_t handle = (hybris_shm_pointer_t)realrwlock;
+
+        realrwlock = (pthread_rwlock_t *)hybris_get_shmpointer(handle);
         ret = pthread_rwlock_destroy(realrwlock);
-        realrwlock = (pthread_rwlock_t *)hybris_get_shmpointer((hybris_shm_pointer_t)realrwlock);
+        hybris_shm_free(handle, sizeof(pthread_rwlock_t));
     }
 
+    *((unsigned int *)__rwlock) = 0;
+
     return ret;
 }
 
 static pthread_rwlock_t* hybris_set_realrwlock(pthread_rwlock_t *rwlock)
 {
-    unsigned int value = (*(unsigned int *) rwlock);
+    unsigned int value = hybris_load_value(rwlock);
     pthread_rwlock_t *realrwlock = (pthread_rwlock_t *) value;
 
     if (hybris_is_pointer_in_shm((void*)value))
         realrwlock = (pthread_rwlock_t *)hybris_get_shmpointer((hybris_shm_pointer_t)value);
 
-    if (realrwlock <= ANDROID_TOP_ADDR_VALUE_RWLOCK) {
-        realrwlock = hybris_alloc_init_rwlock();
-        *((unsigned int *)rwlock) = (unsigned int) realrwlock;
+    if (value <= ANDROID_TOP_ADDR_VALUE_RWLOCK) {
+        realrwlock = hybris_publish_rwlock(rwlock, value);
     }
     return realrwlock;
 }
@@ -1257,7 +1341,7 @@ static int _hybris_hook_pthread_rwlock_timedwrlock(pthread_rwlock_t *__rwlock,
 
 static int _hybris_hook_pthread_rwlock_unlock(pthread_rwlock_t *__rwlock)
 {
-    unsigned int value = (*(unsigned int *) __rwlock);
+    unsigned int value = hybris_load_value(__rwlock);
 
     TRACE_HOOK("rwlock %p", __rwlock);
 
@@ -1757,74 +1841,199 @@ struct bionic_dirent {
     char             d_name[256];
 };
 
-static struct bionic_dirent *_hybris_hook_readdir(DIR *dirp)
+/*
+ * Directory streams given to bionic code
+ *
+ * Like bionic does, entries are read with getdents64 into a buffer owned by
+ * the stream: its records already have the layout of a bionic_dirent, so
+ * readdir just returns a pointer to the next one, and a single syscall
+ * fetches many entries. As each stream has its own buffer, readdir on
+ * different streams can be used from different threads.
+ */
+#define HYBRIS_DIR_BUFFER_SIZE (32 * 1024)
+
+struct _hybris_dir {
+    int fd;
+    size_t available_bytes;
+    struct bionic_dirent *next;
+    long current_pos;
+    pthread_mutex_t mutex;
+    /* readdir_r may copy a whole bionic_dirent from the last record */
+    uint64_t buffer[(HYBRIS_DIR_BUFFER_SIZE + sizeof(struct bionic_dirent)) / sizeof(uint64_t)];
+};
+
+static struct _hybris_dir *_hybris_dir_create(int fd)
 {
-    /**
-     * readdir(3) manpage says:
-     *  The data returned by readdir() may be overwritten by subsequent calls
-     *  to readdir() for the same directory stream.
-     *
-     * XXX: At the moment, for us, the data will be overwritten even by
-     * subsequent calls to /different/ directory streams. Eventually fix that
-     * (e.g. by storing per-DIR * bionic_dirent structs, and removing them on
-     * closedir, requires hooking of all funcs returning/taking DIR *) and
-     * handling the additional data attachment there)
-     **/
+    struct _hybris_dir *dir = malloc(sizeof(struct _hybris_dir));
 
-    static struct bionic_dirent result;
+    if (!dir) {
+        errno = ENOMEM;
+        return NULL;
+    }
 
-    TRACE_HOOK("dirp %p", dirp);
+    dir->fd = fd;
+    dir->available_bytes = 0;
+    dir->next = NULL;
+    dir->current_pos = 0L;
+    pthread_mutex_init(&dir->mutex, NULL);
+
+    return dir;
+}
 
-    struct dirent *real_result = readdir(dirp);
-    if (!real_result) {
+static struct bionic_dirent *_hybris_dir_next(struct _hybris_dir *dir)
+{
+    if (dir->available_bytes == 0) {
+        long rc = syscall(SYS_getdents64, dir->fd, dir->buffer, HYBRIS_DIR_BUFFER_SIZE);
+        if (rc <= 0)
+            return NULL;
+
+        dir->available_bytes = rc;
+        dir->next = (struct bionic_dirent *) dir->buffer;
+    }
+
+    struct bionic_dirent *entry = dir->next;
+
+    dir->next = (struct bionic_dirent *) ((char *) entry + entry->d_reclen);
+    dir->available_bytes -= entry->d_reclen;
+    /* The value telldir returns is the one to seek to for the next entry */
+    dir->current_pos = entry->d_off;
+
+    return entry;
+}
+
+static void _hybris_dir_reset(struct _hybris_dir *dir, long offset)
+{
+    pthread_mutex_lock(&dir->mutex);
+
+    lseek(dir->fd, offset, SEEK_SET);
+    dir->available_bytes = 0;
+    dir->current_pos = offset;
+
+    pthread_mutex_unlock(&dir->mutex);
+}
+
+static DIR *_hybris_hook_opendir(const char *name)
+{
+    TRACE_HOOK("name '%s'", name);
+
+    int fd = open(name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    struct _hybris_dir *dir = _hybris_dir_create(fd);
+    if (!dir)
+        close(fd);
+
+    return (DIR *) dir;
+}
+
+static DIR *_hybris_hook_fdopendir(int fd)
+{
+    struct stat sb;
+
+    TRACE_HOOK("fd %d", fd);
+
+    if (fstat(fd, &sb) < 0)
         return NULL;
+
+    if (!S_ISDIR(sb.st_mode)) {
+        errno = ENOTDIR;
+        return NULL;
+    }
+
+    return (DIR *) _hybris_dir_create(fd);
+}
+
+static int _hybris_hook_closedir(DIR *dirp)
+{
+    struct _hybris_dir *dir = (struct _hybris_dir *) dirp;
+
+    TRACE_HOOK("dirp %p", dirp);
+
+    if (!dir) {
+        errno = EINVAL;
+        return -1;
     }
 
-    result.d_ino = real_result->d_ino;
-    result.d_off = real_result->d_off;
-    result.d_reclen = real_result->d_reclen;
-    result.d_type = real_result->d_type;
-    memcpy(result.d_name, real_result->d_name, sizeof(result.d_name));
+    int fd = dir->fd;
+
+    pthread_mutex_destroy(&dir->mutex);
+    free(dir);
 
-    // Make sure the string is zero-terminated, even if cut off (which
-    // shouldn't happen, as both bionic and glibc have d_name defined
-    // as fixed array of 256 chars)
-    result.d_name[sizeof(result.d_name)-1] = '\0';
-    return &result;
+    return close(fd);
 }
 
-static int _hybris_hook_readdir_r(DIR *dir, struct bionic_dirent *entry,
-        struct bionic_dirent **result)
+static struct bionic_dirent *_hybris_hook_readdir(DIR *dirp)
 {
-    struct dirent entry_r;
-    struct dirent *result_r;
+    struct _hybris_dir *dir = (struct _hybris_dir *) dirp;
+    struct bionic_dirent *entry;
 
-    TRACE_HOOK("dir %p entry %p result %p", dir, entry, result);
+    TRACE_HOOK("dirp %p", dirp);
 
-    int res = readdir_r(dir, &entry_r, &result_r);
+    /* readdir(3) only requires the returned data to stay valid until the
+     * next call on the same stream, which our per-stream buffer provides */
+    pthread_mutex_lock(&dir->mutex);
+    entry = _hybris_dir_next(dir);
+    pthread_mutex_unlock(&dir->mutex);
 
-    if (res == 0) {
-        if (result_r != NULL) {
-            *result = entry;
+    return entry;
+}
 
-            entry->d_ino = entry_r.d_ino;
-            entry->d_off = entry_r.d_off;
-            entry->d_reclen = entry_r.d_reclen;
-            entry->d_type = entry_r.d_type;
-            memcpy(entry->d_name, entry_r.d_name, sizeof(entry->d_name));
+static int _hybris_hook_readdir_r(DIR *dirp, struct bionic_dirent *entry,
+        struct bionic_dirent **result)
+{
+    struct _hybris_dir *dir = (struct _hybris_dir *) dirp;
+    int saved_errno = errno;
 
-            // Make sure the string is zero-terminated, even if cut off (which
-            // shouldn't happen, as both bionic and glibc have d_name defined
-            // as fixed array of 256 chars)
-            entry->d_name[sizeof(entry->d_name) - 1] = '\0';
-        } else {
-            *result = NULL;
-        }
+    TRACE_HOOK("dirp %p entry %p result %p", dirp, entry, result);
+
+    pthread_mutex_lock(&dir->mutex);
+
+    errno = 0;
+    struct bionic_dirent *next = _hybris_dir_next(dir);
+    int res = errno;
+
+    *result = NULL;
+    if (next != NULL) {
+        memcpy(entry, next, next->d_reclen < sizeof(struct bionic_dirent) ?
+                            next->d_reclen : sizeof(struct bionic_dirent));
+        *result = entry;
     }
 
+    pthread_mutex_unlock(&dir->mutex);
+
+    errno = saved_errno;
     return res;
 }
 
+static void _hybris_hook_rewinddir(DIR *dirp)
+{
+    TRACE_HOOK("dirp %p", dirp);
+
+    _hybris_dir_reset((struct _hybris_dir *) dirp, 0L);
+}
+
+static void _hybris_hook_seekdir(DIR *dirp, long offset)
+{
+    TRACE_HOOK("dirp %p offset %ld", dirp, offset);
+
+    _hybris_dir_reset((struct _hybris_dir *) dirp, offset);
+}
+
+static long _hybris_hook_telldir(DIR *dirp)
+{
+    TRACE_HOOK("dirp %p", dirp);
+
+    return ((struct _hybris_dir *) dirp)->current_pos;
+}
+
+static int _hybris_hook_dirfd(DIR *dirp)
+{
+    TRACE_HOOK("dirp %p", dirp);
+
+    return ((struct _hybris_dir *) dirp)->fd;
+}
+
 static int _hybris_hook_alphasort(struct bionic_dirent **a,
                                   struct bionic_dirent **b)
 {
@@ -2466,7 +2675,11 @@ static struct _hook hooks_common[] = {
     HOOK_INDIRECT(__system_property_get),
     HOOK_DIRECT(getenv),
     HOOK_DIRECT_NO_DEBUG(printf),
+#ifdef WANT_ADRENO_QUIRKS
     HOOK_INDIRECT(malloc),
+#else
+    HOOK_DIRECT(malloc),
+#endif
     HOOK_DIRECT_NO_DEBUG(free),
     HOOK_DIRECT_NO_DEBUG(calloc),
     HOOK_DIRECT_NO_DEBUG(cfree),
@@ -2482,7 +2695,7 @@ static struct _hook hooks_common[] = {
     HOOK_DIRECT_NO_DEBUG(memchr),
     HOOK_DIRECT_NO_DEBUG(memrchr),
     HOOK_DIRECT(memcmp),
-    HOOK_INDIRECT(memcpy),
+    HOOK_QUIRK(memcpy),
     HOOK_DIRECT_NO_DEBUG(memmove),
     HOOK_DIRECT_NO_DEBUG(memset),
     HOOK_DIRECT_NO_DEBUG(memmem),
@@ -2492,8 +2705,8 @@ static struct _hook hooks_common[] = {
     HOOK_DIRECT_NO_DEBUG(rindex),
     HOOK_DIRECT_NO_DEBUG(strchr),
     HOOK_DIRECT_NO_DEBUG(strrchr),
-    HOOK_INDIRECT(strlen),
-    HOOK_INDIRECT(strcmp),
+    HOOK_QUIRK(strlen),
+    HOOK_QUIRK(strcmp),
     HOOK_DIRECT_NO_DEBUG(strcpy),
     HOOK_DIRECT_NO_DEBUG(strcat),
     HOOK_DIRECT_NO_DEBUG(strcasecmp),
@@ -2683,15 +2896,15 @@ static struct _hook hooks_common[] = {
     HOOK_INDIRECT(dladdr),
     HOOK_INDIRECT(dlclose),
     /* dirent.h */
-    HOOK_DIRECT_NO_DEBUG(opendir),
-    HOOK_DIRECT_NO_DEBUG(fdopendir),
-    HOOK_DIRECT_NO_DEBUG(closedir),
+    HOOK_INDIRECT(opendir),
+    HOOK_INDIRECT(fdopendir),
+    HOOK_INDIRECT(closedir),
     HOOK_INDIRECT(readdir),
     HOOK_INDIRECT(readdir_r),
-    HOOK_DIRECT_NO_DEBUG(rewinddir),
-    HOOK_DIRECT_NO_DEBUG(seekdir),
-    HOOK_DIRECT_NO_DEBUG(telldir),
-    HOOK_DIRECT_NO_DEBUG(dirfd),
+    HOOK_INDIRECT(rewinddir),
+    HOOK_INDIRECT(seekdir),
+    HOOK_INDIRECT(telldir),
+    HOOK_INDIRECT(dirfd),
     HOOK_INDIRECT(scandir),
     HOOK_INDIRECT(scandirat),
     HOOK_INDIRECT(alphasort),
@@ -2842,14 +3055,13 @@ static struct _hook hooks_mm[] = {
 };
 
 
-static int hook_cmp(const void *a, const void *b)
-{
-    return strcmp(((struct _hook*)a)->name, ((struct _hook*)b)->name);
-}
-
 void hybris_set_hook_callback(hybris_hook_cb callback)
 {
     hook_callback = callback;
+
+    /* The linker caches the hooks it was given */
+    if (_android_linker_hook_callback_changed)
+        _android_linker_hook_callback_changed(callback != NULL);
 }
 
 static int get_android_sdk_version()
@@ -2896,13 +3108,98 @@ static int get_android_sdk_version()
 #define HOOKS_SIZE(hooks) \
     (sizeof(hooks) / sizeof(hooks[0]))
 
+/*
+ * Hook lookup table
+ *
+ * Both hook arrays are merged into a single open addressing table keyed
+ * by the GNU hash of the symbol name, so resolving a relocation costs one
+ * hash plus (in nearly all cases) one string compare. The table has a fixed
+ * size which is checked against the hook arrays at compile time, and is
+ * filled once on first use: which hooks win depends on the SDK version and
+ * on whether tracing was requested, neither of which change afterwards.
+ */
+#define HOOK_TABLE_SIZE 1024
+#define HOOK_TABLE_MASK (HOOK_TABLE_SIZE - 1)
+
+/* Keep the load factor below 50% so probe sequences stay short */
+typedef char hook_table_size_check[
+    (HOOK_TABLE_SIZE >= 2 * (HOOKS_SIZE(hooks_common) + HOOKS_SIZE(hooks_mm))) ? 1 : -1];
+
+struct _hook_entry {
+    uint32_t hash;
+    const char *name;
+    void *func;
+};
+
+static struct _hook_entry hook_table[HOOK_TABLE_SIZE];
+static pthread_once_t hook_table_once = PTHREAD_ONCE_INIT;
+
+static uint32_t hook_gnu_hash(const char *name)
+{
+    const unsigned char *p = (const unsigned char *) name;
+    uint32_t h = 5381;
+
+    while (*p != 0)
+        h += (h << 5) + *p++; /* h*33 + c */
+
+    return h;
+}
+
+static void hook_table_add(struct _hook *hooks, size_t count, int trace)
+{
+    size_t n;
+
+    for (n = 0; n < count; n++) {
+        uint32_t hash = hook_gnu_hash(hooks[n].name);
+        uint32_t i = hash & HOOK_TABLE_MASK;
+
+        while (hook_table[i].name) {
+            /* The first hook registered for a symbol wins */
+            if (hook_table[i].hash == hash &&
+                strcmp(hook_table[i].name, hooks[n].name) == 0)
+                break;
+            i = (i + 1) & HOOK_TABLE_MASK;
+        }
+
+        if (hook_table[i].name)
+            continue;
+
+        hook_table[i].hash = hash;
+        hook_table[i].name = hooks[n].name;
+        hook_table[i].func = trace ? hooks[n].debug_func : hooks[n].func;
+    }
+}
+
+static void hook_table_init(void)
+{
+    int trace = hybris_should_trace(NULL, NULL);
+
+    /* Allow newer hooks to override those which are available for all versions */
+#if defined(WANT_LINKER_N) || defined(WANT_LINKER_MM)
+    if (get_android_sdk_version() > 21)
+        hook_table_add(hooks_mm, HOOKS_SIZE(hooks_mm), trace);
+#endif
+    hook_table_add(hooks_common, HOOKS_SIZE(hooks_common), trace);
+}
+
+static void *hook_table_lookup(const char *sym)
+{
+    uint32_t hash = hook_gnu_hash(sym);
+    uint32_t i = hash & HOOK_TABLE_MASK;
+
+    while (hook_table[i].name) {
+        if (hook_table[i].hash == hash && strcmp(hook_table[i].name, sym) == 0)
+            return hook_table[i].func;
+        i = (i + 1) & HOOK_TABLE_MASK;
+    }
+
+    return NULL;
+}
 
 static void* __hybris_get_hooked_symbol(const char *sym, const char *requester)
 {
-    static int sorted = 0;
     static int counter = -1;
     void *found = NULL;
-    struct _hook key;
 
     /* First check if we have a callback registered which could
      * give us a context specific hook implementation */
@@ -2913,33 +3210,11 @@ static void* __hybris_get_hooked_symbol(const char *sym, const char *requester)
             return (void*) found;
     }
 
-    if (!sorted)
-    {
-        qsort(hooks_common, HOOKS_SIZE(hooks_common), sizeof(hooks_common[0]), hook_cmp);
-        qsort(hooks_mm, HOOKS_SIZE(hooks_mm), sizeof(hooks_mm[0]), hook_cmp);
-        sorted = 1;
-    }
-
-    /* Allow newer hooks to override those which are available for all versions */
-    key.name = sym;
-#if defined(WANT_LINKER_N)
-    if (get_android_sdk_version() > 21)
-        found = bsearch(&key, hooks_mm, HOOKS_SIZE(hooks_mm), sizeof(hooks_mm[0]), hook_cmp);
-#endif
-#if defined(WANT_LINKER_MM)
-    if (get_android_sdk_version() > 21)
-        found = bsearch(&key, hooks_mm, HOOKS_SIZE(hooks_mm), sizeof(hooks_mm[0]), hook_cmp);
-#endif
-    if (!found)
-        found = bsearch(&key, hooks_common, HOOKS_SIZE(hooks_common), sizeof(hooks_common[0]), hook_cmp);
+    pthread_once(&hook_table_once, hook_table_init);
 
+    found = hook_table_lookup(sym);
     if (found)
-    {
-        if(hybris_should_trace(NULL, NULL))
-            return ((struct _hook*) found)->debug_func;
-        else
-            return ((struct _hook*) found)->func;
-    }
+        return found;
 
     if (strncmp(sym, "pthread", 7) == 0 ||
         strncmp(sym, "__pthread", 9) == 0)
@@ -3032,11 +3307,14 @@ static void __hybris_linker_init()
     /* Load all necessary symbols we need from the linker */
     _android_linker_init = dlsym(linker_handle, "android_linker_init");
     _android_dlopen = dlsym(linker_handle, "android_dlopen");
+    _android_dlopen_ext = dlsym(linker_handle, "android_dlopen_ext");
     _android_dlsym = dlsym(linker_handle, "android_dlsym");
     _android_dlvsym = dlsym(linker_handle, "android_dlvsym");
     _android_dladdr = dlsym(linker_handle, "android_dladdr");
     _android_dlclose = dlsym(linker_handle, "android_dlclose");
     _android_dlerror = dlsym(linker_handle, "android_dlerror");
+    /* Not in the jb linker, which doesn't cache hooks */
+    _android_linker_hook_callback_changed = dlsym(linker_handle, "android_linker_hook_callback_changed");
 
     /* Now its time to setup the linker itself */
 #ifdef WANT_ARM_TRACING
@@ -3045,6 +3323,9 @@ static void __hybris_linker_init()
     _android_linker_init(sdk_version, __hybris_get_hooked_symbol);
 #endif
 
+    if (hook_callback && _android_linker_hook_callback_changed)
+        _android_linker_hook_callback_changed(1);
+
     linker_initialized = 1;
 }
 
@@ -3066,6 +3347,16 @@ void *android_dlopen(const char *filename, int flag)
     return _android_dlopen(filename,flag);
 }
 
+void *android_dlopen_ext(const char *filename, int flag, const hybris_dlextinfo *extinfo)
+{
+    ENSURE_LINKER_IS_LOADED();
+
+    if (!_android_dlopen_ext)
+        return NULL;
+
+    return _android_dlopen_ext(filename, flag, extinfo);
+}
+
 void *android_dlsym(void *handle, const char *symbol)
 {
     ENSURE_LINKER_IS_LOADED();
@@ -3111,6 +3402,11 @@ void *hybris_dlopen(const char *filename, int flag)
     return android_dlopen(filename,flag);
 }
 
+void *hybris_dlopen_ext(const char *filename, int flag, const hybris_dlextinfo *extinfo)
+{
+    return android_dlopen_ext(filename, flag, extinfo);
+}
+
 void *hybris_dlsym(void *handle, const char *symbol)
 {
     return android_dlsym(handle,symbol);
@@ -3125,3 +3421,8 @@ const char *hybris_dlerror(void)
 {
     return android_dlerror();
 }
+
+void *hybris_get_hooked_symbol(const char *sym, const char *requester)
+{
+    return __hybris_get_hooked_symbol(sym, requester);
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "hooks_pool.h"
+
+#define _GNU_SOURCE
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* Debug */
+#include "logging.h"
+#define LOGD(message, ...) HYBRIS_DEBUG_LOG(HOOKS, message, ##__VA_ARGS__)
+
+#define HYBRIS_POOL_CACHE_LINE   64
+/* Number of objects carved out of a slab at once */
+#define HYBRIS_POOL_SLAB_OBJECTS 64
+/* Objects a thread keeps for itself before giving them back to the pool */
+#define HYBRIS_POOL_LOCAL_MAX    32
+
+#define ROUND_UP(x, align) (((x) + (align) - 1) & ~((align) - 1))
+
+/* A free object is linked into a free list through its first bytes */
+typedef struct _hybris_pool_object {
+    struct _hybris_pool_object *next;
+} hybris_pool_object_t;
+
+typedef struct _hybris_pool {
+    const char *name;
+    size_t object_size;
+    /* Objects given back by threads, or by threads which exited */
+    pthread_mutex_t lock;
+    hybris_pool_object_t *free_list;
+    int live;
+} hybris_pool_t;
+
+/* Per-thread free lists, to keep malloc and pool lock contention away */
+typedef struct _hybris_pool_cache {
+    hybris_pool_object_t *head;
+    int count;
+} hybris_pool_cache_t;
+
+static hybris_pool_t _hybris_pools[HYBRIS_POOL_TYPES] = {
+    { "mutex", ROUND_UP(sizeof(pthread_mutex_t), HYBRIS_POOL_CACHE_LINE),
+      PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+    { "cond", ROUND_UP(sizeof(pthread_cond_t), HYBRIS_POOL_CACHE_LINE),
+      PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+    { "rwlock", ROUND_UP(sizeof(pthread_rwlock_t), HYBRIS_POOL_CACHE_LINE),
+      PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+};
+
+static __thread hybris_pool_cache_t _hybris_pool_caches[HYBRIS_POOL_TYPES];
+
+/* Used to hand back the objects cached by a thread when it exits */
+static pthread_key_t _hybris_pool_key;
+static pthread_once_t _hybris_pool_once = PTHREAD_ONCE_INIT;
+static __thread int _hybris_pool_thread_registered = 0;
+
+/* forward-declare the internal static methods */
+static void _hybris_pool_release(hybris_pool_t *pool, hybris_pool_cache_t *cache, int count);
+
+/*
+ * Give all objects cached by an exiting thread back to the pools
+ */
+static void _hybris_pool_thread_exit(void *data)
+{
+    int type;
+
+    for (type = 0; type < HYBRIS_POOL_TYPES; type++) {
+        hybris_pool_cache_t *cache = &_hybris_pool_caches[type];
+        _hybris_pool_release(&_hybris_pools[type], cache, cache->count);
+    }
+}
+
+/*
+ * Log the objects which were never destroyed
+ */
+static void _hybris_pool_report(void)
+{
+    int type;
+
+    for (type = 0; type < HYBRIS_POOL_TYPES; type++) {
+        LOGD("%d %s objects still alive at exit", _hybris_pools[type].live,
+             _hybris_pools[type].name);
+    }
+}
+
+static void _hybris_pool_init(void)
+{
+    pthread_key_create(&_hybris_pool_key, _hybris_pool_thread_exit);
+    atexit(_hybris_pool_report);
+}
+
+/*
+ * Make sure the objects cached by the calling thread are handed back on exit
+ */
+static inline void _hybris_pool_register_thread(void)
+{
+    if (!_hybris_pool_thread_registered) {
+        pthread_once(&_hybris_pool_once, _hybris_pool_init);
+        /* Any non-NULL value, so that the destructor gets called */
+        pthread_setspecific(_hybris_pool_key, _hybris_pool_caches);
+        _hybris_pool_thread_registered = 1;
+    }
+}
+
+/*
+ * Move the first count objects of a thread's cache to the pool
+ */
+static void _hybris_pool_release(hybris_pool_t *pool, hybris_pool_cache_t *cache, int count)
+{
+    hybris_pool_object_t *first, *last;
+    int n;
+
+    if (count <= 0 || cache->head == NULL)
+        return;
+
+    first = last = cache->head;
+    for (n = 1; n < count && last->next; n++)
+        last = last->next;
+
+    cache->head = last->next;
+    cache->count -= n;
+
+    pthread_mutex_lock(&pool->lock);
+    last->next = pool->free_list;
+    pool->free_list = first;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Fill a thread's cache from the pool, or from a new slab if the pool is empty
+ */
+static void _hybris_pool_refill(hybris_pool_t *pool, hybris_pool_cache_t *cache)
+{
+    int n;
+
+    pthread_mutex_lock(&pool->lock);
+    for (n = 0; n < HYBRIS_POOL_LOCAL_MAX / 2 && pool->free_list; n++) {
+        hybris_pool_object_t *obj = pool->free_list;
+        pool->free_list = obj->next;
+        obj->next = cache->head;
+        cache->head = obj;
+        cache->count++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (cache->head)
+        return;
+
+    /* Slabs are never given back: they are reused for the next objects */
+    void *slab = NULL;
+    if (posix_memalign(&slab, HYBRIS_POOL_CACHE_LINE,
+                       pool->object_size * HYBRIS_POOL_SLAB_OBJECTS) != 0)
+        return;
+
+    LOGD("Allocated a new %s slab at %p", pool->name, slab);
+
+    for (n = HYBRIS_POOL_SLAB_OBJECTS - 1; n >= 0; n--) {
+        hybris_pool_object_t *obj =
+            (hybris_pool_object_t *) ((char *) slab + n * pool->object_size);
+        obj->next = cache->head;
+        cache->head = obj;
+        cache->count++;
+    }
+
+    /* Objects above the local limit go to the pool for other threads */
+    _hybris_pool_release(pool, cache, cache->count - HYBRIS_POOL_LOCAL_MAX);
+}
+
+/************ public functions *******************/
+
+void *hybris_pool_alloc(enum hybris_pool_type type)
+{
+    hybris_pool_t *pool = &_hybris_pools[type];
+    hybris_pool_cache_t *cache = &_hybris_pool_caches[type];
+    hybris_pool_object_t *obj;
+
+    _hybris_pool_register_thread();
+
+    if (cache->head == NULL)
+        _hybris_pool_refill(pool, cache);
+
+    obj = cache->head;
+    if (obj == NULL)
+        return NULL;
+
+    cache->head = obj->next;
+    cache->count--;
+
+    __atomic_add_fetch(&pool->live, 1, __ATOMIC_RELAXED);
+
+    return obj;
+}
+
+void hybris_pool_free(enum hybris_pool_type type, void *ptr)
+{
+    hybris_pool_t *pool = &_hybris_pools[type];
+    hybris_pool_cache_t *cache = &_hybris_pool_caches[type];
+    hybris_pool_object_t *obj = (hybris_pool_object_t *) ptr;
+
+    if (obj == NULL)
+        return;
+
+    _hybris_pool_register_thread();
+
+    __atomic_sub_fetch(&pool->live, 1, __ATOMIC_RELAXED);
+
+    obj->next = cache->head;
+    cache->head = obj;
+    cache->count++;
+
+    if (cache->count > HYBRIS_POOL_LOCAL_MAX)
+        _hybris_pool_release(pool, cache, HYBRIS_POOL_LOCAL_MAX / 2);
+}
+
+int hybris_pool_live_objects(enum hybris_pool_type type)
+{
+    return __atomic_load_n(&_hybris_pools[type].live, __ATOMIC_RELAXED);
+}
+
+// vim:ts=4:sw=4:noexpandtab
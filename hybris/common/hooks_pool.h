@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef HOOKS_POOL_H_
+#define HOOKS_POOL_H_
+
+#include <stddef.h>
+
+/* Types of glibc objects backing the translated bionic pthread objects */
+enum hybris_pool_type {
+    HYBRIS_POOL_MUTEX,
+    HYBRIS_POOL_COND,
+    HYBRIS_POOL_RWLOCK,
+    HYBRIS_POOL_TYPES
+};
+
+/*
+ * Allocate an object of the given type. Every object sits on its own
+ * cache line(s), so adjacent locks don't share them.
+ */
+void *hybris_pool_alloc(enum hybris_pool_type type);
+/*
+ * Give back an object allocated with hybris_pool_alloc
+ */
+void hybris_pool_free(enum hybris_pool_type type, void *obj);
+/*
+ * Number of objects of the given type which are currently allocated
+ */
+int hybris_pool_live_objects(enum hybris_pool_type type);
+
+#endif
+
+// vim:ts=4:sw=4:noexpandtab
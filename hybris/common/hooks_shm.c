@@ -23,6 +23,8 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <pthread.h>
@@ -35,35 +37,70 @@
 #include "logging.h"
 #define LOGD(message, ...) HYBRIS_DEBUG_LOG(HOOKS, message, ##__VA_ARGS__)
 
-#define HYBRIS_DATA_SIZE    4000
 #define HYBRIS_SHM_MASK     0xFF000000UL
 #define HYBRIS_SHM_PATH     "/hybris_shm_data"
 
+/* Upper bound of the size of the objects stored in the region */
+#define HYBRIS_SHM_MAX_OBJECT_SIZE 64
+
+/*
+ * The region grows by this many bytes at a time. This is a multiple of the
+ * page size: growing only costs an ftruncate, so there is no point in
+ * growing by less than a page.
+ */
+#define HYBRIS_SHM_GROW_SIZE (64 * 1024)
+
+/*
+ * Default size of the virtual address window reserved for the region, can
+ * be changed with HYBRIS_SHM_RESERVE (in bytes, or with a K/M suffix).
+ * 16MB are good for about 250000 process-shared objects.
+ */
+#define HYBRIS_SHM_DEFAULT_RESERVE (16 * 1024 * 1024)
+
+/*
+ * Objects are allocated in multiples of this size, and freed objects are
+ * kept in one free list per multiple, up to HYBRIS_SHM_MAX_OBJECT_SIZE.
+ */
+#define HYBRIS_SHM_SIZE_CLASS      8
+#define HYBRIS_SHM_SIZE_CLASSES    (HYBRIS_SHM_MAX_OBJECT_SIZE / HYBRIS_SHM_SIZE_CLASS)
+
 /* Structure of a shared memory region */
 typedef struct _hybris_shm_data_t {
     pthread_mutex_t access_mutex;
     int current_offset;
     int max_offset;
+    /*
+     * Heads of the free lists, as offset + 1 so that 0 means empty. The
+     * first int of a free object holds the next one, the same way.
+     */
+    int free_lists[HYBRIS_SHM_SIZE_CLASSES];
     unsigned char data;
 } hybris_shm_data_t;
 
 /* A helper to switch between the size of the data and the size of the shm object */
 const int HYBRIS_SHM_DATA_HEADER_SIZE = (sizeof(hybris_shm_data_t) - sizeof(unsigned char));
 
-/* pointer to the shared memory region */
+/*
+ * pointer to the shared memory region
+ *
+ * The whole reserved window is mapped once, when attaching to the region, so
+ * this never changes afterwards: growing the region in any process only makes
+ * more pages of the window backed by the shm object.
+ */
 static hybris_shm_data_t *_hybris_shm_data = NULL;
 
 /* the SHM mem_id of the shared memory region */
 static int _hybris_shm_fd = -1;
 
-/* the size of the shared memory region that is currently mmap'ed to this process */
-static int _current_mapped_size = 0;
+/* the size of the virtual address window mapped to this process */
+static size_t _hybris_shm_reserve = 0;
+
+static pthread_once_t _hybris_shm_once = PTHREAD_ONCE_INIT;
 
 /* forward-declare the internal static methods */
 static void _release_shm(void);
-static void _sync_mmap_with_shm(void);
 static void _hybris_shm_init(void);
-static void _hybris_shm_extend_region(void);
+static int _hybris_shm_extend_region(void);
 
 /*
  * Detach the allocated memory region, and mark it for deletion
@@ -71,7 +108,7 @@ static void _hybris_shm_extend_region(void);
 static void _release_shm(void)
 {
     if (_hybris_shm_data) {
-        munmap(_hybris_shm_data, _current_mapped_size); /* unmap from this process */
+        munmap(_hybris_shm_data, _hybris_shm_reserve); /* unmap from this process */
         _hybris_shm_data = NULL; /* pointer is no more valid */
     }
     if (_hybris_shm_fd >= 0) {
@@ -81,23 +118,60 @@ static void _release_shm(void)
     shm_unlink(HYBRIS_SHM_PATH);  /* request the deletion of the shm region */
 }
 
+static size_t _round_to_page(size_t size)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+
 /*
- * Synchronize the size of the mmap with the size of the shm region
+ * Size of the address window to reserve, from HYBRIS_SHM_RESERVE
  */
-static void _sync_mmap_with_shm()
+static size_t _hybris_shm_reserve_size(void)
 {
-    if (_hybris_shm_fd >= 0 && _hybris_shm_data) {
-        if (_current_mapped_size < _hybris_shm_data->max_offset + HYBRIS_SHM_DATA_HEADER_SIZE) {
-            /* Note that mremap may change the address pointed by _hybris_shm_data.
-             * But as we never point directly into _hybris_shm_data, it's fine.
-             * */
-            _hybris_shm_data = (hybris_shm_data_t *)mremap( _hybris_shm_data, _current_mapped_size,
-                                  _hybris_shm_data->max_offset + HYBRIS_SHM_DATA_HEADER_SIZE,
-                                  MREMAP_MAYMOVE );
-
-            _current_mapped_size = _hybris_shm_data->max_offset + HYBRIS_SHM_DATA_HEADER_SIZE;
-        }
+    const char *env = getenv("HYBRIS_SHM_RESERVE");
+    size_t size = HYBRIS_SHM_DEFAULT_RESERVE;
+
+    if (env && *env) {
+        char *end;
+        unsigned long value = strtoul(env, &end, 0);
+
+        if (*end == 'k' || *end == 'K')
+            value *= 1024;
+        else if (*end == 'm' || *end == 'M')
+            value *= 1024 * 1024;
+
+        size = value;
     }
+
+    /* handles can't address more than this anyway */
+    if (size > HYBRIS_SHM_MASK_TOP - HYBRIS_SHM_MASK)
+        size = HYBRIS_SHM_MASK_TOP - HYBRIS_SHM_MASK;
+    if (size < HYBRIS_SHM_GROW_SIZE)
+        size = HYBRIS_SHM_GROW_SIZE;
+
+    return _round_to_page(size);
+}
+
+/*
+ * Map the whole reserved window over the shm object. Only the part below the
+ * current size of the object is ever touched, so it doesn't matter that the
+ * rest lies beyond its end: it becomes usable as soon as the object grows.
+ */
+static int _hybris_shm_map(void)
+{
+    void *data = mmap(NULL, _hybris_shm_reserve, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_NORESERVE, _hybris_shm_fd, 0);
+
+    if (data == MAP_FAILED) {
+        HYBRIS_ERROR_LOG(HOOKS, "ERROR: mmap of %zu bytes failed: %s\n",
+                         _hybris_shm_reserve, strerror(errno));
+        return -1;
+    }
+
+    _hybris_shm_data = (hybris_shm_data_t *) data;
+    return 0;
 }
 
 /*
@@ -106,67 +180,73 @@ static void _sync_mmap_with_shm()
  */
 static void _hybris_shm_init()
 {
-    if (_hybris_shm_fd < 0) {
-        const size_t size_to_map = HYBRIS_SHM_DATA_HEADER_SIZE + HYBRIS_DATA_SIZE; /* 4000 bytes for the data, plus the header size */
+    _hybris_shm_reserve = _hybris_shm_reserve_size();
 
-        /* initialize or get shared memory segment */
-        _hybris_shm_fd = shm_open(HYBRIS_SHM_PATH, O_RDWR, 0660);
+    /* initialize or get shared memory segment */
+    _hybris_shm_fd = shm_open(HYBRIS_SHM_PATH, O_RDWR, 0660);
+    if (_hybris_shm_fd >= 0) {
+        if (_hybris_shm_map() < 0) {
+            close(_hybris_shm_fd);
+            _hybris_shm_fd = -1;
+        }
+    }
+    else {
+        LOGD("Creating a new shared memory segment.");
+
+        mode_t pumask = umask(0);
+        _hybris_shm_fd = shm_open(HYBRIS_SHM_PATH, O_RDWR | O_CREAT, 0666);
+        umask(pumask);
         if (_hybris_shm_fd >= 0) {
+            ftruncate( _hybris_shm_fd, HYBRIS_SHM_GROW_SIZE );
             /* Map the memory object */
-            _hybris_shm_data = (hybris_shm_data_t *)mmap( NULL, size_to_map,
-                                             PROT_READ | PROT_WRITE, MAP_SHARED,
-                                             _hybris_shm_fd, 0 );
-            _current_mapped_size = size_to_map;
-
-            _sync_mmap_with_shm();
-        }
-        else {
-            LOGD("Creating a new shared memory segment.");
-
-            mode_t pumask = umask(0);
-            _hybris_shm_fd = shm_open(HYBRIS_SHM_PATH, O_RDWR | O_CREAT, 0666);
-            umask(pumask);
-            if (_hybris_shm_fd >= 0) {
-                ftruncate( _hybris_shm_fd, size_to_map );
-                /* Map the memory object */
-                _hybris_shm_data = (hybris_shm_data_t *)mmap( NULL, size_to_map,
-                                             PROT_READ | PROT_WRITE, MAP_SHARED,
-                                             _hybris_shm_fd, 0 );
-                if (_hybris_shm_data == MAP_FAILED) {
-                    HYBRIS_ERROR_LOG(HOOKS, "ERROR: mmap failed: %s\n", strerror(errno));
-                    _release_shm();
-                }
-                else {
-                    _current_mapped_size = size_to_map;
-                    /* Initialize the memory object */
-                    memset((void*)_hybris_shm_data, 0, size_to_map);
-                    _hybris_shm_data->max_offset = HYBRIS_DATA_SIZE;
-
-                    pthread_mutexattr_t attr;
-                    pthread_mutexattr_init(&attr);
-                    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
-                    pthread_mutex_init(&_hybris_shm_data->access_mutex, &attr);
-                    pthread_mutexattr_destroy(&attr);
-
-                    atexit(_release_shm);
-                }
+            if (_hybris_shm_map() < 0) {
+                _release_shm();
             }
             else {
-                HYBRIS_ERROR_LOG(HOOKS, "ERROR: Couldn't create shared memory segment !");
+                /* Initialize the memory object */
+                memset((void*)_hybris_shm_data, 0, HYBRIS_SHM_DATA_HEADER_SIZE);
+                _hybris_shm_data->max_offset = HYBRIS_SHM_GROW_SIZE - HYBRIS_SHM_DATA_HEADER_SIZE;
+
+                pthread_mutexattr_t attr;
+                pthread_mutexattr_init(&attr);
+                pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+                pthread_mutex_init(&_hybris_shm_data->access_mutex, &attr);
+                pthread_mutexattr_destroy(&attr);
+
+                atexit(_release_shm);
             }
         }
+        else {
+            HYBRIS_ERROR_LOG(HOOKS, "ERROR: Couldn't create shared memory segment !");
+        }
     }
+
+    LOGD("Reserved %zu bytes for the shared memory region", _hybris_shm_reserve);
 }
 
 /*
- * Extend the SHM region's size
+ * Extend the SHM region's size, in place: the new pages are already part of
+ * the window every process has mapped.
+ * Must be called with the access_mutex of the region held.
  */
-static void _hybris_shm_extend_region()
+static int _hybris_shm_extend_region()
 {
-    ftruncate( _hybris_shm_fd, _current_mapped_size + HYBRIS_DATA_SIZE );
-    _hybris_shm_data->max_offset += HYBRIS_DATA_SIZE;
+    size_t size = _round_to_page(_hybris_shm_data->max_offset + HYBRIS_SHM_DATA_HEADER_SIZE +
+                                 HYBRIS_SHM_GROW_SIZE);
+
+    if (size > _hybris_shm_reserve) {
+        HYBRIS_ERROR_LOG(HOOKS, "ERROR: shared memory region is full (%zu bytes reserved), "
+                         "consider raising HYBRIS_SHM_RESERVE\n", _hybris_shm_reserve);
+        return -1;
+    }
+
+    if (ftruncate( _hybris_shm_fd, size ) < 0) {
+        HYBRIS_ERROR_LOG(HOOKS, "ERROR: ftruncate failed: %s\n", strerror(errno));
+        return -1;
+    }
 
-    _sync_mmap_with_shm();
+    _hybris_shm_data->max_offset = size - HYBRIS_SHM_DATA_HEADER_SIZE;
+    return 0;
 }
 
 /************ public functions *******************/
@@ -187,33 +267,31 @@ int hybris_is_pointer_in_shm(void *ptr)
 /*
  * Convert this offset pointer to the shared memory to an
  * absolute pointer that can be used in user space
+ *
+ * This is called for every operation on a process-shared lock: as the
+ * mapping never moves, the translation is a plain addition.
  */
 void *hybris_get_shmpointer(hybris_shm_pointer_t handle)
 {
-    void *realpointer = NULL;
-    if (hybris_is_pointer_in_shm((void*)handle)) {
-        if (_hybris_shm_fd < 0) {
-            /* if we are not yet attached to any shm region, then do it now */
-            _hybris_shm_init();
-        }
+    if (!hybris_is_pointer_in_shm((void*)handle))
+        return NULL;
 
-        pthread_mutex_lock(&_hybris_shm_data->access_mutex);
+    pthread_once(&_hybris_shm_once, _hybris_shm_init);
 
-        _sync_mmap_with_shm();  /* make sure our mmap is sync'ed */
+    if (_hybris_shm_data == NULL)
+        return NULL;
 
-        if (_hybris_shm_data != NULL) {
-            unsigned int offset = handle & (~HYBRIS_SHM_MASK);
-            realpointer = &(_hybris_shm_data->data) + offset;
+    unsigned int offset = handle & (~HYBRIS_SHM_MASK);
 
-            /* Be careful when activating this trace: this method is called *a lot* !
-            LOGD("handle = %x, offset  = %d, realpointer = %x)", handle, offset, realpointer);
-             */
-        }
+    /* The handle was allocated by a process with a larger window than ours */
+    if (offset + HYBRIS_SHM_MAX_OBJECT_SIZE + HYBRIS_SHM_DATA_HEADER_SIZE > _hybris_shm_reserve)
+        return NULL;
 
-        pthread_mutex_unlock(&_hybris_shm_data->access_mutex);
-    }
+    /* Be careful when activating this trace: this method is called *a lot* !
+    LOGD("handle = %x, offset  = %d, realpointer = %x)", handle, offset, &(_hybris_shm_data->data) + offset);
+     */
 
-    return realpointer;
+    return &(_hybris_shm_data->data) + offset;
 }
 
 /*
@@ -222,24 +300,35 @@ void *hybris_get_shmpointer(hybris_shm_pointer_t handle)
 hybris_shm_pointer_t hybris_shm_alloc(size_t size)
 {
     hybris_shm_pointer_t location = 0;
+    int *free_list = NULL;
 
-    if (_hybris_shm_fd < 0) {
-        /* if we are not yet attached to any shm region, then do it now */
-        _hybris_shm_init();
-    }
+    pthread_once(&_hybris_shm_once, _hybris_shm_init);
+
+    if (_hybris_shm_data == NULL || size == 0)
+        return 0;
+
+    size = (size + HYBRIS_SHM_SIZE_CLASS - 1) & ~(HYBRIS_SHM_SIZE_CLASS - 1);
 
     pthread_mutex_lock(&_hybris_shm_data->access_mutex);
 
-    /* Make sure our mmap is sync'ed */
-    _sync_mmap_with_shm();
+    if (size <= HYBRIS_SHM_MAX_OBJECT_SIZE) {
+        free_list = &_hybris_shm_data->free_lists[size / HYBRIS_SHM_SIZE_CLASS - 1];
 
-    if (_hybris_shm_data == NULL || _hybris_shm_fd < 0)
-        return 0;
+        if (*free_list) {
+            /* reuse an object that was freed, possibly by another process */
+            int offset = *free_list - 1;
 
-    if (_hybris_shm_data->current_offset + size >= _hybris_shm_data->max_offset) {
-        /* the current buffer if full: extend it a little bit more */
-        _hybris_shm_extend_region();
-        _sync_mmap_with_shm();
+            *free_list = *(int *) (&_hybris_shm_data->data + offset);
+            location = offset | HYBRIS_SHM_MASK;
+            LOGD("Reused a shared object (size = %zu, at offset %d)", size, offset);
+            goto out;
+        }
+    }
+
+    while (_hybris_shm_data->current_offset + size >= _hybris_shm_data->max_offset) {
+        /* the current buffer if full: extend it */
+        if (_hybris_shm_extend_region() < 0)
+            goto out;
     }
 
     /* there is now enough place in this pool */
@@ -248,7 +337,39 @@ hybris_shm_pointer_t hybris_shm_alloc(size_t size)
 
     _hybris_shm_data->current_offset += size;
 
+out:
     pthread_mutex_unlock(&_hybris_shm_data->access_mutex);
 
     return location;
 }
+
+/*
+ * Give back a space allocated with hybris_shm_alloc, with the same size
+ */
+void hybris_shm_free(hybris_shm_pointer_t handle, size_t size)
+{
+    if (!hybris_is_pointer_in_shm((void*)handle) || size == 0)
+        return;
+
+    size = (size + HYBRIS_SHM_SIZE_CLASS - 1) & ~(HYBRIS_SHM_SIZE_CLASS - 1);
+
+    /* larger objects are never reused */
+    if (size > HYBRIS_SHM_MAX_OBJECT_SIZE)
+        return;
+
+    int *object = (int *) hybris_get_shmpointer(handle);
+    if (object == NULL)
+        return;
+
+    int offset = handle & (~HYBRIS_SHM_MASK);
+    int *free_list = &_hybris_shm_data->free_lists[size / HYBRIS_SHM_SIZE_CLASS - 1];
+
+    pthread_mutex_lock(&_hybris_shm_data->access_mutex);
+
+    *object = *free_list;
+    *free_list = offset + 1;
+
+    pthread_mutex_unlock(&_hybris_shm_data->access_mutex);
+
+    LOGD("Freed a shared object (size = %zu, at offset %d)", size, offset);
+}
@@ -29,6 +29,11 @@ typedef unsigned int hybris_shm_pointer_t;
  * Allocate a space in the shared memory region of hybris
  */
 hybris_shm_pointer_t hybris_shm_alloc(size_t size);
+/*
+ * Give back a space allocated in the shared memory region, so that it can be
+ * reused by any process. size must be the size it was allocated with.
+ */
+void hybris_shm_free(hybris_shm_pointer_t handle, size_t size);
 /* 
  * Test if the pointers points to the shm region
  */
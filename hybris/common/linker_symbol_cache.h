@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __LINKER_SYMBOL_CACHE_H
+#define __LINKER_SYMBOL_CACHE_H
+
+// Shared by the mm and n linkers. Their linker.cpp include it after their
+// linker.h and linker_debug.h, for soinfo, soinfo_do_lookup() and INFO().
+
+#include <string.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Process-wide memoization of symbol resolution.
+//
+// The same symbols (pthread_*, malloc, ...) get resolved over and over again
+// for every library of a dependency tree. Results are keyed by symbol name
+// and version plus a scope: the local group root of the requester for
+// symbols found in the local group, or nullptr for symbols found in the
+// global group, which resolve the same way for every library. Hook results
+// only depend on the symbol name, unless a hook callback is set: the callback
+// is given the path of the requester, so its results are kept per requester.
+// The cache is flushed whenever a library is unloaded, the global group
+// changes or the hook callback changes, so stale soinfo and symbol pointers
+// or hooks are never handed out.
+class ResolvedSymbolCache {
+ public:
+  ResolvedSymbolCache() : hooks_per_requester_(false), hits_(0), misses_(0) {}
+
+  bool find_hook(uint32_t hash, const char* name, const soinfo* requester, ElfW(Addr)* addr) {
+    const Entry* entry = find(hash, name, nullptr, hook_scope(requester), true);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    // Unhooked symbols are accounted for by lookup()
+    if (entry->hook_addr != 0) {
+      hits_++;
+    }
+
+    *addr = entry->hook_addr;
+    return true;
+  }
+
+  void add_hook(uint32_t hash, const char* name, const soinfo* requester, ElfW(Addr) addr) {
+    if (addr != 0) {
+      misses_++;
+    }
+
+    Entry entry = { name, nullptr, hook_scope(requester), true, addr, nullptr, nullptr };
+    entries_.insert(std::make_pair(hash, entry));
+  }
+
+  bool lookup(soinfo* si_from, uint32_t hash, const char* name, const version_info* vi,
+              soinfo** si_found_in, const soinfo::soinfo_list_t& global_group,
+              const soinfo::soinfo_list_t& local_group, const ElfW(Sym)** symbol) {
+    // DT_SYMBOLIC libraries look into themselves first, don't share their results.
+    if (si_from->has_DT_SYMBOLIC) {
+      return soinfo_do_lookup(si_from, name, vi, si_found_in, global_group, local_group, symbol);
+    }
+
+    const soinfo* root = local_group.front();
+    const char* version = vi != nullptr ? vi->name : nullptr;
+
+    const Entry* entry = find(hash, name, version, root, false);
+    if (entry == nullptr) {
+      entry = find(hash, name, version, nullptr, false);
+    }
+
+    if (entry != nullptr) {
+      hits_++;
+      *si_found_in = entry->si;
+      *symbol = entry->s;
+      return true;
+    }
+
+    misses_++;
+
+    if (!soinfo_do_lookup(si_from, name, vi, si_found_in, global_group, local_group, symbol)) {
+      return false;
+    }
+
+    // Undefined (weak) symbols are cheap to look up again, only cache hits.
+    if (*symbol != nullptr) {
+      bool global = false;
+      global_group.for_each([&](soinfo* si) {
+        if (si == *si_found_in) {
+          global = true;
+        }
+      });
+
+      Entry new_entry = { name, version, global ? nullptr : root, false, 0, *si_found_in, *symbol };
+      entries_.insert(std::make_pair(hash, new_entry));
+    }
+
+    return true;
+  }
+
+  // Must be called before relocating against a (possibly different) global group.
+  void set_global_group(const soinfo::soinfo_list_t& global_group) {
+    std::vector<const soinfo*> group;
+    global_group.for_each([&](soinfo* si) {
+      group.push_back(si);
+    });
+
+    if (group != global_group_) {
+      flush();
+      global_group_.swap(group);
+    }
+  }
+
+  // Must be called whenever the hook callback is set or changed.
+  void set_hook_callback(bool has_callback) {
+    hooks_per_requester_ = has_callback;
+    flush();
+  }
+
+  void flush() {
+    entries_.clear();
+  }
+
+  void report(const char* realpath) {
+    INFO("[ Symbol cache after loading \"%s\": %zu hits, %zu misses, %zu entries ]",
+         realpath, hits_, misses_, entries_.size());
+  }
+
+ private:
+  struct Entry {
+    const char* name;
+    const char* version;
+    const soinfo* scope;
+    bool is_hook;
+    ElfW(Addr) hook_addr;
+    soinfo* si;
+    const ElfW(Sym)* s;
+  };
+
+  const soinfo* hook_scope(const soinfo* requester) const {
+    return hooks_per_requester_ ? requester : nullptr;
+  }
+
+  const Entry* find(uint32_t hash, const char* name, const char* version,
+                    const soinfo* scope, bool is_hook) {
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      const Entry& entry = it->second;
+      if (entry.is_hook == is_hook && entry.scope == scope &&
+          strcmp(entry.name, name) == 0 &&
+          (entry.version == version ||
+           (entry.version != nullptr && version != nullptr && strcmp(entry.version, version) == 0))) {
+        return &entry;
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::unordered_multimap<uint32_t, Entry> entries_;
+  std::vector<const soinfo*> global_group_;
+  bool hooks_per_requester_;
+  size_t hits_;
+  size_t misses_;
+};
+
+#endif // __LINKER_SYMBOL_CACHE_H
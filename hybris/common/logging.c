@@ -22,8 +22,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <pthread.h>
 #include <time.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 
 FILE *hybris_logging_target = NULL;
 
@@ -36,8 +40,11 @@ static enum hybris_log_format _hybris_logging_format = HYBRIS_LOG_FORMAT_NORMAL;
 
 static int _hybris_should_trace = 0;
 
-static int
-hybris_logging_initialized = 0;
+static pthread_once_t
+hybris_logging_initialized = PTHREAD_ONCE_INIT;
+
+static void
+hybris_log_binary_start();
 
 static void
 hybris_logging_initialize()
@@ -72,6 +79,9 @@ hybris_logging_initialize()
 	if (strcmp(env, "systrace") == 0) {
 		_hybris_logging_format = HYBRIS_LOG_FORMAT_SYSTRACE;
 	}
+	else if (strcmp(env, "binary") == 0) {
+		_hybris_logging_format = HYBRIS_LOG_FORMAT_BINARY;
+	}
 	else
 		_hybris_logging_format = HYBRIS_LOG_FORMAT_NORMAL;
     }
@@ -84,16 +94,16 @@ hybris_logging_initialize()
         }
     }
     pthread_mutex_init(&hybris_logging_mutex, NULL);
+
+    if (_hybris_logging_format == HYBRIS_LOG_FORMAT_BINARY)
+        hybris_log_binary_start();
 }
 
 int
 hybris_should_log(enum hybris_log_level level)
 {
     /* Initialize logging level from environment */
-    if (!hybris_logging_initialized) {
-        hybris_logging_initialized = 1;
-        hybris_logging_initialize();
-    }
+    pthread_once(&hybris_logging_initialized, hybris_logging_initialize);
 
     return (level >= hybris_minimum_log_level);
 }
@@ -124,6 +134,8 @@ hybris_get_thread_time()
 int
 hybris_should_trace(const char *module, const char *tracepoint)
 {
+    pthread_once(&hybris_logging_initialized, hybris_logging_initialize);
+
     return _hybris_should_trace;
 }
 
@@ -131,3 +143,345 @@ enum hybris_log_format hybris_logging_format()
 {
     return _hybris_logging_format;
 }
+
+/*
+ * Binary logging backend, for HYBRIS_LOGGING_FORMAT=binary
+ *
+ * Formatting a message and writing it to the logging target under a global
+ * lock (and flushing it) is too slow for tracing hot paths. Instead, every
+ * thread appends binary records to its own ring buffer without any lock,
+ * and a background thread periodically writes out what the rings contain.
+ * Records that don't fit in a full ring are dropped and counted.
+ */
+
+/* Must be a power of two */
+#define HYBRIS_LOG_RING_SIZE (256 * 1024)
+#define HYBRIS_LOG_MAX_RECORD_SIZE 512
+#define HYBRIS_LOG_DRAIN_INTERVAL_NS (2 * 1000 * 1000)
+
+struct hybris_log_ring {
+    /* head is only written by the owning thread, tail by the drain */
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+    uint32_t tid;
+    int exited;
+    struct hybris_log_ring *next;
+    unsigned char data[HYBRIS_LOG_RING_SIZE];
+};
+
+static struct hybris_log_ring *hybris_log_rings = NULL;
+
+/* Protects the list of rings, and makes the drain the only consumer */
+static pthread_mutex_t hybris_log_rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t hybris_log_ring_key;
+
+static __thread struct hybris_log_ring *hybris_log_thread_ring = NULL;
+
+static unsigned long hybris_log_dropped = 0;
+
+/* Cleared in the child after a fork, which has no drain thread until it logs */
+static int hybris_log_drain_running = 0;
+
+static void
+hybris_log_ring_exit(void *data)
+{
+    struct hybris_log_ring *ring = data;
+
+    /* The drain frees the ring once it has written out its last records */
+    hybris_log_thread_ring = NULL;
+    __atomic_store_n(&ring->exited, 1, __ATOMIC_RELEASE);
+}
+
+static struct hybris_log_ring *
+hybris_log_get_ring()
+{
+    struct hybris_log_ring *ring = hybris_log_thread_ring;
+
+    if (ring)
+        return ring;
+
+    ring = calloc(1, sizeof(struct hybris_log_ring));
+    if (!ring)
+        return NULL;
+
+    ring->tid = syscall(SYS_gettid);
+
+    pthread_mutex_lock(&hybris_log_rings_mutex);
+    ring->next = hybris_log_rings;
+    hybris_log_rings = ring;
+    pthread_mutex_unlock(&hybris_log_rings_mutex);
+
+    pthread_setspecific(hybris_log_ring_key, ring);
+    hybris_log_thread_ring = ring;
+
+    return ring;
+}
+
+static void
+hybris_log_drain()
+{
+    struct hybris_log_ring **link, *ring;
+    int fd = fileno(hybris_logging_target);
+
+    pthread_mutex_lock(&hybris_log_rings_mutex);
+
+    link = &hybris_log_rings;
+    while ((ring = *link) != NULL) {
+        /* Check for exit first: an exited thread has published everything */
+        int exited = __atomic_load_n(&ring->exited, __ATOMIC_ACQUIRE);
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t tail = ring->tail;
+
+        if (head != tail) {
+            uint32_t start = tail & (HYBRIS_LOG_RING_SIZE - 1);
+            uint32_t length = head - tail;
+            struct iovec iov[2];
+            int count = 1;
+
+            iov[0].iov_base = ring->data + start;
+            iov[0].iov_len = length;
+            if (start + length > HYBRIS_LOG_RING_SIZE) {
+                iov[0].iov_len = HYBRIS_LOG_RING_SIZE - start;
+                iov[1].iov_base = ring->data;
+                iov[1].iov_len = length - iov[0].iov_len;
+                count = 2;
+            }
+
+            /* A single writev, so that processes appending to the same
+             * file don't interleave partial records */
+            writev(fd, iov, count);
+
+            __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+        }
+
+        hybris_log_dropped += __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+
+        if (exited) {
+            *link = ring->next;
+            free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+
+    pthread_mutex_unlock(&hybris_log_rings_mutex);
+}
+
+static void *
+hybris_log_drain_thread(void *arg)
+{
+    struct timespec interval = { 0, HYBRIS_LOG_DRAIN_INTERVAL_NS };
+
+    for (;;) {
+        nanosleep(&interval, NULL);
+        hybris_log_drain();
+    }
+
+    return NULL;
+}
+
+static void
+hybris_log_binary_stop()
+{
+    hybris_log_drain();
+
+    if (hybris_log_dropped)
+        fprintf(stderr, "libhybris: %lu log records were dropped\n", hybris_log_dropped);
+}
+
+static int
+hybris_log_start_drain()
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    int err;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&thread, &attr, hybris_log_drain_thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    return err;
+}
+
+static void
+hybris_log_restart_drain()
+{
+    int expected = 0;
+
+    /* Only the first thread to log in the child starts it. If that fails,
+     * the rings are still written out at exit. */
+    if (__atomic_compare_exchange_n(&hybris_log_drain_running, &expected, 1, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        hybris_log_start_drain();
+}
+
+/*
+ * The rings of the parent are written out by the parent. The child only
+ * keeps the (emptied) ring of the thread that forked, the other threads
+ * don't exist there, and starts a drain thread of its own when it logs.
+ */
+static void
+hybris_log_atfork_prepare()
+{
+    pthread_mutex_lock(&hybris_log_rings_mutex);
+}
+
+static void
+hybris_log_atfork_parent()
+{
+    pthread_mutex_unlock(&hybris_log_rings_mutex);
+}
+
+static void
+hybris_log_atfork_child()
+{
+    struct hybris_log_ring *ring = hybris_log_rings, *next;
+
+    while (ring != NULL) {
+        next = ring->next;
+        if (ring != hybris_log_thread_ring)
+            free(ring);
+        ring = next;
+    }
+
+    ring = hybris_log_thread_ring;
+    if (ring) {
+        ring->head = ring->tail = 0;
+        ring->dropped = 0;
+        ring->tid = syscall(SYS_gettid);
+        ring->next = NULL;
+    }
+    hybris_log_rings = ring;
+
+    hybris_log_dropped = 0;
+    hybris_log_drain_running = 0;
+
+    pthread_mutex_unlock(&hybris_log_rings_mutex);
+}
+
+static void
+hybris_log_binary_start()
+{
+    pthread_key_create(&hybris_log_ring_key, hybris_log_ring_exit);
+
+    fflush(hybris_logging_target);
+    write(fileno(hybris_logging_target), HYBRIS_LOG_BINARY_MAGIC, 8);
+
+    if (hybris_log_start_drain() != 0) {
+        fprintf(stderr, "libhybris: failed to start the log drain thread\n");
+        _hybris_logging_format = HYBRIS_LOG_FORMAT_NORMAL;
+    } else {
+        hybris_log_drain_running = 1;
+        pthread_atfork(hybris_log_atfork_prepare, hybris_log_atfork_parent,
+                       hybris_log_atfork_child);
+        atexit(hybris_log_binary_stop);
+    }
+}
+
+/* Returns the end of what was appended, clamped to the space available */
+static char *
+hybris_log_append(char *p, char *end, const char *format, va_list args)
+{
+    int length = vsnprintf(p, end - p, format, args);
+
+    if (length < 0)
+        length = 0;
+    if (length >= end - p)
+        length = end - p - 1;
+
+    return p + length;
+}
+
+static char *
+hybris_log_append_name(char *p, char *end, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    p = hybris_log_append(p, end, format, args);
+    va_end(args);
+
+    return p;
+}
+
+void
+hybris_log_binary(char type, enum hybris_log_level level, const char *module,
+                  const char *name, const char *format, ...)
+{
+    union {
+        struct hybris_log_record header;
+        char bytes[HYBRIS_LOG_MAX_RECORD_SIZE];
+    } record;
+    char *text = record.header.text;
+    /* leave room for the terminator of the arguments */
+    char *end = record.bytes + sizeof(record) - 1;
+    char *p = text;
+    struct hybris_log_ring *ring = hybris_log_get_ring();
+    struct timespec now;
+    va_list args;
+
+    if (!ring)
+        return;
+
+    if (!__atomic_load_n(&hybris_log_drain_running, __ATOMIC_ACQUIRE))
+        hybris_log_restart_drain();
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    record.header.timestamp = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+    record.header.pid = getpid();
+    record.header.tid = ring->tid;
+    record.header.type = type;
+    record.header.level = level;
+
+    /* The name of the event, as in the systrace format */
+    switch (type) {
+    case 'L':
+        p = hybris_log_append_name(p, end, "%s %s", module, name);
+        break;
+    case 'C':
+        p = hybris_log_append_name(p, end, "%s::%s-%i", name, module, getpid());
+        break;
+    case 'E':
+        *p = '\0';
+        break;
+    default:
+        p = hybris_log_append_name(p, end, "%s::%s", name, module);
+        break;
+    }
+
+    /* The message is part of the name for the beginning of a slice, else
+     * it is stored as the arguments: the text of a log, or a counter value */
+    va_start(args, format);
+    if (type == 'B') {
+        p = hybris_log_append(p, end, format, args) + 1;
+        *p++ = '\0';
+    } else {
+        p = hybris_log_append(p + 1, end + 1, format, args) + 1;
+    }
+    va_end(args);
+
+    uint32_t size = (p - record.bytes + 7) & ~7;
+    record.header.size = size;
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (HYBRIS_LOG_RING_SIZE - (head - tail) < size) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    uint32_t start = head & (HYBRIS_LOG_RING_SIZE - 1);
+    uint32_t first = size;
+
+    if (start + size > HYBRIS_LOG_RING_SIZE)
+        first = HYBRIS_LOG_RING_SIZE - start;
+
+    memcpy(ring->data + start, record.bytes, first);
+    memcpy(ring->data, record.bytes + first, size - first);
+
+    __atomic_store_n(&ring->head, head + size, __ATOMIC_RELEASE);
+}
@@ -20,6 +20,7 @@
 #define HYBRIS_LOGGING_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <pthread.h>
@@ -46,7 +47,29 @@ enum hybris_log_level {
 
 enum hybris_log_format {
     HYBRIS_LOG_FORMAT_NORMAL,
-    HYBRIS_LOG_FORMAT_SYSTRACE
+    HYBRIS_LOG_FORMAT_SYSTRACE,
+    HYBRIS_LOG_FORMAT_BINARY
+};
+
+/**
+ * With HYBRIS_LOGGING_FORMAT=binary, the logging target receives these
+ * records, after a HYBRIS_LOG_BINARY_MAGIC header written by each process.
+ * utils/hybris-trace-decode converts them to a systrace/Perfetto trace.
+ **/
+#define HYBRIS_LOG_BINARY_MAGIC "HYBRISLG"
+
+struct hybris_log_record {
+    /* CLOCK_MONOTONIC, in nanoseconds */
+    uint64_t timestamp;
+    uint32_t pid;
+    uint32_t tid;
+    /* size of the whole record, a multiple of 8 */
+    uint16_t size;
+    /* 'L' for log messages, 'B', 'E' or 'C' for tracepoints */
+    uint8_t type;
+    uint8_t level;
+    /* zero-terminated name, followed by the zero-terminated arguments */
+    char text[];
 };
 
 /**
@@ -76,6 +99,13 @@ enum hybris_log_format hybris_logging_format();
 
 int hybris_should_trace(const char *module, const char *tracepoint);
 
+/**
+ * Appends a record to the binary log of the calling thread, without
+ * blocking. Only used by the logging macros, no need to call it manually.
+ **/
+void hybris_log_binary(char type, enum hybris_log_level level, const char *module,
+                       const char *name, const char *format, ...);
+
 extern pthread_mutex_t hybris_logging_mutex;
 
 #ifdef __cplusplus
@@ -87,6 +117,11 @@ extern FILE *hybris_logging_target;
 #if defined(DEBUG)
 #    define HYBRIS_LOG_(level, module, message, ...) do { \
           if (hybris_should_log(level)) { \
+              if (hybris_logging_format() == HYBRIS_LOG_FORMAT_BINARY) { \
+                hybris_log_binary('L', level, module, __PRETTY_FUNCTION__, "%s:%d " message, \
+                      __FILE__, __LINE__, ##__VA_ARGS__); \
+                break; \
+              } \
               pthread_mutex_lock(&hybris_logging_mutex); \
               if (hybris_logging_format() == HYBRIS_LOG_FORMAT_NORMAL) \
               { \
@@ -113,6 +148,10 @@ extern FILE *hybris_logging_target;
 
 #define HYBRIS_TRACE_RECORD(module, what, tracepoint, message, ...) do { \
           if (hybris_should_trace(module, tracepoint)) { \
+              if (hybris_logging_format() == HYBRIS_LOG_FORMAT_BINARY) { \
+                hybris_log_binary(what, HYBRIS_LOG_DEBUG, module, tracepoint, message, ##__VA_ARGS__); \
+                break; \
+              } \
               pthread_mutex_lock(&hybris_logging_mutex); \
               if (hybris_logging_format() == HYBRIS_LOG_FORMAT_NORMAL) \
               { \
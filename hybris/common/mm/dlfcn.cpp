@@ -193,6 +193,12 @@ extern "C" int android_dlclose(void* handle) {
   return 0;
 }
 
+// hybris: called by hybris_set_hook_callback()
+extern "C" void android_linker_hook_callback_changed(int has_callback) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  do_hook_callback_changed(has_callback != 0);
+}
+
 int dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
   return do_dl_iterate_phdr(cb, data);
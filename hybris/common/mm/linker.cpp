@@ -59,6 +59,7 @@
 #include "linker_reloc_iterators.h"
 
 #include "hybris_compat.h"
+#include "linker_symbol_cache.h"
 
 #ifdef WANT_ARM_TRACING
 #include "../wrappers.h"
@@ -148,6 +149,8 @@ static link_map* r_debug_tail = 0;
 
 static void* (*_get_hooked_symbol)(const char *sym, const char *requester);
 
+static ResolvedSymbolCache g_resolved_symbols;
+
 #ifdef WANT_ARM_TRACING
 void *(*_create_wrapper)(const char *symbol, void *function, int wrapper_type);
 #endif
@@ -261,6 +264,9 @@ static void soinfo_free(soinfo* si) {
     return;
   }
 
+  // Cached symbols may point into this library
+  g_resolved_symbols.flush();
+
   if (si->base != 0 && si->size != 0) {
     munmap(reinterpret_cast<void*>(si->base), si->size);
   }
@@ -1385,6 +1391,7 @@ static bool find_libraries(soinfo* start_with, const char* const library_names[]
 
   // Construct global_group.
   soinfo::soinfo_list_t global_group = make_global_group();
+  g_resolved_symbols.set_global_group(global_group);
 
   // If soinfos array is null allocate one on stack.
   // The array is needed in case of failure; for example
@@ -1480,6 +1487,8 @@ static bool find_libraries(soinfo* start_with, const char* const library_names[]
     local_group.front()->increment_ref_count();
   }
 
+  g_resolved_symbols.report(local_group.front()->get_realpath());
+
   return linked;
 }
 
@@ -1643,6 +1652,12 @@ void do_dlclose(soinfo* si) {
   soinfo_unload(si);
 }
 
+// hybris: hook results only depend on the requester with a hook callback,
+// see ResolvedSymbolCache
+void do_hook_callback_changed(bool has_callback) {
+  g_resolved_symbols.set_hook_callback(has_callback);
+}
+
 static ElfW(Addr) call_ifunc_resolver(ElfW(Addr) resolver_addr) {
   typedef ElfW(Addr) (*ifunc_resolver_t)(void);
   ifunc_resolver_t ifunc_resolver = reinterpret_cast<ifunc_resolver_t>(resolver_addr);
@@ -1804,14 +1819,21 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
     if (sym != 0) {
       sym_name = get_string(symtab_[sym].st_name);
       const version_info* vi = nullptr;
+      SymbolName symbol_name(sym_name);
+      uint32_t hash = symbol_name.gnu_hash();
+
+      if (!g_resolved_symbols.find_hook(hash, sym_name, this, &sym_addr)) {
+        sym_addr = reinterpret_cast<ElfW(Addr)>(_get_hooked_symbol(sym_name, get_realpath()));
+        g_resolved_symbols.add_hook(hash, sym_name, this, sym_addr);
+      }
 
-      sym_addr = reinterpret_cast<ElfW(Addr)>(_get_hooked_symbol(sym_name, get_realpath()));
       if (!sym_addr) {
         if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
           return false;
         }
 
-        if (!soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
+        if (!g_resolved_symbols.lookup(this, hash, sym_name, vi, &lsi,
+                                       global_group, local_group, &s)) {
           return false;
         }
       }
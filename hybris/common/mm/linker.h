@@ -428,6 +428,9 @@ soinfo* find_containing_library(const void* addr);
 
 const ElfW(Sym)* dlsym_handle_lookup(soinfo* si, soinfo** found, const char* name);
 
+// hybris: see ResolvedSymbolCache
+void do_hook_callback_changed(bool has_callback);
+
 void debuggerd_init();
 extern "C" abort_msg_t* g_abort_message;
 extern "C" void notify_gdb_of_libraries();
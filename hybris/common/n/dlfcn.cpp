@@ -16,6 +16,7 @@
 
 #include "linker.h"
 #include "linker_dlwarning.h"
+#include "linker_lazy_bind.h"
 
 #include <pthread.h>
 #include <stdio.h>
@@ -128,6 +129,18 @@ extern "C" int android_dladdr(const void* addr, Dl_info* info) {
   return do_dladdr(addr, info);
 }
 
+// hybris: called by hybris_set_hook_callback()
+extern "C" void android_linker_hook_callback_changed(int has_callback) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  do_hook_callback_changed(has_callback != 0);
+}
+
+// hybris: called by the lazy binding trampolines, see linker_lazy_bind.cpp.
+// Doesn't take g_dl_mutex, see LazyBinding.
+extern "C" ElfW(Addr) __hybris_lazy_bind(void* si, size_t index) {
+  return do_lazy_bind(static_cast<soinfo*>(si), index);
+}
+
 extern "C" int android_dlclose(void* handle) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
   int result = do_dlclose(handle);
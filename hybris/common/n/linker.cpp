@@ -36,9 +36,11 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <new>
 #include <string>
 #include <unordered_map>
@@ -59,6 +61,7 @@
 #include "linker_gdb_support.h"
 #include "linker_debug.h"
 #include "linker_dlwarning.h"
+#include "linker_lazy_bind.h"
 #include "linker_sleb128.h"
 #include "linker_phdr.h"
 #include "linker_relocs.h"
@@ -68,6 +71,9 @@
 #include "linker_non_pie.h"
 #endif
 
+// hybris: shared with the mm linker
+#include "linker_symbol_cache.h"
+
 // Stay compatible with newer glibc
 #ifndef R_AARCH64_TLS_TPREL64
 #define R_AARCH64_TLS_TPREL64 R_AARCH64_TLS_TPREL
@@ -348,6 +354,629 @@ uint32_t bitmask[4096];
 
 static void* (*_get_hooked_symbol)(const char *sym, const char *requester);
 
+static ResolvedSymbolCache g_resolved_symbols;
+
+// hybris: persistent relocation cache, enabled by setting
+// HYBRIS_LD_RELOC_CACHE to a directory only the user can write to.
+//
+// Every process resolves the symbols of the same vendor libraries the same
+// way. For each symbol relocation of the libraries a dlopen() links, the
+// cache file of the library opened records where the lookup found the
+// symbol: the position of the defining library in the lookup scope (the
+// global group followed by the local group) and the index of the symbol in
+// its symbol table. Later loads take the symbols from there instead of
+// looking them up.
+//
+// A cache file is only used when every library of the scope is the same
+// file, in the same place, identified by device, inode, size, mtime and
+// build-id, and a cached symbol is only used if it still has the name looked
+// up. Hooks are not cached: they may depend on the requester or on the hook
+// callback, so they are asked for every symbol as before, and the cache only
+// stands in for the lookups of the symbols no hook provides. Files that turn
+// out stale are rewritten.
+class RelocationCache {
+ public:
+  RelocationCache()
+      : enabled_(false), open_(false), dirty_(false), current_(kNone), cached_(nullptr),
+        stale_(false), next_(0), hits_(0), misses_(0), files_read_(0), files_written_(0) {}
+
+  void init(const char* dir) {
+    dir_ = dir;
+    enabled_ = !dir_.empty();
+  }
+
+  // Must be called before linking the libraries of the local group.
+  void open(const soinfo::soinfo_list_t& global_group, const soinfo::soinfo_list_t& local_group) {
+    open_ = false;
+    if (!enabled_) {
+      return;
+    }
+
+    scope_.clear();
+    scope_ids_.clear();
+    scope_index_.clear();
+    entries_.clear();
+    known_.clear();
+
+    bool cacheable = true;
+    auto add_to_scope = [&](soinfo* si) {
+      uint64_t id = get_id(si);
+      if (id == 0) {
+        cacheable = false;
+      }
+
+      // A library of both groups is found in the global one
+      scope_index_.insert(std::make_pair(si, static_cast<uint32_t>(scope_.size())));
+      scope_.push_back(si);
+      scope_ids_.push_back(id);
+    };
+    global_group.for_each(add_to_scope);
+    local_group.for_each(add_to_scope);
+
+    if (!cacheable) {
+      return;
+    }
+
+    entries_.resize(scope_.size());
+    known_.resize(scope_.size());
+    path_ = get_path(local_group.front());
+    dirty_ = false;
+    open_ = true;
+
+    read_file();
+  }
+
+  // Must be called once the libraries are linked, linked is false if they
+  // couldn't be.
+  void close(bool linked) {
+    if (open_ && linked && dirty_) {
+      write_file();
+    }
+    open_ = false;
+  }
+
+  // Must be called before relocating si.
+  void begin(const soinfo* si) {
+    current_ = kNone;
+    if (!open_) {
+      return;
+    }
+
+    auto it = scope_index_.find(si);
+    if (it == scope_index_.end()) {
+      return;
+    }
+
+    current_ = it->second;
+    cached_ = known_[current_] ? &entries_[current_] : nullptr;
+    resolved_.clear();
+    stale_ = cached_ == nullptr;
+    next_ = 0;
+  }
+
+  // Finds the next symbol relocation in the cache. If it is not there, the
+  // symbol must be looked up, then passed to add().
+  bool find(const char* name, soinfo** si_found_in, const ElfW(Sym)** symbol) {
+    if (current_ == kNone || cached_ == nullptr || next_ >= cached_->size()) {
+      return false;
+    }
+
+    const Entry& entry = (*cached_)[next_];
+    if (entry.scope_index == kUndefinedWeak) {
+      *si_found_in = nullptr;
+      *symbol = nullptr;
+    } else if (entry.scope_index < scope_.size()) {
+      soinfo* scope_si = scope_[entry.scope_index];
+      const ElfW(Sym)* s = scope_si->find_symbol_by_index(entry.symbol_index, name);
+      if (s == nullptr) {
+        return false;
+      }
+
+      *si_found_in = scope_si;
+      *symbol = s;
+    } else {
+      return false;
+    }
+
+    hits_++;
+    resolved_.push_back(entry);
+    next_++;
+    return true;
+  }
+
+  // Records where a symbol was found, s is nullptr for undefined weak symbols.
+  void add(soinfo* si_found_in, const ElfW(Sym)* s) {
+    if (current_ == kNone) {
+      return;
+    }
+
+    Entry entry = { kNotCached, 0 };
+    if (s == nullptr) {
+      entry.scope_index = kUndefinedWeak;
+    } else {
+      auto it = scope_index_.find(si_found_in);
+      if (it != scope_index_.end()) {
+        entry.scope_index = it->second;
+        entry.symbol_index = static_cast<uint32_t>(si_found_in->get_symbol_index(s));
+      }
+    }
+
+    misses_++;
+    stale_ = true;
+    resolved_.push_back(entry);
+    next_++;
+  }
+
+  // Records a symbol provided by a hook.
+  void skip() {
+    if (current_ == kNone) {
+      return;
+    }
+
+    if (cached_ == nullptr || next_ >= cached_->size() ||
+        (*cached_)[next_].scope_index != kNotCached) {
+      stale_ = true;
+    }
+
+    Entry entry = { kNotCached, 0 };
+    resolved_.push_back(entry);
+    next_++;
+  }
+
+  // Must be called once the library is relocated.
+  void commit() {
+    if (current_ == kNone) {
+      return;
+    }
+
+    if (stale_ || next_ != cached_->size()) {
+      entries_[current_].swap(resolved_);
+      known_[current_] = true;
+      dirty_ = true;
+    }
+    current_ = kNone;
+  }
+
+  void abort() {
+    current_ = kNone;
+  }
+
+  // Must be called before si is freed.
+  void forget(const soinfo* si) {
+    ids_.erase(si);
+  }
+
+  void report(const char* realpath) {
+    if (enabled_) {
+      INFO("[ Relocation cache after loading \"%s\": %zu hits, %zu misses, "
+           "%zu files read, %zu files written ]",
+           realpath, hits_, misses_, files_read_, files_written_);
+    }
+  }
+
+ private:
+  static const uint32_t kMagic = 0x43524248; // "HBRC"
+  static const uint32_t kVersion = 1;
+  static const uint32_t kNone = 0xffffffff;
+  static const uint32_t kNotCached = 0xffffffff;
+  static const uint32_t kUndefinedWeak = 0xfffffffe;
+  static const uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+  static const size_t kMaxFileSize = 64 * 1024 * 1024;
+
+  // The file holds a Header, the scope's ids, a Library for each library
+  // with relocations, then their entries.
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pointer_size;
+    uint32_t scope_size;
+    uint32_t library_count;
+    uint32_t entry_count;
+    uint64_t checksum;
+  };
+
+  struct Library {
+    uint32_t scope_index;
+    uint32_t entry_count;
+  };
+
+  struct Entry {
+    uint32_t scope_index;
+    uint32_t symbol_index;
+  };
+
+  static uint64_t fnv(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  template<typename T>
+  static uint64_t fnv(uint64_t hash, const T& value) {
+    return fnv(hash, &value, sizeof(value));
+  }
+
+  static uint64_t hash_build_id(uint64_t hash, const soinfo* si) {
+    for (size_t i = 0; i < si->phnum; ++i) {
+      const ElfW(Phdr)* phdr = &si->phdr[i];
+      if (phdr->p_type != PT_NOTE) {
+        continue;
+      }
+
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(si->load_bias + phdr->p_vaddr);
+      const uint8_t* end = p + phdr->p_memsz;
+      while (p + sizeof(ElfW(Nhdr)) <= end) {
+        const ElfW(Nhdr)* note = reinterpret_cast<const ElfW(Nhdr)*>(p);
+        const uint8_t* name = p + sizeof(ElfW(Nhdr));
+        const uint8_t* desc = name + ((note->n_namesz + 3) & ~3);
+        p = desc + ((note->n_descsz + 3) & ~3);
+        if (p > end) {
+          break;
+        }
+
+        if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+            memcmp(name, "GNU", 4) == 0) {
+          return fnv(hash, desc, note->n_descsz);
+        }
+      }
+    }
+
+    return hash;
+  }
+
+  // Identifies the file a library was loaded from, 0 if it can't be.
+  uint64_t get_id(const soinfo* si) {
+    auto it = ids_.find(si);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+
+    const char* realpath = si->get_realpath();
+    uint64_t id = fnv(kFnvOffset, realpath, strlen(realpath));
+
+    // Libraries that don't come from a file, like libdl.so, only have a name
+    if (si->get_st_dev() != 0 || si->get_st_ino() != 0) {
+      struct stat file_stat;
+      if (stat(realpath, &file_stat) != 0 ||
+          file_stat.st_dev != si->get_st_dev() || file_stat.st_ino != si->get_st_ino()) {
+        id = 0;
+      } else {
+        id = fnv(id, file_stat.st_dev);
+        id = fnv(id, file_stat.st_ino);
+        id = fnv(id, file_stat.st_size);
+        id = fnv(id, file_stat.st_mtim.tv_sec);
+        id = fnv(id, file_stat.st_mtim.tv_nsec);
+        id = fnv(id, si->get_file_offset());
+        id = hash_build_id(id, si) | 1;
+      }
+    } else {
+      id |= 1;
+    }
+
+    ids_[si] = id;
+    return id;
+  }
+
+  std::string get_path(const soinfo* root) const {
+    char name[32];
+    const char* realpath = root->get_realpath();
+    snprintf(name, sizeof(name), "/%016" PRIx64 "-%zu.reloc",
+             fnv(kFnvOffset, realpath, strlen(realpath)), sizeof(void*) * 8);
+    return dir_ + name;
+  }
+
+  void read_file() {
+    int fd = TEMP_FAILURE_RETRY(::open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd == -1) {
+      return;
+    }
+
+    struct stat file_stat;
+    std::vector<uint8_t> data;
+    if (fstat(fd, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) <= kMaxFileSize) {
+      data.resize(file_stat.st_size);
+      if (TEMP_FAILURE_RETRY(read(fd, data.data(), data.size())) != static_cast<ssize_t>(data.size())) {
+        data.clear();
+      }
+    }
+    ::close(fd);
+
+    if (data.size() < sizeof(Header)) {
+      return;
+    }
+
+    Header header;
+    memcpy(&header, data.data(), sizeof(header));
+    size_t ids_size = header.scope_size * sizeof(uint64_t);
+    size_t libraries_size = header.library_count * sizeof(Library);
+    size_t entries_size = header.entry_count * sizeof(Entry);
+
+    if (header.magic != kMagic || header.version != kVersion ||
+        header.pointer_size != sizeof(void*) || header.scope_size != scope_ids_.size() ||
+        header.library_count > scope_ids_.size() ||
+        data.size() != sizeof(header) + ids_size + libraries_size + entries_size ||
+        fnv(kFnvOffset, data.data() + sizeof(header), data.size() - sizeof(header)) != header.checksum ||
+        memcmp(data.data() + sizeof(header), scope_ids_.data(), ids_size) != 0) {
+      return;
+    }
+
+    const uint8_t* libraries = data.data() + sizeof(header) + ids_size;
+    const uint8_t* entries = libraries + libraries_size;
+    size_t entry_count = 0;
+    for (size_t i = 0; i < header.library_count; ++i) {
+      Library library;
+      memcpy(&library, libraries + i * sizeof(library), sizeof(library));
+      if (library.scope_index >= scope_.size() ||
+          library.entry_count > header.entry_count - entry_count) {
+        return;
+      }
+
+      std::vector<Entry>& library_entries = entries_[library.scope_index];
+      library_entries.resize(library.entry_count);
+      memcpy(library_entries.data(), entries + entry_count * sizeof(Entry),
+             library.entry_count * sizeof(Entry));
+      known_[library.scope_index] = true;
+      entry_count += library.entry_count;
+    }
+
+    files_read_++;
+  }
+
+  void write_file() {
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.pointer_size = sizeof(void*);
+    header.scope_size = scope_ids_.size();
+
+    std::vector<uint8_t> data(scope_ids_.size() * sizeof(uint64_t));
+    memcpy(data.data(), scope_ids_.data(), data.size());
+
+    std::vector<Entry> entries;
+    for (size_t i = 0; i < scope_.size(); ++i) {
+      if (!known_[i]) {
+        continue;
+      }
+
+      Library library = { static_cast<uint32_t>(i), static_cast<uint32_t>(entries_[i].size()) };
+      const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&library);
+      data.insert(data.end(), bytes, bytes + sizeof(library));
+      entries.insert(entries.end(), entries_[i].begin(), entries_[i].end());
+      header.library_count++;
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(entries.data());
+    data.insert(data.end(), bytes, bytes + entries.size() * sizeof(Entry));
+    header.entry_count = entries.size();
+    header.checksum = fnv(kFnvOffset, data.data(), data.size());
+
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", getpid());
+    std::string tmp_path = path_ + suffix;
+
+    int fd = TEMP_FAILURE_RETRY(::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (fd == -1) {
+      return;
+    }
+
+    bool written = TEMP_FAILURE_RETRY(write(fd, &header, sizeof(header))) == sizeof(header) &&
+                   TEMP_FAILURE_RETRY(write(fd, data.data(), data.size())) == static_cast<ssize_t>(data.size());
+    ::close(fd);
+
+    // Other processes see either the old file or the whole new one
+    if (!written || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+      unlink(tmp_path.c_str());
+      return;
+    }
+
+    files_written_++;
+  }
+
+  bool enabled_;
+  std::string dir_;
+  std::unordered_map<const soinfo*, uint64_t> ids_;
+
+  // The scope of the libraries being linked, and where their symbols were
+  // found, if known
+  bool open_;
+  std::string path_;
+  std::vector<soinfo*> scope_;
+  std::vector<uint64_t> scope_ids_;
+  std::unordered_map<const soinfo*, uint32_t> scope_index_;
+  std::vector<std::vector<Entry>> entries_;
+  std::vector<bool> known_;
+  bool dirty_;
+
+  // The library being relocated, kNone if it isn't cached
+  uint32_t current_;
+  const std::vector<Entry>* cached_;
+  std::vector<Entry> resolved_;
+  bool stale_;
+  size_t next_;
+
+  size_t hits_;
+  size_t misses_;
+  size_t files_read_;
+  size_t files_written_;
+};
+
+static RelocationCache g_relocation_cache;
+
+// hybris: lazy binding, enabled by setting HYBRIS_LD_BIND_LAZY to 1.
+//
+// Vendor libraries have thousands of PLT entries, most of which a process
+// never calls. With lazy binding, the libraries a dlopen() with RTLD_LAZY
+// links leave their PLT slots pointing back to their PLT, which calls the
+// resolver trampoline the first time a function is called (see
+// linker_lazy_bind.cpp). The symbol is then looked up the way it would have
+// been when linking, hooks first, and the slot patched.
+//
+// Binding doesn't take g_dl_mutex: a thread calling a function for the first
+// time would otherwise wait for a dlopen() in another thread, constructors
+// included, and deadlock if that dlopen() waits for it. The groups a library
+// was linked against are pinned when it is linked instead, and looked up
+// under a lock of their own, which dlopen() and dlclose() only take to pin
+// or drop a scope. Hooks and ifunc resolvers are called without it.
+//
+// Libraries linked with -z now, whose GOT may be read-only once relocated,
+// and libraries with other relocations than jump slots in DT_JMPREL are
+// bound when linked, like all libraries on architectures without a
+// trampoline.
+class LazyBinding {
+ public:
+  LazyBinding() : enabled_(false), deferred_(0), bound_(0), scopes_(nullptr) {
+    pthread_rwlock_init(&lock_, nullptr);
+  }
+
+  void init() {
+    enabled_ = true;
+    // Never freed, threads may still bind while the process exits
+    scopes_ = new std::unordered_map<const soinfo*, Scope>();
+  }
+
+  bool enabled() const {
+    return enabled_;
+  }
+
+  // Called with g_dl_mutex held, when si is linked.
+  void pin_scope(const soinfo* si, const soinfo::soinfo_list_t& global_group,
+                 const soinfo::soinfo_list_t& local_group) {
+    Scope scope;
+    global_group.for_each([&](soinfo* group_si) {
+      scope.global_group.push_back(group_si);
+    });
+    local_group.for_each([&](soinfo* group_si) {
+      scope.local_group.push_back(group_si);
+    });
+
+    pthread_rwlock_wrlock(&lock_);
+    (*scopes_)[si].swap(scope);
+    pthread_rwlock_unlock(&lock_);
+  }
+
+  // Called with g_dl_mutex held, before si is freed.
+  void forget(const soinfo* si) {
+    if (scopes_ == nullptr) {
+      return;
+    }
+
+    pthread_rwlock_wrlock(&lock_);
+    scopes_->erase(si);
+    for (auto& it : *scopes_) {
+      it.second.remove(si);
+    }
+    pthread_rwlock_unlock(&lock_);
+  }
+
+  // Looks name up in the scope si_from was linked against, like
+  // soinfo_do_lookup(). Returns false on errors, and sets *addr to 0 if the
+  // symbol isn't defined. *ifunc tells if *addr is that of an ifunc resolver.
+  bool lookup(const soinfo* si_from, const char* name, const version_info* vi,
+              ElfW(Addr)* addr, bool* ifunc) {
+    SymbolName symbol_name(name);
+    const ElfW(Sym)* s = nullptr;
+    soinfo* si_found_in = nullptr;
+    bool result = true;
+
+    pthread_rwlock_rdlock(&lock_);
+
+    auto it = scopes_->find(si_from);
+    if (it == scopes_->end()) {
+      pthread_rwlock_unlock(&lock_);
+      __libc_fatal("\"%s\": lazy binding without a scope", si_from->get_realpath());
+    }
+    const Scope& scope = it->second;
+
+    auto find = [&](soinfo* si) {
+      if (!si->find_symbol_by_name(symbol_name, vi, &s)) {
+        result = false;
+        return true;
+      }
+      if (s != nullptr) {
+        si_found_in = si;
+      }
+      return s != nullptr;
+    };
+
+    // See soinfo_do_lookup() about DT_SYMBOLIC
+    if (si_from->has_DT_SYMBOLIC) {
+      find(const_cast<soinfo*>(si_from));
+    }
+    for (size_t i = 0; result && s == nullptr && i < scope.global_group.size(); ++i) {
+      find(scope.global_group[i]);
+    }
+    for (size_t i = 0; result && s == nullptr && i < scope.local_group.size(); ++i) {
+      if (scope.local_group[i] != si_from || !si_from->has_DT_SYMBOLIC) {
+        find(scope.local_group[i]);
+      }
+    }
+
+    *addr = 0;
+    *ifunc = false;
+    if (result && s != nullptr) {
+      TRACE_TYPE(LOOKUP, "si %s sym %s s->st_value = %p, found in %s (lazy)",
+                 si_from->get_realpath(), name, reinterpret_cast<void*>(s->st_value),
+                 si_found_in->get_realpath());
+      *addr = s->st_value + si_found_in->load_bias;
+      *ifunc = ELF_ST_TYPE(s->st_info) == STT_GNU_IFUNC;
+    }
+
+    pthread_rwlock_unlock(&lock_);
+    return result;
+  }
+
+  void add_deferred(size_t count) {
+    deferred_ += count;
+  }
+
+  void add_bound() {
+    __atomic_fetch_add(&bound_, 1, __ATOMIC_RELAXED);
+  }
+
+  // realpath is nullptr at exit
+  void report(const char* realpath) {
+    if (!enabled_) {
+      return;
+    }
+
+    size_t bound = __atomic_load_n(&bound_, __ATOMIC_RELAXED);
+    if (realpath != nullptr) {
+      INFO("[ Lazy binding after loading \"%s\": %zu slots deferred, %zu bound on first call ]",
+           realpath, deferred_, bound);
+    } else {
+      INFO("[ Lazy binding at exit: %zu slots deferred, %zu bound on first call ]",
+           deferred_, bound);
+    }
+  }
+
+ private:
+  struct Scope {
+    std::vector<soinfo*> global_group;
+    std::vector<soinfo*> local_group;
+
+    void swap(Scope& other) {
+      global_group.swap(other.global_group);
+      local_group.swap(other.local_group);
+    }
+
+    void remove(const soinfo* si) {
+      global_group.erase(std::remove(global_group.begin(), global_group.end(), si), global_group.end());
+      local_group.erase(std::remove(local_group.begin(), local_group.end(), si), local_group.end());
+    }
+  };
+
+  bool enabled_;
+  size_t deferred_;
+  size_t bound_;
+  pthread_rwlock_t lock_;
+  std::unordered_map<const soinfo*, Scope>* scopes_;
+};
+
+static LazyBinding g_lazy_binding;
+
 static char __linker_dl_err_buf[768];
 
 char* linker_get_error_buffer() {
@@ -449,6 +1078,11 @@ static void soinfo_free(soinfo* si) {
     return;
   }
 
+  // Cached symbols may point into this library
+  g_resolved_symbols.flush();
+  g_relocation_cache.forget(si);
+  g_lazy_binding.forget(si);
+
   if (si->base != 0 && si->size != 0) {
     if (!si->is_mapped_by_caller()) {
       munmap(reinterpret_cast<void*>(si->base), si->size);
@@ -778,6 +1412,8 @@ bool soinfo::find_symbol_by_name(SymbolName& symbol_name,
   bool success =
       is_gnu_hash() ?
       gnu_lookup(symbol_name, vi, &symbol_index) :
+      synthesized_gnu_hash_ != nullptr ?
+      synthesized_gnu_lookup(symbol_name, vi, &symbol_index) :
       elf_lookup(symbol_name, vi, &symbol_index);
 
   if (success) {
@@ -925,6 +1561,157 @@ bool soinfo::elf_lookup(SymbolName& symbol_name,
   return true;
 }
 
+// hybris: old vendor libraries are often built with --hash-style=sysv.
+// Looking a symbol up in them walks a hash chain, and compares names, even
+// when the symbol isn't there, which is what most lookups in most libraries
+// of a group find. For these libraries, a GNU hash table is built at load
+// time: a bloom filter that turns away most of the misses, and chains of
+// the symbols with the same GNU hash modulo the number of buckets, in the
+// order of the SysV ones.
+struct SynthesizedGnuHash {
+  static const uint32_t kBloomBits = sizeof(ElfW(Addr)) * 8;
+  static const uint32_t kShift2 = 6;
+
+  std::vector<ElfW(Addr)> bloom_filter;
+  std::vector<uint32_t> buckets;
+  std::vector<uint32_t> chain;
+  std::vector<uint32_t> hashes;
+};
+
+static bool is_symbol_hashed(const ElfW(Sym)* s) {
+  return s->st_shndx != SHN_UNDEF &&
+         (ELF_ST_BIND(s->st_info) == STB_GLOBAL || ELF_ST_BIND(s->st_info) == STB_WEAK);
+}
+
+void soinfo::synthesize_gnu_hash() {
+  size_t count = 0;
+  for (size_t n = 1; n < nchain_; ++n) {
+    if (is_symbol_hashed(symtab_ + n) && symtab_[n].st_name < strtab_size_) {
+      count++;
+    }
+  }
+
+  SynthesizedGnuHash* table = new SynthesizedGnuHash();
+
+  // About 16 bits per symbol, like ld does
+  size_t bloom_size = 1;
+  while (bloom_size * SynthesizedGnuHash::kBloomBits < count * 16) {
+    bloom_size <<= 1;
+  }
+
+  table->bloom_filter.resize(bloom_size);
+  table->buckets.resize(count / 2 + 1);
+  table->chain.resize(nchain_);
+  table->hashes.resize(nchain_);
+
+  for (size_t n = 1; n < nchain_; ++n) {
+    const ElfW(Sym)* s = symtab_ + n;
+    if (!is_symbol_hashed(s) || s->st_name >= strtab_size_) {
+      continue;
+    }
+
+    SymbolName symbol_name(get_string(s->st_name));
+    uint32_t hash = symbol_name.gnu_hash();
+    uint32_t& bucket = table->buckets[hash % table->buckets.size()];
+
+    table->hashes[n] = hash;
+    table->chain[n] = bucket;
+    bucket = n;
+
+    ElfW(Addr)& bloom_word = table->bloom_filter[(hash / SynthesizedGnuHash::kBloomBits) & (bloom_size - 1)];
+    bloom_word |= static_cast<ElfW(Addr)>(1) << (hash % SynthesizedGnuHash::kBloomBits);
+    bloom_word |= static_cast<ElfW(Addr)>(1) << ((hash >> SynthesizedGnuHash::kShift2) % SynthesizedGnuHash::kBloomBits);
+  }
+
+  synthesized_gnu_hash_ = table;
+}
+
+bool soinfo::synthesized_gnu_lookup(SymbolName& symbol_name,
+                                    const version_info* vi,
+                                    uint32_t* symbol_index) const {
+  const SynthesizedGnuHash* table = synthesized_gnu_hash_;
+  uint32_t hash = symbol_name.gnu_hash();
+
+  *symbol_index = 0;
+
+  TRACE_TYPE(LOOKUP, "SEARCH %s in %s@%p (synthesized gnu)",
+      symbol_name.get_name(), get_realpath(), reinterpret_cast<void*>(base));
+
+  ElfW(Addr) bloom_word = table->bloom_filter[(hash / SynthesizedGnuHash::kBloomBits) &
+                                              (table->bloom_filter.size() - 1)];
+  if ((1 & (bloom_word >> (hash % SynthesizedGnuHash::kBloomBits)) &
+       (bloom_word >> ((hash >> SynthesizedGnuHash::kShift2) % SynthesizedGnuHash::kBloomBits))) == 0) {
+    TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p",
+        symbol_name.get_name(), get_realpath(), reinterpret_cast<void*>(base));
+
+    return true;
+  }
+
+  ElfW(Versym) verneed = 0;
+  if (!find_verdef_version_index(vi, &verneed)) {
+    return false;
+  }
+
+  for (uint32_t n = table->buckets[hash % table->buckets.size()]; n != 0; n = table->chain[n]) {
+    if (table->hashes[n] != hash) {
+      continue;
+    }
+
+    ElfW(Sym)* s = symtab_ + n;
+    const ElfW(Versym)* verdef = get_versym(n);
+
+    // skip hidden versions when verneed == 0
+    if (verneed == kVersymNotNeeded && is_versym_hidden(verdef)) {
+        continue;
+    }
+
+    if (check_symbol_version(verneed, verdef) &&
+        strcmp(get_string(s->st_name), symbol_name.get_name()) == 0) {
+      TRACE_TYPE(LOOKUP, "FOUND %s in %s (%p) %zd",
+                 symbol_name.get_name(), get_realpath(),
+                 reinterpret_cast<void*>(s->st_value),
+                 static_cast<size_t>(s->st_size));
+      *symbol_index = n;
+      return true;
+    }
+  }
+
+  TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p",
+             symbol_name.get_name(), get_realpath(), reinterpret_cast<void*>(base));
+
+  return true;
+}
+
+template<typename F>
+void soinfo::for_each_gnu_hash(F action) const {
+  if (is_gnu_hash()) {
+    // The chains keep all the bits of the hashes but the lowest one
+    for (size_t i = 0; i < gnu_nbucket_; ++i) {
+      uint32_t n = gnu_bucket_[i];
+      if (n == 0) {
+        continue;
+      }
+
+      do {
+        action(gnu_chain_[n] >> 1);
+      } while ((gnu_chain_[n++] & 1) == 0);
+    }
+  } else if (synthesized_gnu_hash_ != nullptr) {
+    for (uint32_t n : synthesized_gnu_hash_->buckets) {
+      for (; n != 0; n = synthesized_gnu_hash_->chain[n]) {
+        action(synthesized_gnu_hash_->hashes[n] >> 1);
+      }
+    }
+  } else {
+    for (size_t n = 1; n < nchain_; ++n) {
+      if (is_symbol_hashed(symtab_ + n)) {
+        SymbolName symbol_name(get_string(symtab_[n].st_name));
+        action(symbol_name.gnu_hash() >> 1);
+      }
+    }
+  }
+}
+
 soinfo::soinfo(android_namespace_t* ns, const char* realpath,
                const struct stat* file_stat, off64_t file_offset,
                int rtld_flags) {
@@ -944,10 +1731,14 @@ soinfo::soinfo(android_namespace_t* ns, const char* realpath,
 
   this->rtld_flags_ = rtld_flags;
   this->primary_namespace_ = ns;
+  this->synthesized_gnu_hash_ = nullptr;
+  this->lazy_got_ = nullptr;
+  this->bind_now_ = false;
 }
 
 soinfo::~soinfo() {
   g_soinfo_handles_map.erase(handle_);
+  delete synthesized_gnu_hash_;
 }
 
 static uint32_t calculate_elf_hash(const char* name) {
@@ -988,12 +1779,113 @@ uint32_t SymbolName::gnu_hash() {
   return gnu_hash_;
 }
 
+// hybris: bloom filter of the symbols of all the libraries of the groups a
+// dlopen() links against, so that lookups of symbols none of them has,
+// like undefined weak ones, take one probe rather than one per library.
+// Built on the first lookup, from the GNU hashes of the libraries.
+class GroupBloomFilter {
+ public:
+  GroupBloomFilter() : global_group_(nullptr), local_group_(nullptr), built_(false), shift_(0) {}
+
+  // Must be called before linking the libraries of the local group.
+  void open(const soinfo::soinfo_list_t& global_group, const soinfo::soinfo_list_t& local_group) {
+    global_group_ = &global_group;
+    local_group_ = &local_group;
+    built_ = false;
+  }
+
+  void close() {
+    global_group_ = nullptr;
+    local_group_ = nullptr;
+  }
+
+  // Returns false if no library of the groups defines a symbol named name.
+  bool may_contain(const soinfo::soinfo_list_t& global_group,
+                   const soinfo::soinfo_list_t& local_group, SymbolName& symbol_name) {
+    if (&global_group != global_group_ || &local_group != local_group_) {
+      return true;
+    }
+
+    if (!built_) {
+      build();
+    }
+
+    uint32_t key = symbol_name.gnu_hash() >> 1;
+    return test(key) && test(second_bit(key));
+  }
+
+ private:
+  static const size_t kWordBits = sizeof(unsigned long) * 8;
+
+  // The hashes of a GNU hash table miss their lowest bit, so the second
+  // bit is derived from the rest.
+  uint32_t second_bit(uint32_t key) const {
+    return (key * 0x9e3779b1U) >> shift_;
+  }
+
+  bool test(uint32_t bit) const {
+    bit &= bits_.size() * kWordBits - 1;
+    return (bits_[bit / kWordBits] >> (bit % kWordBits)) & 1;
+  }
+
+  void set(uint32_t bit) {
+    bit &= bits_.size() * kWordBits - 1;
+    bits_[bit / kWordBits] |= 1UL << (bit % kWordBits);
+  }
+
+  void build() {
+    size_t count = 0;
+    auto count_symbols = [&](soinfo* si) {
+      si->for_each_gnu_hash([&](uint32_t) {
+        count++;
+      });
+    };
+    global_group_->for_each(count_symbols);
+    local_group_->for_each(count_symbols);
+
+    // About 12 bits per symbol, for a few percent of false positives
+    size_t log2_bits = 6;
+    while ((static_cast<size_t>(1) << log2_bits) < count * 12 && log2_bits < 31) {
+      log2_bits++;
+    }
+
+    bits_.assign((static_cast<size_t>(1) << log2_bits) / kWordBits, 0);
+    shift_ = 32 - log2_bits;
+
+    auto add_symbols = [&](soinfo* si) {
+      si->for_each_gnu_hash([&](uint32_t key) {
+        set(key);
+        set(second_bit(key));
+      });
+    };
+    global_group_->for_each(add_symbols);
+    local_group_->for_each(add_symbols);
+
+    built_ = true;
+  }
+
+  const soinfo::soinfo_list_t* global_group_;
+  const soinfo::soinfo_list_t* local_group_;
+  bool built_;
+  uint32_t shift_;
+  std::vector<unsigned long> bits_;
+};
+
+static GroupBloomFilter g_group_bloom_filter;
+
 bool soinfo_do_lookup(soinfo* si_from, const char* name, const version_info* vi,
                       soinfo** si_found_in, const soinfo::soinfo_list_t& global_group,
                       const soinfo::soinfo_list_t& local_group, const ElfW(Sym)** symbol) {
   SymbolName symbol_name(name);
   const ElfW(Sym)* s = nullptr;
 
+  // hybris: see GroupBloomFilter
+  if (!g_group_bloom_filter.may_contain(global_group, local_group, symbol_name)) {
+    TRACE_TYPE(LOOKUP, "NOT FOUND %s in the global and local groups", name);
+    *symbol = nullptr;
+    return true;
+  }
+
   /* "This element's presence in a shared object library alters the dynamic linker's
    * symbol resolution algorithm for references within the library. Instead of starting
    * a symbol search with the executable file, the dynamic linker starts from the shared
@@ -1222,13 +2114,38 @@ class LoadTask {
     return elf_readers_map_;
   }
 
-  bool read(const char* realpath, off64_t file_size) {
-    ElfReader& elf_reader = get_elf_reader();
-    return elf_reader.Read(realpath, fd_, file_offset_, file_size);
+  // hybris: read() and load() may run on loader threads, they only look the
+  // reader up in the map, create_elf_reader() adds it beforehand.
+  void create_elf_reader() {
+    get_elf_reader();
+  }
+
+  void set_realpath(const std::string& realpath) {
+    realpath_ = realpath;
+  }
+
+  off64_t get_file_size() const {
+    return file_size_;
+  }
+
+  void set_file_size(off64_t file_size) {
+    file_size_ = file_size;
+  }
+
+  bool read() {
+    ElfReader& elf_reader = find_elf_reader();
+    if (!elf_reader.Read(realpath_.c_str(), fd_, file_offset_, file_size_)) {
+      return false;
+    }
+
+    // Start reading the segments from storage while the rest of the tree
+    // is being read, they are needed once the libraries are mapped.
+    elf_reader.Readahead();
+    return true;
   }
 
   bool load() {
-    ElfReader& elf_reader = get_elf_reader();
+    ElfReader& elf_reader = find_elf_reader();
     if (!elf_reader.Load(extinfo_)) {
       return false;
     }
@@ -1247,9 +2164,16 @@ class LoadTask {
   LoadTask(const char* name, soinfo* needed_by,
            std::unordered_map<const soinfo*, ElfReader>* readers_map)
     : name_(name), needed_by_(needed_by), si_(nullptr),
-      fd_(-1), close_fd_(false), file_offset_(0), elf_readers_map_(readers_map),
+      fd_(-1), close_fd_(false), file_offset_(0), file_size_(0), elf_readers_map_(readers_map),
       is_dt_needed_(false) {}
 
+  ElfReader& find_elf_reader() {
+    CHECK(si_ != nullptr);
+    auto it = elf_readers_map_->find(si_);
+    CHECK(it != elf_readers_map_->end());
+    return it->second;
+  }
+
   ~LoadTask() {
     if (fd_ != -1 && close_fd_) {
       close(fd_);
@@ -1263,6 +2187,8 @@ class LoadTask {
   int fd_;
   bool close_fd_;
   off64_t file_offset_;
+  off64_t file_size_;
+  std::string realpath_;
   std::unordered_map<const soinfo*, ElfReader>* elf_readers_map_;
   // TODO(dimitry): needed by workaround for http://b/26394120 (the grey-list)
   bool is_dt_needed_;
@@ -1811,11 +2737,39 @@ static void for_each_dt_needed(const ElfReader& elf_reader, F action) {
   }
 }
 
+// Sets DT_RUNPATH and DT_SONAME of a library that has just been read,
+// and queues its DT_NEEDED libraries.
+static void queue_dt_needed(LoadTask* task, LoadTaskList* load_tasks) {
+  soinfo* si = task->get_soinfo();
+
+  // find and set DT_RUNPATH and dt_soname
+  // Note that these field values are temporary and are
+  // going to be overwritten on soinfo::prelink_image
+  // with values from PT_LOAD segments.
+  const ElfReader& elf_reader = task->get_elf_reader();
+  for (const ElfW(Dyn)* d = elf_reader.dynamic(); d->d_tag != DT_NULL; ++d) {
+    if (d->d_tag == DT_RUNPATH) {
+      si->set_dt_runpath(elf_reader.get_string(d->d_un.d_val));
+    }
+    if (d->d_tag == DT_SONAME) {
+      si->set_soname(elf_reader.get_string(d->d_un.d_val));
+    }
+  }
+
+  for_each_dt_needed(task->get_elf_reader(), [&](const char* name) {
+    load_tasks->push_back(LoadTask::create(name, si, task->get_readers_map()));
+  });
+}
+
+// hybris: when deferred_reads is not null, the library is opened but not
+// read: the task is added to deferred_reads, and the caller reads it then
+// calls queue_dt_needed().
 static bool load_library(android_namespace_t* ns,
                          LoadTask* task,
                          LoadTaskList* load_tasks,
                          int rtld_flags,
-                         const std::string& realpath) {
+                         const std::string& realpath,
+                         LoadTaskList* deferred_reads) {
   off64_t file_offset = task->get_file_offset();
   const char* name = task->get_name();
   const android_dlextinfo* extinfo = task->get_extinfo();
@@ -1917,32 +2871,23 @@ static bool load_library(android_namespace_t* ns,
   }
 
   task->set_soinfo(si);
+  task->set_realpath(realpath);
+  task->set_file_size(file_stat.st_size);
+  task->create_elf_reader();
+
+  if (deferred_reads != nullptr) {
+    deferred_reads->push_back(task);
+    return true;
+  }
 
   // Read the ELF header and some of the segments.
-  if (!task->read(realpath.c_str(), file_stat.st_size)) {
+  if (!task->read()) {
     soinfo_free(si);
     task->set_soinfo(nullptr);
     return false;
   }
 
-  // find and set DT_RUNPATH and dt_soname
-  // Note that these field values are temporary and are
-  // going to be overwritten on soinfo::prelink_image
-  // with values from PT_LOAD segments.
-  const ElfReader& elf_reader = task->get_elf_reader();
-  for (const ElfW(Dyn)* d = elf_reader.dynamic(); d->d_tag != DT_NULL; ++d) {
-    if (d->d_tag == DT_RUNPATH) {
-      si->set_dt_runpath(elf_reader.get_string(d->d_un.d_val));
-    }
-    if (d->d_tag == DT_SONAME) {
-      si->set_soname(elf_reader.get_string(d->d_un.d_val));
-    }
-  }
-
-  for_each_dt_needed(task->get_elf_reader(), [&](const char* name) {
-    load_tasks->push_back(LoadTask::create(name, si, task->get_readers_map()));
-  });
-
+  queue_dt_needed(task, load_tasks);
   return true;
 }
 
@@ -1950,7 +2895,8 @@ static bool load_library(android_namespace_t* ns,
                          LoadTask* task,
                          ZipArchiveCache* zip_archive_cache,
                          LoadTaskList* load_tasks,
-                         int rtld_flags) {
+                         int rtld_flags,
+                         LoadTaskList* deferred_reads) {
   const char* name = task->get_name();
   soinfo* needed_by = task->get_needed_by();
   const android_dlextinfo* extinfo = task->get_extinfo();
@@ -1971,7 +2917,7 @@ static bool load_library(android_namespace_t* ns,
 
     task->set_fd(extinfo->library_fd, false);
     task->set_file_offset(file_offset);
-    return load_library(ns, task, load_tasks, rtld_flags, realpath);
+    return load_library(ns, task, load_tasks, rtld_flags, realpath, deferred_reads);
   }
 
   // Open the file.
@@ -1984,7 +2930,7 @@ static bool load_library(android_namespace_t* ns,
   task->set_fd(fd, true);
   task->set_file_offset(file_offset);
 
-  return load_library(ns, task, load_tasks, rtld_flags, realpath);
+  return load_library(ns, task, load_tasks, rtld_flags, realpath, deferred_reads);
 }
 
 // Returns true if library was found and false in 2 cases
@@ -2031,7 +2977,8 @@ static bool find_library_internal(android_namespace_t* ns,
                                   LoadTask* task,
                                   ZipArchiveCache* zip_archive_cache,
                                   LoadTaskList* load_tasks,
-                                  int rtld_flags) {
+                                  int rtld_flags,
+                                  LoadTaskList* deferred_reads) {
   soinfo* candidate;
 
   if (find_loaded_library_by_soname(ns, task->get_name(), &candidate)) {
@@ -2057,7 +3004,13 @@ static bool find_library_internal(android_namespace_t* ns,
   TRACE("[ \"%s\" find_loaded_library_by_soname failed (*candidate=%s@%p). Trying harder...]",
       task->get_name(), candidate == nullptr ? "n/a" : candidate->get_realpath(), candidate);
 
-  if (load_library(ns, task, zip_archive_cache, load_tasks, rtld_flags)) {
+  // A read failing later could not fall back to the candidate, so the
+  // library is read right away when there is one.
+  if (candidate != nullptr) {
+    deferred_reads = nullptr;
+  }
+
+  if (load_library(ns, task, zip_archive_cache, load_tasks, rtld_flags, deferred_reads)) {
     return true;
   } else {
     // In case we were unable to load the library but there
@@ -2123,6 +3076,70 @@ static void shuffle(std::vector<LoadTask*>* v) {
 }
 */
 
+// hybris: number of threads, the calling one included, reading and mapping
+// the libraries of a dependency tree, set by HYBRIS_LD_LOAD_THREADS. Opening
+// the files, and most of all faulting in their pages, waits on storage, so
+// it pays to have a few reads in flight.
+static size_t g_ld_load_threads = 4;
+
+// hybris: calls action for every task, on up to g_ld_load_threads threads.
+// No new task is started once an action failed; returns false if one did.
+template<typename F>
+static bool for_each_task_parallel(const LoadTaskList& tasks, F action) {
+  struct Work {
+    const LoadTaskList* tasks;
+    F* action;
+    std::atomic<size_t> next;
+    std::atomic<bool> failed;
+
+    static void* run(void* arg) {
+      Work* work = static_cast<Work*>(arg);
+      size_t i;
+
+      while (!work->failed.load(std::memory_order_relaxed) &&
+             (i = work->next.fetch_add(1, std::memory_order_relaxed)) < work->tasks->size()) {
+        if (!(*work->action)((*work->tasks)[i])) {
+          work->failed.store(true, std::memory_order_relaxed);
+        }
+      }
+
+      return nullptr;
+    }
+  };
+
+  size_t thread_count = std::min(g_ld_load_threads, tasks.size());
+  if (thread_count <= 1) {
+    for (LoadTask* task : tasks) {
+      if (!action(task)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Work work;
+  work.tasks = &tasks;
+  work.action = &action;
+  work.next.store(0);
+  work.failed.store(false);
+
+  // If a thread can't be created, the others take over its share
+  std::vector<pthread_t> threads(thread_count - 1);
+  size_t started = 0;
+  while (started < threads.size() &&
+         pthread_create(&threads[started], nullptr, Work::run, &work) == 0) {
+    started++;
+  }
+
+  Work::run(&work);
+
+  for (size_t i = 0; i < started; ++i) {
+    pthread_join(threads[i], nullptr);
+  }
+
+  return !work.failed.load();
+}
+
 // add_as_children - add first-level loaded libraries (i.e. library_names[], but
 // not their transitive dependencies) as children of the start_with library.
 // This is false when find_libraries is called for dlopen(), when newly loaded
@@ -2146,6 +3163,7 @@ static bool find_libraries(android_namespace_t* ns,
 
   // Construct global_group.
   soinfo::soinfo_list_t global_group = make_global_group(ns);
+  g_resolved_symbols.set_global_group(global_group);
 
   // If soinfos array is null allocate one on stack.
   // The array is needed in case of failure; for example
@@ -2178,37 +3196,73 @@ static bool find_libraries(android_namespace_t* ns,
 
   // Step 1: expand the list of load_tasks to include
   // all DT_NEEDED libraries (do not load them just yet)
-  for (size_t i = 0; i<load_tasks.size(); ++i) {
-    LoadTask* task = load_tasks[i];
-    soinfo* needed_by = task->get_needed_by();
+  //
+  // hybris: the tree is expanded one level at a time. The libraries of a
+  // level are found and opened in order, then the ones opened for the
+  // first time are read in parallel, and their DT_NEEDED queued in order,
+  // so that load_tasks ends up in the same breadth first order.
+  for (size_t level_start = 0; level_start < load_tasks.size(); ) {
+    size_t level_end = load_tasks.size();
+    LoadTaskList deferred_reads;
+
+    for (size_t i = level_start; i < level_end; ++i) {
+      LoadTask* task = load_tasks[i];
+      soinfo* needed_by = task->get_needed_by();
+
+      bool is_dt_needed = needed_by != nullptr && (needed_by != start_with || add_as_children);
+      task->set_extinfo(is_dt_needed ? nullptr : extinfo);
+      task->set_dt_needed(is_dt_needed);
+
+      if (!find_library_internal(ns, task, &zip_archive_cache, &load_tasks, rtld_flags,
+                                 &deferred_reads)) {
+        // Libraries opened for this level are not referenced yet
+        for (LoadTask* t : deferred_reads) {
+          soinfo_free(t->get_soinfo());
+        }
+        return false;
+      }
+    }
 
-    bool is_dt_needed = needed_by != nullptr && (needed_by != start_with || add_as_children);
-    task->set_extinfo(is_dt_needed ? nullptr : extinfo);
-    task->set_dt_needed(is_dt_needed);
+    bool all_read = for_each_task_parallel(deferred_reads, [](LoadTask* task) {
+      return task->read();
+    });
 
-    if(!find_library_internal(ns, task, &zip_archive_cache, &load_tasks, rtld_flags)) {
+    if (!all_read) {
+      for (LoadTask* t : deferred_reads) {
+        soinfo_free(t->get_soinfo());
+      }
       return false;
     }
 
-    soinfo* si = task->get_soinfo();
-
-    if (is_dt_needed) {
-      needed_by->add_child(si);
+    for (LoadTask* task : deferred_reads) {
+      queue_dt_needed(task, &load_tasks);
     }
 
-    if (si->is_linked()) {
-      si->increment_ref_count();
-    }
+    for (size_t i = level_start; i < level_end; ++i) {
+      LoadTask* task = load_tasks[i];
+      soinfo* needed_by = task->get_needed_by();
+      soinfo* si = task->get_soinfo();
 
-    // When ld_preloads is not null, the first
-    // ld_preloads_count libs are in fact ld_preloads.
-    if (ld_preloads != nullptr && soinfos_count < ld_preloads_count) {
-      ld_preloads->push_back(si);
-    }
+      if (task->is_dt_needed()) {
+        needed_by->add_child(si);
+      }
+
+      if (si->is_linked()) {
+        si->increment_ref_count();
+      }
+
+      // When ld_preloads is not null, the first
+      // ld_preloads_count libs are in fact ld_preloads.
+      if (ld_preloads != nullptr && soinfos_count < ld_preloads_count) {
+        ld_preloads->push_back(si);
+      }
 
-    if (soinfos_count < library_names_count) {
-      soinfos[soinfos_count++] = si;
+      if (soinfos_count < library_names_count) {
+        soinfos[soinfos_count++] = si;
+      }
     }
+
+    level_start = level_end;
   }
 
   // Step 2: Load libraries in random order (see b/24047022)
@@ -2226,10 +3280,14 @@ static bool find_libraries(android_namespace_t* ns,
   }
   //shuffle(&load_list);
 
-  for (auto&& task : load_list) {
-    if (!task->load()) {
-      return false;
-    }
+  // hybris: mapping the libraries is independent from one library to
+  // the next, and faulting in their first pages waits on storage.
+  bool all_loaded = for_each_task_parallel(load_list, [](LoadTask* task) {
+    return task->load();
+  });
+
+  if (!all_loaded) {
+    return false;
   }
 
   // Step 3: pre-link all DT_NEEDED libraries in breadth first order.
@@ -2265,9 +3323,15 @@ static bool find_libraries(android_namespace_t* ns,
   // the root of the local group was not linked.
   bool was_local_group_root_linked = local_group.front()->is_linked();
 
+  // hybris: see RelocationCache and GroupBloomFilter
+  g_relocation_cache.open(global_group, local_group);
+  g_group_bloom_filter.open(global_group, local_group);
+
+  // hybris: extinfo is about the library opened, not its dependencies:
+  // they would write their RELRO to the same file
   bool linked = local_group.visit([&](soinfo* si) {
     if (!si->is_linked()) {
-      if (!si->link_image(global_group, local_group, extinfo)) {
+      if (!si->link_image(global_group, local_group, si == soinfos[0] ? extinfo : nullptr)) {
         return false;
       }
     }
@@ -2275,6 +3339,9 @@ static bool find_libraries(android_namespace_t* ns,
     return true;
   });
 
+  g_relocation_cache.close(linked);
+  g_group_bloom_filter.close();
+
   if (linked) {
     local_group.for_each([](soinfo* si) {
       if (!si->is_linked()) {
@@ -2289,6 +3356,10 @@ static bool find_libraries(android_namespace_t* ns,
     local_group.front()->increment_ref_count();
   }
 
+  g_resolved_symbols.report(local_group.front()->get_realpath());
+  g_relocation_cache.report(local_group.front()->get_realpath());
+  g_lazy_binding.report(local_group.front()->get_realpath());
+
   return linked;
 }
 
@@ -2466,6 +3537,201 @@ void do_android_update_LD_LIBRARY_PATH(const char* ld_library_path) {
   parse_LD_LIBRARY_PATH(ld_library_path);
 }
 
+// hybris: automatic RELRO sharing, enabled by setting HYBRIS_RELRO_DIR to a
+// directory only the user can write to.
+//
+// The first process to dlopen() a library writes its GNU RELRO pages, once
+// relocated, to a file of the directory, followed by the address range the
+// library was loaded at, and maps them from there, as
+// ANDROID_DLEXT_WRITE_RELRO does. The next ones reserve the same range to
+// load the library, then map the pages that came out the same from the file,
+// as ANDROID_DLEXT_USE_RELRO does, so that they are shared instead of being
+// private dirty copies. Pages pointing to libraries loaded at other addresses
+// differ, and stay private. The file is rewritten when the library changes.
+class RelroSharing {
+ public:
+  RelroSharing() : fd_(-1), reserved_addr_(nullptr), reserved_size_(0), trailer_valid_(false) {}
+
+  void init(const char* dir) {
+    dir_ = dir;
+  }
+
+  // Returns the extinfo to dlopen() name with, or nullptr to dlopen() it as
+  // usual. Either way, end() must be called once it is loaded.
+  const android_dlextinfo* begin(const char* name, android_dlextinfo* extinfo) {
+    path_.clear();
+    if (dir_.empty() || name == nullptr) {
+      return nullptr;
+    }
+
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "/%016" PRIx64 "-%zu.relro", hash(name), sizeof(void*) * 8);
+    path_ = dir_ + file_name;
+
+    fd_ = TEMP_FAILURE_RETRY(open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd_ == -1 || !read_trailer()) {
+      return nullptr;
+    }
+
+    // Another process has the range, if this one can't, don't bother
+    void* start = reinterpret_cast<void*>(static_cast<uintptr_t>(trailer_.load_start));
+    size_t size = trailer_.load_size;
+    void* reserved = mmap(start, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserved != start) {
+      if (reserved != MAP_FAILED) {
+        munmap(reserved, size);
+      }
+      return nullptr;
+    }
+
+    reserved_addr_ = start;
+    reserved_size_ = size;
+
+    memset(extinfo, 0, sizeof(*extinfo));
+    extinfo->flags = ANDROID_DLEXT_RESERVED_ADDRESS_HINT | ANDROID_DLEXT_USE_RELRO;
+    extinfo->reserved_addr = reserved_addr_;
+    extinfo->reserved_size = reserved_size_;
+    extinfo->relro_fd = fd_;
+    return extinfo;
+  }
+
+  // si is the library loaded, or nullptr if it couldn't be.
+  void end(soinfo* si) {
+    if (path_.empty()) {
+      return;
+    }
+
+    // Give back what the library doesn't use of the range
+    if (reserved_addr_ != nullptr) {
+      if (si != nullptr && reinterpret_cast<void*>(si->base) == reserved_addr_) {
+        if (si->size < reserved_size_) {
+          munmap(static_cast<char*>(reserved_addr_) + si->size, reserved_size_ - si->size);
+        }
+      } else {
+        munmap(reserved_addr_, reserved_size_);
+      }
+    }
+
+    if (si != nullptr && !(trailer_valid_ && is_same_file(si))) {
+      write_file(si);
+    }
+
+    if (fd_ != -1) {
+      close(fd_);
+    }
+
+    fd_ = -1;
+    reserved_addr_ = nullptr;
+    reserved_size_ = 0;
+    trailer_valid_ = false;
+    path_.clear();
+  }
+
+ private:
+  static const uint32_t kMagic = 0x4f524248; // "HBRO"
+  static const uint32_t kVersion = 1;
+
+  // At the end of the file, after the RELRO pages
+  struct Trailer {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t load_start;
+    uint64_t load_size;
+    uint64_t st_dev;
+    uint64_t st_ino;
+    uint64_t st_size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+  };
+
+  static uint64_t hash(const char* name) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char* p = name; *p != '\0'; ++p) {
+      h = (h ^ static_cast<uint8_t>(*p)) * 0x100000001b3ULL;
+    }
+    return h;
+  }
+
+  bool read_trailer() {
+    struct stat file_stat;
+    if (fstat(fd_, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(trailer_))) {
+      return false;
+    }
+
+    off_t offset = file_stat.st_size - sizeof(trailer_);
+    trailer_valid_ = TEMP_FAILURE_RETRY(pread(fd_, &trailer_, sizeof(trailer_), offset)) == sizeof(trailer_) &&
+                     trailer_.magic == kMagic && trailer_.version == kVersion &&
+                     trailer_.load_start == static_cast<uint64_t>(PAGE_START(trailer_.load_start)) &&
+                     trailer_.load_size <= SIZE_MAX;
+    return trailer_valid_;
+  }
+
+  static bool stat_library(soinfo* si, struct stat* file_stat) {
+    return stat(si->get_realpath(), file_stat) == 0 &&
+           file_stat->st_dev == si->get_st_dev() && file_stat->st_ino == si->get_st_ino();
+  }
+
+  bool is_same_file(soinfo* si) const {
+    struct stat file_stat;
+    return stat_library(si, &file_stat) &&
+           trailer_.st_dev == static_cast<uint64_t>(file_stat.st_dev) &&
+           trailer_.st_ino == static_cast<uint64_t>(file_stat.st_ino) &&
+           trailer_.st_size == static_cast<uint64_t>(file_stat.st_size) &&
+           trailer_.mtime_sec == file_stat.st_mtim.tv_sec &&
+           trailer_.mtime_nsec == file_stat.st_mtim.tv_nsec;
+  }
+
+  void write_file(soinfo* si) {
+    struct stat file_stat;
+    if (!stat_library(si, &file_stat)) {
+      return;
+    }
+
+    Trailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.magic = kMagic;
+    trailer.version = kVersion;
+    trailer.load_start = si->base;
+    trailer.load_size = si->size;
+    trailer.st_dev = file_stat.st_dev;
+    trailer.st_ino = file_stat.st_ino;
+    trailer.st_size = file_stat.st_size;
+    trailer.mtime_sec = file_stat.st_mtim.tv_sec;
+    trailer.mtime_nsec = file_stat.st_mtim.tv_nsec;
+
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", getpid());
+    std::string tmp_path = path_ + suffix;
+
+    int fd = TEMP_FAILURE_RETRY(open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (fd == -1) {
+      return;
+    }
+
+    // This also maps the pages from the file, here too
+    bool written = phdr_table_serialize_gnu_relro(si->phdr, si->phnum, si->load_bias, fd) == 0 &&
+                   TEMP_FAILURE_RETRY(write(fd, &trailer, sizeof(trailer))) == sizeof(trailer);
+    close(fd);
+
+    // Other processes see either the old file or the whole new one
+    if (!written || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+      unlink(tmp_path.c_str());
+    }
+  }
+
+  std::string dir_;
+
+  // The library being loaded
+  std::string path_;
+  int fd_;
+  void* reserved_addr_;
+  size_t reserved_size_;
+  Trailer trailer_;
+  bool trailer_valid_;
+};
+
+static RelroSharing g_relro_sharing;
+
 void* do_dlopen(const char* name, int flags, const android_dlextinfo* extinfo,
                   void* caller_addr) {
   soinfo* const caller = find_containing_library(caller_addr);
@@ -2531,9 +3797,20 @@ void* do_dlopen(const char* name, int flags, const android_dlextinfo* extinfo,
     }
   }
 
+  // hybris: see RelroSharing
+  android_dlextinfo relro_extinfo;
+  bool share_relro = extinfo == nullptr && (flags & RTLD_NOLOAD) == 0;
+  if (share_relro) {
+    extinfo = g_relro_sharing.begin(translated_name, &relro_extinfo);
+  }
+
   ProtectedDataGuard guard;
   reset_g_active_shim_libs();
   soinfo* si = find_library(ns, translated_name, flags, extinfo, caller);
+  if (share_relro) {
+    g_relro_sharing.end(si);
+  }
+
   if (si != nullptr) {
     si->call_constructors();
     return si->to_handle();
@@ -2565,6 +3842,12 @@ int do_dladdr(const void* addr, Dl_info* info) {
   return 1;
 }
 
+// hybris: hook results only depend on the requester with a hook callback,
+// see ResolvedSymbolCache
+void do_hook_callback_changed(bool has_callback) {
+  g_resolved_symbols.set_hook_callback(has_callback);
+}
+
 static soinfo* soinfo_from_handle(void* handle) {
   if ((reinterpret_cast<uintptr_t>(handle) & 1) != 0) {
     auto it = g_soinfo_handles_map.find(reinterpret_cast<uintptr_t>(handle));
@@ -2903,16 +4186,29 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
 
     if (sym != 0) {
       sym_name = get_string(symtab_[sym].st_name);
+      SymbolName symbol_name(sym_name);
+      uint32_t hash = symbol_name.gnu_hash();
+
+      if (!g_resolved_symbols.find_hook(hash, sym_name, this, &sym_addr)) {
+        sym_addr = reinterpret_cast<ElfW(Addr)>(_get_hooked_symbol(sym_name, get_realpath()));
+        g_resolved_symbols.add_hook(hash, sym_name, this, sym_addr);
+      }
 
-      sym_addr = reinterpret_cast<ElfW(Addr)>(_get_hooked_symbol(sym_name, get_realpath()));
       if (!sym_addr) {
-        if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
-          return false;
-        }
+        if (!g_relocation_cache.find(sym_name, &lsi, &s)) {
+          if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
+            return false;
+          }
 
-        if (!soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
-          return false;
+          if (!g_resolved_symbols.lookup(this, hash, sym_name, vi, &lsi,
+                                         global_group, local_group, &s)) {
+            return false;
+          }
+
+          g_relocation_cache.add(lsi, s);
         }
+      } else {
+        g_relocation_cache.skip();
       }
 
       if (sym_addr == 0 && s == nullptr) {
@@ -3574,6 +4870,37 @@ bool soinfo::is_gnu_hash() const {
   return (flags_ & FLAG_GNU_HASH) != 0;
 }
 
+size_t soinfo::get_symbol_index(const ElfW(Sym)* s) const {
+  return s - symtab_;
+}
+
+// Returns the symbol at index if it is defined and named name, nullptr
+// otherwise. The index comes from a file, so it is checked against the
+// size of the symbol table.
+const ElfW(Sym)* soinfo::find_symbol_by_index(size_t index, const char* name) const {
+  size_t count;
+  if (!is_gnu_hash()) {
+    count = nchain_;
+  } else if (reinterpret_cast<uintptr_t>(strtab_) > reinterpret_cast<uintptr_t>(symtab_)) {
+    // The GNU hash table doesn't tell, but .dynstr follows .dynsym
+    count = (reinterpret_cast<uintptr_t>(strtab_) - reinterpret_cast<uintptr_t>(symtab_)) /
+            sizeof(ElfW(Sym));
+  } else {
+    return nullptr;
+  }
+
+  if (index >= count) {
+    return nullptr;
+  }
+
+  const ElfW(Sym)* s = symtab_ + index;
+  if (s->st_shndx == SHN_UNDEF || (has_min_version(1) && s->st_name >= strtab_size_)) {
+    return nullptr;
+  }
+
+  return strcmp(strtab_ + s->st_name, name) == 0 ? s : nullptr;
+}
+
 bool soinfo::can_unload() const {
   return !is_linked() || ((get_rtld_flags() & (RTLD_NODELETE | RTLD_GLOBAL)) == 0);
 }
@@ -3798,7 +5125,8 @@ bool soinfo::prelink_image() {
         // Used by mips and mips64.
         plt_got_ = reinterpret_cast<ElfW(Addr)**>(load_bias + d->d_un.d_ptr);
 #endif
-        // Ignore for other platforms... (because RTLD_LAZY is not supported)
+        // hybris: and by lazy binding, see LazyBinding
+        lazy_got_ = reinterpret_cast<ElfW(Addr)*>(load_bias + d->d_un.d_ptr);
         break;
 
       case DT_DEBUG:
@@ -3973,6 +5301,9 @@ bool soinfo::prelink_image() {
         if (d->d_un.d_val & DF_SYMBOLIC) {
           has_DT_SYMBOLIC = true;
         }
+        if (d->d_un.d_val & DF_BIND_NOW) {
+          bind_now_ = true;
+        }
         break;
 
       case DT_FLAGS_1:
@@ -4017,8 +5348,9 @@ bool soinfo::prelink_image() {
         mips_gotsym_ = d->d_un.d_val;
         break;
 #endif
-      // Ignored: "Its use has been superseded by the DF_BIND_NOW flag"
+      // "Its use has been superseded by the DF_BIND_NOW flag"
       case DT_BIND_NOW:
+        bind_now_ = true;
         break;
 
       case DT_VERSYM:
@@ -4106,6 +5438,11 @@ bool soinfo::prelink_image() {
         get_realpath(), soname_);
     // Don't call add_dlwarning because a missing DT_SONAME isn't important enough to show in the UI
   }
+
+  // hybris: see SynthesizedGnuHash
+  if (!is_gnu_hash() && !relocating_linker) {
+    synthesize_gnu_hash();
+  }
   return true;
 }
 
@@ -4155,6 +5492,12 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
   }
 #endif
 
+  // hybris: see RelocationCache
+  g_relocation_cache.begin(this);
+  auto relocation_cache_guard = make_scope_guard([]() {
+    g_relocation_cache.abort();
+  });
+
   if (android_relocs_ != nullptr) {
     // check signature
     if (android_relocs_size_ > 3 &&
@@ -4192,10 +5535,16 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
     }
   }
   if (plt_rela_ != nullptr) {
-    DEBUG("[ relocating %s plt ]", get_realpath());
-    if (!relocate(version_tracker,
-            plain_reloc_iterator(plt_rela_, plt_rela_count_), global_group, local_group)) {
-      return false;
+    // hybris: see LazyBinding
+    if (can_bind_lazily()) {
+      DEBUG("[ deferring %s plt ]", get_realpath());
+      g_lazy_binding.add_deferred(defer_plt_relocations(global_group, local_group));
+    } else {
+      DEBUG("[ relocating %s plt ]", get_realpath());
+      if (!relocate(version_tracker,
+              plain_reloc_iterator(plt_rela_, plt_rela_count_), global_group, local_group)) {
+        return false;
+      }
     }
   }
 #else
@@ -4207,10 +5556,16 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
     }
   }
   if (plt_rel_ != nullptr) {
-    DEBUG("[ relocating %s plt ]", get_realpath());
-    if (!relocate(version_tracker,
-            plain_reloc_iterator(plt_rel_, plt_rel_count_), global_group, local_group)) {
-      return false;
+    // hybris: see LazyBinding
+    if (can_bind_lazily()) {
+      DEBUG("[ deferring %s plt ]", get_realpath());
+      g_lazy_binding.add_deferred(defer_plt_relocations(global_group, local_group));
+    } else {
+      DEBUG("[ relocating %s plt ]", get_realpath());
+      if (!relocate(version_tracker,
+              plain_reloc_iterator(plt_rel_, plt_rel_count_), global_group, local_group)) {
+        return false;
+      }
     }
   }
 #endif
@@ -4221,6 +5576,9 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
   }
 #endif
 
+  g_relocation_cache.commit();
+  relocation_cache_guard.disable();
+
   DEBUG("[ finished linking %s ]", get_realpath());
 
 #if !defined(__LP64__)
@@ -4270,6 +5628,147 @@ bool soinfo::protect_relro() {
   return true;
 }
 
+bool soinfo::can_bind_lazily() const {
+#if defined(HAVE_LAZY_BIND_TRAMPOLINE)
+  if (!g_lazy_binding.enabled() || (get_rtld_flags() & RTLD_LAZY) == 0 ||
+      bind_now_ || (get_dt_flags_1() & DF_1_NOW) != 0 || lazy_got_ == nullptr) {
+    return false;
+  }
+
+#if defined(USE_RELA)
+  const ElfW(Rela)* rel = plt_rela_;
+  size_t count = plt_rela_count_;
+#else
+  const ElfW(Rel)* rel = plt_rel_;
+  size_t count = plt_rel_count_;
+#endif
+
+  if (count == 0) {
+    return false;
+  }
+
+  ElfW(Addr) first_slot = rel[0].r_offset;
+  ElfW(Addr) last_slot = rel[0].r_offset;
+  for (size_t i = 0; i < count; ++i) {
+    if (ELFW(R_TYPE)(rel[i].r_info) != R_GENERIC_JUMP_SLOT || ELFW(R_SYM)(rel[i].r_info) == 0) {
+      return false;
+    }
+#if defined(__aarch64__)
+    // Functions of the SVE vector ABI take arguments the trampoline doesn't save
+    if ((symtab_[ELFW(R_SYM)(rel[i].r_info)].st_other & STO_AARCH64_VARIANT_PCS) != 0) {
+      return false;
+    }
+#endif
+    first_slot = std::min(first_slot, static_cast<ElfW(Addr)>(rel[i].r_offset));
+    last_slot = std::max(last_slot, static_cast<ElfW(Addr)>(rel[i].r_offset));
+  }
+
+  // The slots are patched long after protect_relro(). The header of the
+  // GOT may be in the RELRO segment, it is set up before.
+  for (size_t i = 0; i < phnum; ++i) {
+    if (phdr[i].p_type == PT_GNU_RELRO &&
+        last_slot + sizeof(ElfW(Addr)) > phdr[i].p_vaddr &&
+        first_slot < phdr[i].p_vaddr + phdr[i].p_memsz) {
+      return false;
+    }
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t soinfo::defer_plt_relocations(const soinfo_list_t& global_group,
+                                     const soinfo_list_t& local_group) {
+  g_lazy_binding.pin_scope(this, global_group, local_group);
+
+#if defined(HAVE_LAZY_BIND_TRAMPOLINE)
+  // Read by the PLT header, see linker_lazy_bind.cpp
+  lazy_got_[1] = reinterpret_cast<ElfW(Addr)>(this);
+  lazy_got_[2] = lazy_bind_trampoline();
+#endif
+
+#if defined(USE_RELA)
+  const ElfW(Rela)* rel = plt_rela_;
+  size_t count = plt_rela_count_;
+#else
+  const ElfW(Rel)* rel = plt_rel_;
+  size_t count = plt_rel_count_;
+#endif
+
+  for (size_t i = 0; i < count; ++i) {
+    // The slots hold the address in the PLT that pushes their index
+    ElfW(Addr)* slot = reinterpret_cast<ElfW(Addr)*>(rel[i].r_offset + load_bias);
+    *slot += load_bias;
+    g_relocation_cache.skip();
+  }
+
+  return count;
+}
+
+ElfW(Addr) soinfo::bind_lazy_slot(size_t index) {
+#if defined(USE_RELA)
+  if (index >= plt_rela_count_) {
+    __libc_fatal("\"%s\": bad PLT slot %zu", get_realpath(), index);
+  }
+  const ElfW(Rela)* rel = plt_rela_ + index;
+  ElfW(Addr) addend = rel->r_addend;
+#else
+  if (index >= plt_rel_count_) {
+    __libc_fatal("\"%s\": bad PLT slot %zu", get_realpath(), index);
+  }
+  const ElfW(Rel)* rel = plt_rel_ + index;
+  ElfW(Addr) addend = 0;
+#endif
+
+  ElfW(Word) sym = ELFW(R_SYM)(rel->r_info);
+  ElfW(Addr)* slot = reinterpret_cast<ElfW(Addr)*>(rel->r_offset + load_bias);
+  const char* sym_name = get_string(symtab_[sym].st_name);
+
+  // Hooks first, like when linking
+  ElfW(Addr) sym_addr = reinterpret_cast<ElfW(Addr)>(_get_hooked_symbol(sym_name, get_realpath()));
+
+  if (!sym_addr) {
+    VersionTracker version_tracker;
+    const version_info* vi = nullptr;
+    bool ifunc = false;
+
+    if (!version_tracker.init(this) ||
+        !lookup_version_info(version_tracker, sym, sym_name, &vi) ||
+        !g_lazy_binding.lookup(this, sym_name, vi, &sym_addr, &ifunc)) {
+      __libc_fatal("\"%s\": cannot bind \"%s\": %s", get_realpath(), sym_name,
+                   linker_get_error_buffer());
+    }
+
+    if (ifunc) {
+      sym_addr = call_ifunc_resolver(sym_addr);
+    } else if (sym_addr == 0 && ELF_ST_BIND(symtab_[sym].st_info) != STB_WEAK) {
+      __libc_fatal("cannot locate symbol \"%s\" referenced by \"%s\"...", sym_name, get_realpath());
+    }
+  }
+
+  // Another thread may be binding it too
+  ElfW(Addr) value = sym_addr + addend;
+  ElfW(Addr) unbound = __atomic_load_n(slot, __ATOMIC_RELAXED);
+  if (unbound != value &&
+      __atomic_compare_exchange_n(slot, &unbound, value, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    TRACE_TYPE(RELO, "RELO JMP_SLOT %16p <- %16p %s (lazy)",
+               reinterpret_cast<void*>(slot), reinterpret_cast<void*>(value), sym_name);
+    g_lazy_binding.add_bound();
+  }
+
+  return value;
+}
+
+ElfW(Addr) do_lazy_bind(soinfo* si, size_t index) {
+  // The function bound may be about to read errno
+  int saved_errno = errno;
+  ElfW(Addr) value = si->bind_lazy_slot(index);
+  errno = saved_errno;
+  return value;
+}
+
 /*
  * This function add vdso to internal dso list.
  * It helps to stack unwinding through signal handlers.
@@ -4631,11 +6130,36 @@ extern "C" void android_linker_init(int sdk_version, void* (*get_hooked_symbol)(
     g_ld_debug_verbosity = atoi(LD_DEBUG);
   }
 
+  const char* LD_LOAD_THREADS = getenv("HYBRIS_LD_LOAD_THREADS");
+  if (LD_LOAD_THREADS != nullptr) {
+    g_ld_load_threads = strtoul(LD_LOAD_THREADS, nullptr, 10);
+  }
+
+  const char* LD_BIND_LAZY = getenv("HYBRIS_LD_BIND_LAZY");
+  if (LD_BIND_LAZY != nullptr && atoi(LD_BIND_LAZY) != 0) {
+    g_lazy_binding.init();
+    atexit([]() {
+      g_lazy_binding.report(nullptr);
+    });
+  }
+
   const char* ldpath_env = nullptr;
   const char* ldpreload_env = nullptr;
+  const char* ldreloccache_env = nullptr;
+  const char* relrodir_env = nullptr;
   if (!getauxval(AT_SECURE)) {
     ldpath_env = getenv("HYBRIS_LD_LIBRARY_PATH");
     ldpreload_env = getenv("HYBRIS_LD_PRELOAD");
+    ldreloccache_env = getenv("HYBRIS_LD_RELOC_CACHE");
+    relrodir_env = getenv("HYBRIS_RELRO_DIR");
+  }
+
+  if (ldreloccache_env != nullptr) {
+    g_relocation_cache.init(ldreloccache_env);
+  }
+
+  if (relrodir_env != nullptr) {
+    g_relro_sharing.init(relrodir_env);
   }
 
   if (DEFAULT_HYBRIS_LD_LIBRARY_PATH)
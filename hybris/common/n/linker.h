@@ -184,6 +184,8 @@ class VersionTracker {
   DISALLOW_COPY_AND_ASSIGN(VersionTracker);
 };
 
+struct SynthesizedGnuHash;
+
 struct soinfo {
  public:
   typedef LinkedList<soinfo, SoinfoListAllocator> soinfo_list_t;
@@ -322,8 +324,16 @@ struct soinfo {
   ElfW(Addr) resolve_symbol_address(const ElfW(Sym)* s) const;
 
   const char* get_string(ElfW(Word) index) const;
+  // hybris: used by the relocation cache, which records symbols by index
+  size_t get_symbol_index(const ElfW(Sym)* s) const;
+  const ElfW(Sym)* find_symbol_by_index(size_t index, const char* name) const;
   bool can_unload() const;
   bool is_gnu_hash() const;
+  // hybris: binds a PLT slot left for lazy binding, see LazyBinding
+  ElfW(Addr) bind_lazy_slot(size_t index);
+  // hybris: the GNU hashes of the symbols, for lookup filters
+  template<typename F>
+  void for_each_gnu_hash(F action) const;
 
   bool inline has_min_version(uint32_t min_version) const {
 #if defined(__work_around_b_24465209__)
@@ -378,6 +388,14 @@ struct soinfo {
   ElfW(Sym)* elf_addr_lookup(const void* addr);
   bool gnu_lookup(SymbolName& symbol_name, const version_info* vi, uint32_t* symbol_index) const;
   ElfW(Sym)* gnu_addr_lookup(const void* addr);
+  // hybris: GNU hash lookups in libraries that only have a SysV hash
+  void synthesize_gnu_hash();
+  bool synthesized_gnu_lookup(SymbolName& symbol_name, const version_info* vi,
+                              uint32_t* symbol_index) const;
+  // hybris: see LazyBinding
+  bool can_bind_lazily() const;
+  size_t defer_plt_relocations(const soinfo_list_t& global_group,
+                               const soinfo_list_t& local_group);
 
   bool lookup_version_info(const VersionTracker& version_tracker, ElfW(Word) sym,
                            const char* sym_name, const version_info** vi);
@@ -440,6 +458,11 @@ struct soinfo {
   android_namespace_list_t secondary_namespaces_;
   uintptr_t handle_;
 
+  // hybris
+  SynthesizedGnuHash* synthesized_gnu_hash_;
+  ElfW(Addr)* lazy_got_;
+  bool bind_now_;
+
   friend soinfo* get_libdl_info();
 };
 
@@ -471,6 +494,12 @@ bool do_dlsym(void* handle, const char* sym_name, const char* sym_ver,
 
 int do_dladdr(const void* addr, Dl_info* info);
 
+// hybris: see ResolvedSymbolCache
+void do_hook_callback_changed(bool has_callback);
+
+// hybris: see LazyBinding
+ElfW(Addr) do_lazy_bind(soinfo* si, size_t index);
+
 void debuggerd_init();
 extern "C" abort_msg_t* g_abort_message;
 
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "linker_lazy_bind.h"
+
+// The trampolines expect the PLT headers the GNU linkers and lld emit, see
+// the psABI of each architecture. They are entered with the stack of the
+// call to the PLT, plus what the PLT pushed, and leave with that stack as
+// it was at the call: the function bound returns straight to the caller.
+
+#if defined(__arm__)
+
+// [sp] = lr of the caller, lr = &GOT[2], ip = &GOT[n + 3].
+// r0-r3 hold the arguments, d0-d7 too with the hard-float ABI.
+asm(
+  "  .pushsection .text\n"
+  "  .arm\n"
+  "  .align 2\n"
+  "  .globl __hybris_lazy_bind_trampoline\n"
+  "  .hidden __hybris_lazy_bind_trampoline\n"
+  "  .type __hybris_lazy_bind_trampoline, %function\n"
+  "__hybris_lazy_bind_trampoline:\n"
+  // r4 is only saved to keep sp 8-byte aligned
+  "  push {r0-r4}\n"
+#if defined(__ARM_PCS_VFP)
+  "  vpush {d0-d7}\n"
+#endif
+  "  ldr r0, [lr, #-4]\n"
+  "  sub r1, ip, lr\n"
+  "  sub r1, r1, #4\n"
+  "  lsr r1, r1, #2\n"
+  "  bl __hybris_lazy_bind\n"
+  "  mov ip, r0\n"
+#if defined(__ARM_PCS_VFP)
+  "  vpop {d0-d7}\n"
+#endif
+  "  pop {r0-r4}\n"
+  "  pop {lr}\n"
+  "  bx ip\n"
+  "  .size __hybris_lazy_bind_trampoline, .-__hybris_lazy_bind_trampoline\n"
+  "  .popsection\n"
+);
+
+#elif defined(__aarch64__)
+
+// [sp] = &GOT[n + 3], [sp, #8] = lr of the caller, x16 = &GOT[2].
+// x0-x7 and q0-q7 hold the arguments, x8 the address of a returned struct.
+// Functions taking SVE registers are bound when linked, see
+// soinfo::can_bind_lazily().
+asm(
+  "  .pushsection .text\n"
+  "  .align 2\n"
+  "  .globl __hybris_lazy_bind_trampoline\n"
+  "  .hidden __hybris_lazy_bind_trampoline\n"
+  "  .type __hybris_lazy_bind_trampoline, %function\n"
+  "__hybris_lazy_bind_trampoline:\n"
+  // bti c, a nop without BTI: the PLT header branches here with br x17
+  "  hint #34\n"
+  "  sub sp, sp, #208\n"
+  "  stp x0, x1, [sp, #0]\n"
+  "  stp x2, x3, [sp, #16]\n"
+  "  stp x4, x5, [sp, #32]\n"
+  "  stp x6, x7, [sp, #48]\n"
+  "  str x8, [sp, #64]\n"
+  "  stp q0, q1, [sp, #80]\n"
+  "  stp q2, q3, [sp, #112]\n"
+  "  stp q4, q5, [sp, #144]\n"
+  "  stp q6, q7, [sp, #176]\n"
+  "  ldur x0, [x16, #-8]\n"
+  "  ldr x1, [sp, #208]\n"
+  "  sub x1, x1, x16\n"
+  "  sub x1, x1, #8\n"
+  "  lsr x1, x1, #3\n"
+  "  bl __hybris_lazy_bind\n"
+  "  mov x17, x0\n"
+  "  ldp x0, x1, [sp, #0]\n"
+  "  ldp x2, x3, [sp, #16]\n"
+  "  ldp x4, x5, [sp, #32]\n"
+  "  ldp x6, x7, [sp, #48]\n"
+  "  ldr x8, [sp, #64]\n"
+  "  ldp q0, q1, [sp, #80]\n"
+  "  ldp q2, q3, [sp, #112]\n"
+  "  ldp q4, q5, [sp, #144]\n"
+  "  ldp q6, q7, [sp, #176]\n"
+  "  add sp, sp, #208\n"
+  "  ldp x16, x30, [sp], #16\n"
+  "  br x17\n"
+  "  .size __hybris_lazy_bind_trampoline, .-__hybris_lazy_bind_trampoline\n"
+  "  .popsection\n"
+);
+
+#elif defined(__i386__)
+
+// (%esp) = GOT[1], 4(%esp) = offset of the relocation in DT_JMPREL,
+// 8(%esp) = return address. Arguments are on the stack, and in eax, ecx
+// and edx for regparm and fastcall functions.
+asm(
+  "  .pushsection .text\n"
+  "  .align 16\n"
+  "  .globl __hybris_lazy_bind_trampoline\n"
+  "  .hidden __hybris_lazy_bind_trampoline\n"
+  "  .type __hybris_lazy_bind_trampoline, @function\n"
+  "__hybris_lazy_bind_trampoline:\n"
+  "  pushl %eax\n"
+  "  pushl %ecx\n"
+  "  pushl %edx\n"
+  "  movl 16(%esp), %edx\n"
+  "  shrl $3, %edx\n"
+  "  movl 12(%esp), %eax\n"
+  "  pushl %edx\n"
+  "  pushl %eax\n"
+  "  call __hybris_lazy_bind\n"
+  "  addl $8, %esp\n"
+  // Leaves the function where ecx was saved, and returns to it, dropping
+  // what the PLT pushed
+  "  popl %edx\n"
+  "  movl (%esp), %ecx\n"
+  "  movl %eax, (%esp)\n"
+  "  movl 4(%esp), %eax\n"
+  "  ret $12\n"
+  "  .size __hybris_lazy_bind_trampoline, .-__hybris_lazy_bind_trampoline\n"
+  "  .popsection\n"
+);
+
+#elif defined(__x86_64__)
+
+#include <cpuid.h>
+
+// (%rsp) = GOT[1], 8(%rsp) = index of the relocation, 16(%rsp) = return
+// address. rdi, rsi, rdx, rcx, r8, r9 and xmm0-xmm7 hold the arguments, al
+// the number of vector registers used by a variadic call. Arguments may be
+// passed in ymm0-ymm7 or zmm0-zmm7 too, and the lookup may clobber their
+// upper halves (vzeroupper in the AVX2 string functions of libc, say), so
+// the vector state is saved with xsave where the CPU supports it, like
+// _dl_runtime_resolve_xsave of glibc does. Without it there are no AVX
+// registers to save and the xmm ones are saved by hand.
+
+// Saved by xsave: SSE, AVX, MPX and AVX-512 state
+#define LAZY_BIND_XSAVE_MASK "0xee"
+
+// Size of the stack frame of the xsave trampoline: the general purpose
+// registers, then the XSAVE area for the features enabled by the kernel.
+extern "C" size_t __hybris_lazy_bind_frame_size __attribute__((visibility("hidden")));
+size_t __hybris_lazy_bind_frame_size;
+
+// Without xsave
+asm(
+  "  .pushsection .text\n"
+  "  .align 16\n"
+  "  .globl __hybris_lazy_bind_trampoline_sse\n"
+  "  .hidden __hybris_lazy_bind_trampoline_sse\n"
+  "  .type __hybris_lazy_bind_trampoline_sse, @function\n"
+  "__hybris_lazy_bind_trampoline_sse:\n"
+  "  pushq %rax\n"
+  "  pushq %rcx\n"
+  "  pushq %rdx\n"
+  "  pushq %rsi\n"
+  "  pushq %rdi\n"
+  "  pushq %r8\n"
+  "  pushq %r9\n"
+  // rsp is 16-byte aligned from here
+  "  subq $128, %rsp\n"
+  "  movaps %xmm0, 0(%rsp)\n"
+  "  movaps %xmm1, 16(%rsp)\n"
+  "  movaps %xmm2, 32(%rsp)\n"
+  "  movaps %xmm3, 48(%rsp)\n"
+  "  movaps %xmm4, 64(%rsp)\n"
+  "  movaps %xmm5, 80(%rsp)\n"
+  "  movaps %xmm6, 96(%rsp)\n"
+  "  movaps %xmm7, 112(%rsp)\n"
+  "  movq 184(%rsp), %rdi\n"
+  "  movq 192(%rsp), %rsi\n"
+  "  call __hybris_lazy_bind\n"
+  "  movq %rax, %r11\n"
+  "  movaps 0(%rsp), %xmm0\n"
+  "  movaps 16(%rsp), %xmm1\n"
+  "  movaps 32(%rsp), %xmm2\n"
+  "  movaps 48(%rsp), %xmm3\n"
+  "  movaps 64(%rsp), %xmm4\n"
+  "  movaps 80(%rsp), %xmm5\n"
+  "  movaps 96(%rsp), %xmm6\n"
+  "  movaps 112(%rsp), %xmm7\n"
+  "  addq $128, %rsp\n"
+  "  popq %r9\n"
+  "  popq %r8\n"
+  "  popq %rdi\n"
+  "  popq %rsi\n"
+  "  popq %rdx\n"
+  "  popq %rcx\n"
+  "  popq %rax\n"
+  "  addq $16, %rsp\n"
+  "  jmp *%r11\n"
+  "  .size __hybris_lazy_bind_trampoline_sse, .-__hybris_lazy_bind_trampoline_sse\n"
+  "  .popsection\n"
+);
+
+asm(
+  "  .pushsection .text\n"
+  "  .align 16\n"
+  "  .globl __hybris_lazy_bind_trampoline_xsave\n"
+  "  .hidden __hybris_lazy_bind_trampoline_xsave\n"
+  "  .type __hybris_lazy_bind_trampoline_xsave, @function\n"
+  "__hybris_lazy_bind_trampoline_xsave:\n"
+  "  pushq %rbx\n"
+  "  movq %rsp, %rbx\n"
+  // The XSAVE area has to be 64-byte aligned
+  "  andq $-64, %rsp\n"
+  "  subq __hybris_lazy_bind_frame_size(%rip), %rsp\n"
+  "  movq %rax, 0(%rsp)\n"
+  "  movq %rcx, 8(%rsp)\n"
+  "  movq %rdx, 16(%rsp)\n"
+  "  movq %rsi, 24(%rsp)\n"
+  "  movq %rdi, 32(%rsp)\n"
+  "  movq %r8, 40(%rsp)\n"
+  "  movq %r9, 48(%rsp)\n"
+  // xsave doesn't write all of the XSAVE header, which xrstor checks
+  "  movq $0, 576(%rsp)\n"
+  "  movq $0, 584(%rsp)\n"
+  "  movq $0, 592(%rsp)\n"
+  "  movq $0, 600(%rsp)\n"
+  "  movq $0, 608(%rsp)\n"
+  "  movq $0, 616(%rsp)\n"
+  "  movq $0, 624(%rsp)\n"
+  "  movq $0, 632(%rsp)\n"
+  "  movl $" LAZY_BIND_XSAVE_MASK ", %eax\n"
+  "  xorl %edx, %edx\n"
+  "  xsave 64(%rsp)\n"
+  "  movq 8(%rbx), %rdi\n"
+  "  movq 16(%rbx), %rsi\n"
+  "  call __hybris_lazy_bind\n"
+  "  movq %rax, %r11\n"
+  "  movl $" LAZY_BIND_XSAVE_MASK ", %eax\n"
+  "  xorl %edx, %edx\n"
+  "  xrstor 64(%rsp)\n"
+  "  movq 0(%rsp), %rax\n"
+  "  movq 8(%rsp), %rcx\n"
+  "  movq 16(%rsp), %rdx\n"
+  "  movq 24(%rsp), %rsi\n"
+  "  movq 32(%rsp), %rdi\n"
+  "  movq 40(%rsp), %r8\n"
+  "  movq 48(%rsp), %r9\n"
+  "  movq %rbx, %rsp\n"
+  "  popq %rbx\n"
+  "  addq $16, %rsp\n"
+  "  jmp *%r11\n"
+  "  .size __hybris_lazy_bind_trampoline_xsave, .-__hybris_lazy_bind_trampoline_xsave\n"
+  "  .popsection\n"
+);
+
+extern "C" void __hybris_lazy_bind_trampoline_xsave() __attribute__((visibility("hidden")));
+extern "C" void __hybris_lazy_bind_trampoline_sse() __attribute__((visibility("hidden")));
+
+static bool cpu_has_xsave() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, nullptr) < 0xd) {
+    return false;
+  }
+
+  // OSXSAVE: the kernel enabled xsave and set XCR0
+  __cpuid(1, eax, ebx, ecx, edx);
+  if ((ecx & bit_OSXSAVE) == 0) {
+    return false;
+  }
+
+  // Size of the XSAVE area for the features enabled in XCR0
+  __cpuid_count(0xd, 0, eax, ebx, ecx, edx);
+  __hybris_lazy_bind_frame_size = ((ebx + 63) & ~63u) + 64;
+  return true;
+}
+
+ElfW(Addr) lazy_bind_trampoline() {
+  static bool has_xsave = cpu_has_xsave();
+  if (has_xsave) {
+    return reinterpret_cast<ElfW(Addr)>(&__hybris_lazy_bind_trampoline_xsave);
+  }
+  return reinterpret_cast<ElfW(Addr)>(&__hybris_lazy_bind_trampoline_sse);
+}
+
+#endif
+
+#if defined(__arm__) || defined(__aarch64__) || defined(__i386__)
+extern "C" void __hybris_lazy_bind_trampoline() __attribute__((visibility("hidden")));
+
+ElfW(Addr) lazy_bind_trampoline() {
+  return reinterpret_cast<ElfW(Addr)>(&__hybris_lazy_bind_trampoline);
+}
+#endif
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __LINKER_LAZY_BIND_H
+#define __LINKER_LAZY_BIND_H
+
+#include <link.h>
+#include <stddef.h>
+
+// hybris: the PLT of a library bound lazily jumps to the trampoline, through
+// the third entry of its GOT, the first time one of its functions is called.
+// The trampoline saves the argument registers, calls __hybris_lazy_bind()
+// with the second entry of the GOT and the index of the PLT relocation, then
+// restores them and jumps to the function it got.
+#if defined(__arm__) || defined(__aarch64__) || defined(__i386__) || defined(__x86_64__)
+#define HAVE_LAZY_BIND_TRAMPOLINE 1
+
+// Returns the trampoline for the CPU, to be stored in the GOT
+ElfW(Addr) lazy_bind_trampoline();
+#endif
+
+#if defined(__aarch64__) && !defined(STO_AARCH64_VARIANT_PCS)
+#define STO_AARCH64_VARIANT_PCS 0x80
+#endif
+
+// Binds the PLT slot and returns the address of the function, see dlfcn.cpp
+extern "C" ElfW(Addr) __hybris_lazy_bind(void* si, size_t index) __attribute__((visibility("hidden")));
+
+#endif  /* __LINKER_LAZY_BIND_H */
@@ -29,12 +29,15 @@
 #include "linker_phdr.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "linker.h"
 #include "linker_debug.h"
 #include "linker_utils.h"
@@ -176,6 +179,26 @@ bool ElfReader::Load(const android_dlextinfo* extinfo) {
   return did_load_;
 }
 
+void ElfReader::Readahead() const {
+  CHECK(did_read_);
+  off64_t start = file_size_;
+  off64_t end = 0;
+
+  for (size_t i = 0; i < phdr_num_; ++i) {
+    const ElfW(Phdr)* phdr = &phdr_table_[i];
+    if (phdr->p_type != PT_LOAD || phdr->p_filesz == 0) {
+      continue;
+    }
+
+    start = std::min(start, static_cast<off64_t>(PAGE_START(phdr->p_offset)));
+    end = std::max(end, static_cast<off64_t>(phdr->p_offset + phdr->p_filesz));
+  }
+
+  if (start < end) {
+    posix_fadvise(fd_, file_offset_ + start, end - start, POSIX_FADV_WILLNEED);
+  }
+}
+
 const char* ElfReader::get_string(ElfW(Word) index) const {
   CHECK(strtab_ != nullptr);
   CHECK(index < strtab_size_);
@@ -44,6 +44,8 @@ class ElfReader {
 
   bool Read(const char* name, int fd, off64_t file_offset, off64_t file_size);
   bool Load(const android_dlextinfo* extinfo);
+  // hybris: asks the kernel to start reading the loadable segments.
+  void Readahead() const;
 
   const char* name() const { return name_.c_str(); }
   size_t phdr_count() const { return phdr_num_; }
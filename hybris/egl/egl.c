@@ -117,6 +117,9 @@ static EGLBoolean (*_eglDestroyImageKHR) (EGLDisplay dpy, EGLImageKHR image) = N
 
 static void (*_glEGLImageTargetTexture2DOES) (GLenum target, GLeglImageOES image) = NULL;
 
+/* Whether images of native buffers are kept until the buffer is released */
+static int _egl_image_cache = -1;
+
 static __eglMustCastToProperFunctionPointerType (*_eglGetProcAddress)(const char *procname) = NULL;
 
 static void _init_androidegl()
@@ -143,46 +146,40 @@ static void * _android_egl_dlsym(const char *symbol)
 	return android_dlsym(egl_handle, symbol);
 }
 
+static void _egl_release_buffer(EGLClientBuffer buffer);
+static void _egl_destroy_cached_image(struct egl_image *image);
+
 struct ws_egl_interface hybris_egl_interface = {
 	_android_egl_dlsym,
 	egl_helper_has_mapping,
 	egl_helper_get_mapping,
+	_egl_release_buffer,
 };
 
 HYBRIS_IMPLEMENT_FUNCTION0(egl, EGLint, eglGetError);
 
-#define _EGL_MAX_DISPLAYS 100
-
-struct _EGLDisplay *_displayMappings[_EGL_MAX_DISPLAYS];
-
-void _addMapping(struct _EGLDisplay *display_id)
+struct _EGLDisplay *hybris_egl_display_get_mapping(EGLDisplay display)
 {
-	int i;
-	for (i = 0; i < _EGL_MAX_DISPLAYS; i++)
-	{
-		if (_displayMappings[i] == NULL)
-		{
-			_displayMappings[i] = display_id;
-			return;
-		}
-	}
+	return egl_helper_get_display(display);
 }
 
-struct _EGLDisplay *hybris_egl_display_get_mapping(EGLDisplay display)
+static struct _EGLDisplay *_egl_map_display(EGLDisplay real_display, EGLNativeDisplayType display_id)
 {
-	int i;
-	for (i = 0; i < _EGL_MAX_DISPLAYS; i++)
-	{
-		if (_displayMappings[i])
-		{
-			if (_displayMappings[i]->dpy == display)
-			{
-				return _displayMappings[i];
-			}
-
+	struct _EGLDisplay *dpy = hybris_egl_display_get_mapping(real_display);
+	if (!dpy) {
+		struct _EGLDisplay *created = ws_GetDisplay(display_id);
+		if (!created) {
+			return NULL;
 		}
+		created->dpy = real_display;
+
+		/* Another thread may have mapped the display meanwhile */
+		dpy = egl_helper_push_display(created, display_id);
+		if (dpy != created)
+			ws_Terminate(created);
 	}
-	return EGL_NO_DISPLAY;
+
+	return dpy;
 }
 
 EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id)
@@ -196,27 +193,38 @@ EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id)
 		return EGL_NO_DISPLAY;
 	}
 
-	struct _EGLDisplay *dpy = hybris_egl_display_get_mapping(real_display);
-	if (!dpy) {
-		dpy = ws_GetDisplay(display_id);
-		if (!dpy) {
-			return EGL_NO_DISPLAY;
-		}
-		dpy->dpy = real_display;
-		_addMapping(dpy);
-	}
+	if (!_egl_map_display(real_display, display_id))
+		return EGL_NO_DISPLAY;
 
 	return real_display;
 }
 
-HYBRIS_IMPLEMENT_FUNCTION3(egl, EGLBoolean, eglInitialize, EGLDisplay, EGLint *, EGLint *);
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor)
+{
+	HYBRIS_DLSYSM(egl, &_eglInitialize, "eglInitialize");
+	EGLNativeDisplayType display_id;
+
+	/* A terminated display can be initialized again, from the native
+	 * display it was created from */
+	if (!hybris_egl_display_get_mapping(dpy) &&
+			egl_helper_get_native_display(dpy, &display_id) &&
+			!_egl_map_display(dpy, display_id))
+		return EGL_FALSE;
+
+	return (*_eglInitialize)(dpy, major, minor);
+}
 
 EGLBoolean eglTerminate(EGLDisplay dpy)
 {
 	HYBRIS_DLSYSM(egl, &_eglTerminate, "eglTerminate");
 
-	struct _EGLDisplay *display = hybris_egl_display_get_mapping(dpy);
-	ws_Terminate(display);
+	if (_egl_image_cache > 0)
+		egl_helper_invalidate_images(dpy, NULL, _egl_destroy_cached_image);
+
+	/* eglInitialize() or eglGetDisplay() map the display again */
+	struct _EGLDisplay *display = egl_helper_pop_display(dpy);
+	if (display)
+		ws_Terminate(display);
 	return (*_eglTerminate)(dpy);
 }
 
@@ -273,7 +281,23 @@ EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface surface)
 	return result;
 }
 
-HYBRIS_IMPLEMENT_FUNCTION4(egl, EGLBoolean, eglQuerySurface, EGLDisplay, EGLSurface, EGLint, EGLint *);
+EGLBoolean eglQuerySurface(EGLDisplay dpy, EGLSurface surface,
+		EGLint attribute, EGLint *value)
+{
+	HYBRIS_DLSYSM(egl, &_eglQuerySurface, "eglQuerySurface");
+
+	/* The platform knows which buffers it presented, and when */
+	EGLNativeWindowType win;
+	if (attribute == EGL_BUFFER_AGE_EXT && value && egl_helper_find_mapping(surface, &win)) {
+		EGLint age = ws_getBufferAge(dpy, win);
+		if (age >= 0) {
+			*value = age;
+			return EGL_TRUE;
+		}
+	}
+
+	return (*_eglQuerySurface)(dpy, surface, attribute, value);
+}
 HYBRIS_IMPLEMENT_FUNCTION1(egl, EGLBoolean, eglBindAPI, EGLenum);
 HYBRIS_IMPLEMENT_FUNCTION0(egl, EGLenum, eglQueryAPI);
 HYBRIS_IMPLEMENT_FUNCTION0(egl, EGLBoolean, eglWaitClient);
@@ -287,6 +311,7 @@ EGLBoolean eglSwapInterval(EGLDisplay dpy, EGLint interval)
 {
 	EGLBoolean ret;
 	EGLSurface surface;
+	EGLNativeWindowType win;
 	HYBRIS_TRACE_BEGIN("hybris-egl", "eglSwapInterval", "=%d", interval);
 
 	/* Some egl implementations don't pass through the setSwapInterval
@@ -295,8 +320,8 @@ EGLBoolean eglSwapInterval(EGLDisplay dpy, EGLint interval)
 	 * to chage it. */
 	HYBRIS_DLSYSM(egl, &_eglGetCurrentSurface, "eglGetCurrentSurface");
 	surface = (*_eglGetCurrentSurface)(EGL_DRAW);
-	if (egl_helper_has_mapping(surface))
-	    ws_setSwapInterval(dpy, egl_helper_get_mapping(surface), interval);
+	if (egl_helper_find_mapping(surface, &win))
+	    ws_setSwapInterval(dpy, win, interval);
 
 	HYBRIS_TRACE_BEGIN("native-egl", "eglSwapInterval", "=%d", interval);
 	HYBRIS_DLSYSM(egl, &_eglSwapInterval, "eglSwapInterval");
@@ -312,18 +337,35 @@ EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config,
 {
 	HYBRIS_DLSYSM(egl, &_eglCreateContext, "eglCreateContext");
 
+	int client_version = 1;
 	const EGLint *p = attrib_list;
 	while (p != NULL && *p != EGL_NONE) {
 		if (*p == EGL_CONTEXT_CLIENT_VERSION) {
+			client_version = p[1];
 			_egl_context_client_version = p[1];
 		}
 		p += 2;
 	}
 
-	return (*_eglCreateContext)(dpy, config, share_context, attrib_list);
+	EGLContext result = (*_eglCreateContext)(dpy, config, share_context, attrib_list);
+
+	if (result != EGL_NO_CONTEXT)
+		egl_helper_push_context(result, client_version);
+
+	return result;
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx)
+{
+	HYBRIS_DLSYSM(egl, &_eglDestroyContext, "eglDestroyContext");
+	EGLBoolean result = (*_eglDestroyContext)(dpy, ctx);
+
+	if (result == EGL_TRUE)
+		egl_helper_pop_context(ctx);
+
+	return result;
 }
 
-HYBRIS_IMPLEMENT_FUNCTION2(egl, EGLBoolean, eglDestroyContext, EGLDisplay, EGLContext);
 HYBRIS_IMPLEMENT_FUNCTION4(egl, EGLBoolean, eglMakeCurrent, EGLDisplay, EGLSurface, EGLSurface, EGLContext);
 HYBRIS_IMPLEMENT_FUNCTION0(egl, EGLContext, eglGetCurrentContext);
 HYBRIS_IMPLEMENT_FUNCTION1(egl, EGLSurface, eglGetCurrentSurface, EGLint);
@@ -339,8 +381,7 @@ EGLBoolean _my_eglSwapBuffersWithDamageEXT(EGLDisplay dpy, EGLSurface surface, E
 	HYBRIS_TRACE_BEGIN("hybris-egl", "eglSwapBuffersWithDamageEXT", "");
 	HYBRIS_DLSYSM(egl, &_eglSwapBuffers, "eglSwapBuffers");
 
-	if (egl_helper_has_mapping(surface)) {
-		win = egl_helper_get_mapping(surface);
+	if (egl_helper_find_mapping(surface, &win)) {
 		ws_prepareSwap(dpy, win, rects, n_rects);
 		ret = (*_eglSwapBuffers)(dpy, surface);
 		ws_finishSwap(dpy, win);
@@ -363,9 +404,57 @@ EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
 HYBRIS_IMPLEMENT_FUNCTION3(egl, EGLBoolean, eglCopyBuffers, EGLDisplay, EGLSurface, EGLNativePixmapType);
 
 
+/*
+ * With HYBRIS_EGL_IMAGE_CACHE=1, importing a native buffer that was
+ * imported before returns the same image, which is only destroyed once
+ * the buffer is released with eglHybrisReleaseNativeBuffer: video players
+ * and compositors import the same few buffers over and over.
+ */
+static int _egl_image_cacheable(EGLContext ctx, EGLenum target, const EGLint *attrib_list)
+{
+	const EGLint *p;
+
+	if (_egl_image_cache < 0) {
+		const char *env = getenv("HYBRIS_EGL_IMAGE_CACHE");
+		_egl_image_cache = env && atoi(env) > 0;
+	}
+
+	if (!_egl_image_cache || ctx != EGL_NO_CONTEXT || target != EGL_NATIVE_BUFFER_ANDROID)
+		return 0;
+
+	/* Other attributes could ask for another image of the same buffer */
+	for (p = attrib_list; p != NULL && *p != EGL_NONE; p += 2) {
+		if (*p != EGL_IMAGE_PRESERVED_KHR)
+			return 0;
+	}
+
+	return 1;
+}
+
+static void _egl_destroy_cached_image(struct egl_image *image)
+{
+	HYBRIS_DLSYSM(egl, &_eglDestroyImageKHR, "eglDestroyImageKHR");
+	(*_eglDestroyImageKHR)(image->dpy, image->egl_image);
+	egl_helper_free_image(image);
+}
+
+static void _egl_release_buffer(EGLClientBuffer buffer)
+{
+	if (_egl_image_cache > 0)
+		egl_helper_invalidate_images(EGL_NO_DISPLAY, buffer, _egl_destroy_cached_image);
+}
+
 static EGLImageKHR _my_eglCreateImageKHR(EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer, const EGLint *attrib_list)
 {
 	HYBRIS_DLSYSM(egl, &_eglCreateImageKHR, "eglCreateImageKHR");
+
+	int cacheable = _egl_image_cacheable(ctx, target, attrib_list);
+	if (cacheable) {
+		struct egl_image *cached = egl_helper_get_cached_image(dpy, target, buffer);
+		if (cached)
+			return (EGLImageKHR)cached;
+	}
+
 	EGLContext newctx = ctx;
 	EGLenum newtarget = target;
 	EGLClientBuffer newbuffer = buffer;
@@ -380,10 +469,15 @@ static EGLImageKHR _my_eglCreateImageKHR(EGLDisplay dpy, EGLContext ctx, EGLenum
 	}
 
 	struct egl_image *image;
-	image = malloc(sizeof *image);
+	image = egl_helper_alloc_image();
 	image->egl_image = eik;
 	image->egl_buffer = buffer;
 	image->target = target;
+	image->dpy = dpy;
+	image->refcount = 1;
+
+	if (cacheable)
+		egl_helper_push_cached_image(image);
 
 	return (EGLImageKHR)image;
 }
@@ -395,7 +489,7 @@ static void _my_glEGLImageTargetTexture2DOES(GLenum target, GLeglImageOES image)
 	(*_glEGLImageTargetTexture2DOES)(target, img ? img->egl_image : NULL);
 }
 
-__eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
+static __eglMustCastToProperFunctionPointerType _egl_resolve_proc(int client_version, const char *procname)
 {
 	HYBRIS_DLSYSM(egl, &_eglGetProcAddress, "eglGetProcAddress");
 	if (strcmp(procname, "eglCreateImageKHR") == 0)
@@ -417,7 +511,7 @@ __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
 
 	__eglMustCastToProperFunctionPointerType ret = NULL;
 
-	switch (_egl_context_client_version) {
+	switch (client_version) {
 		case 1:  // OpenGL ES 1.x API
 			if (_hybris_libgles1 == NULL) {
 				_hybris_libgles1 = (void *) dlopen(getenv("HYBRIS_LIBGLESV1") ?: "libGLESv1_CM.so.1", RTLD_LAZY);
@@ -434,7 +528,7 @@ __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
 			// TODO: Load from libGLESv3.so once we have OpenGL ES 3.0/3.1 support
 			break;
 		default:
-			HYBRIS_WARN("Unknown EGL context client version: %d", _egl_context_client_version);
+			HYBRIS_WARN("Unknown EGL context client version: %d", client_version);
 			break;
 	}
 
@@ -449,13 +543,37 @@ __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
 	return ret;
 }
 
+__eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
+{
+	/* The API of the current context decides which library functions come
+	 * from. Before any is current, guess it is the last one created. */
+	HYBRIS_DLSYSM(egl, &_eglGetCurrentContext, "eglGetCurrentContext");
+	int client_version = egl_helper_get_context_version((*_eglGetCurrentContext)());
+	if (client_version == 0)
+		client_version = _egl_context_client_version;
+
+	__eglMustCastToProperFunctionPointerType ret = egl_helper_get_proc(client_version, procname);
+	if (ret == NULL) {
+		ret = _egl_resolve_proc(client_version, procname);
+		if (ret != NULL)
+			egl_helper_push_proc(client_version, procname, ret);
+	}
+
+	return ret;
+}
+
 EGLBoolean eglDestroyImageKHR(EGLDisplay dpy, EGLImageKHR image)
 {
 	HYBRIS_DLSYSM(egl, &_eglDestroyImageKHR, "eglDestroyImageKHR");
 	struct egl_image *img = image;
+
+	/* Cached images outlive the application's references */
+	if (img && _egl_image_cache > 0 && !egl_helper_unref_image(img))
+		return EGL_TRUE;
+
 	EGLBoolean ret = (*_eglDestroyImageKHR)(dpy, img ? img->egl_image : NULL);
 	if (ret == EGL_TRUE) {
-		free(img);
+		egl_helper_free_image(img);
 		return EGL_TRUE;
 	}
 	return ret;
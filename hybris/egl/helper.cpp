@@ -20,46 +20,527 @@
 
 #include "helper.h"
 
+#include "ws.h"
+
 #include <assert.h>
-#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <unordered_map>
+
+
+/*
+ * Keep track of active EGL window surfaces, in an open addressing table.
+ *
+ * Surfaces are looked up on every swap, possibly from several rendering
+ * threads, so lookups take no lock: they read the table optimistically and
+ * retry if it was modified meanwhile (a sequence lock), which only happens
+ * when a window surface is created or destroyed. Removal shifts the entries
+ * that follow back instead of leaving tombstones, so a table is only
+ * replaced when it grows. Replaced tables are kept around, as a lookup may
+ * still be reading them; they add up to less than the current one.
+ */
+struct surface_slot {
+    std::atomic<EGLSurface> surface;
+    std::atomic<EGLNativeWindowType> window;
+};
+
+struct surface_table {
+    size_t mask;
+    size_t used;
+    struct surface_slot *slots;
+    struct surface_table *retired;
+};
+
+#define SURFACE_TABLE_MIN_SIZE 16
+
+static std::atomic<struct surface_table *> _surface_table(NULL);
+static std::atomic<unsigned int> _surface_seq(0);
+static pthread_mutex_t _surface_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Keep track of the displays returned by eglGetDisplay. Looked up on most
+ * EGL calls that take a display, from any thread. eglTerminate drops the
+ * platform display but keeps the native one, for eglInitialize to map the
+ * display again. */
+struct display_entry {
+    struct _EGLDisplay *display;
+    EGLNativeDisplayType native;
+};
+
+static std::unordered_map<EGLDisplay,struct display_entry> _display_map;
+static pthread_rwlock_t _display_map_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Client API version of each context, from eglCreateContext to eglDestroyContext */
+static std::unordered_map<EGLContext,int> _context_version_map;
+static pthread_rwlock_t _context_version_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Functions already resolved by eglGetProcAddress, per client API version:
+ * toolkits query hundreds of them at startup, often once per context. */
+struct proc_name_hash {
+    size_t operator()(const char *name) const
+    {
+        size_t h = 2166136261u;
+        while (*name)
+            h = (h ^ (unsigned char) *name++) * 16777619u;
+        return h;
+    }
+};
+
+struct proc_name_equal {
+    bool operator()(const char *a, const char *b) const
+    {
+        return strcmp(a, b) == 0;
+    }
+};
+
+typedef std::unordered_map<const char *,__eglMustCastToProperFunctionPointerType,
+        proc_name_hash,proc_name_equal> proc_map;
+
+/* OpenGL ES 1.x, 2.0 and 3.x, anything else goes to the first one */
+#define PROC_MAP_APIS 4
+
+static proc_map _proc_maps[PROC_MAP_APIS];
+static pthread_rwlock_t _proc_map_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Wrappers of EGLImages are allocated by slabs and never freed, as video
+ * players and compositors create and destroy images every frame */
+#define IMAGE_SLAB_SIZE 64
+
+static struct egl_image *_image_free_list = NULL;
+static pthread_mutex_t _image_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Images kept for their client buffer with HYBRIS_EGL_IMAGE_CACHE, from
+ * their creation until the buffer is released */
+static std::unordered_multimap<EGLClientBuffer,struct egl_image *> _image_cache;
+static pthread_mutex_t _image_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static inline size_t surface_hash(EGLSurface surface)
+{
+    uintptr_t h = (uintptr_t) surface;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Returns the slot holding surface, or the empty slot ending its probe sequence */
+static size_t surface_probe(struct surface_table *table, EGLSurface surface)
+{
+    size_t i = surface_hash(surface) & table->mask;
+
+    /* Bounded, as a lookup may see the table half modified */
+    for (size_t n = 0; n <= table->mask; n++, i = (i + 1) & table->mask) {
+        EGLSurface s = table->slots[i].surface.load(std::memory_order_relaxed);
+        if (s == surface || s == EGL_NO_SURFACE)
+            break;
+    }
+
+    return i;
+}
+
+/* Called with the lock held, around modifications of the current table */
+static void surface_write_begin()
+{
+    _surface_seq.store(_surface_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void surface_write_end()
+{
+    _surface_seq.store(_surface_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/* Called with the lock held. The new table is only visible once filled. */
+static struct surface_table *surface_table_grow(struct surface_table *old)
+{
+    struct surface_table *table = new surface_table;
+    size_t size = old ? (old->mask + 1) * 2 : SURFACE_TABLE_MIN_SIZE;
 
+    table->mask = size - 1;
+    table->used = 0;
+    table->slots = new surface_slot[size]();
+    table->retired = old;
 
-/* Keep track of active EGL window surfaces */
-static std::map<EGLSurface,EGLNativeWindowType> _surface_window_map;
+    for (size_t i = 0; old && i <= old->mask; i++) {
+        EGLSurface surface = old->slots[i].surface.load(std::memory_order_relaxed);
+        if (surface == EGL_NO_SURFACE)
+            continue;
+
+        struct surface_slot *slot = &table->slots[surface_probe(table, surface)];
+        slot->window.store(old->slots[i].window.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        slot->surface.store(surface, std::memory_order_relaxed);
+        table->used++;
+    }
+
+    _surface_table.store(table, std::memory_order_release);
+    return table;
+}
 
 
 void egl_helper_push_mapping(EGLSurface surface, EGLNativeWindowType window)
 {
     assert(!egl_helper_has_mapping(surface));
 
-    _surface_window_map[surface] = window;
+    pthread_mutex_lock(&_surface_lock);
+
+    /* At most half full, so that probe sequences stay short */
+    struct surface_table *table = _surface_table.load(std::memory_order_relaxed);
+    if (!table || (table->used + 1) * 2 > table->mask + 1)
+        table = surface_table_grow(table);
+
+    struct surface_slot *slot = &table->slots[surface_probe(table, surface)];
+
+    surface_write_begin();
+    slot->window.store(window, std::memory_order_relaxed);
+    slot->surface.store(surface, std::memory_order_relaxed);
+    table->used++;
+    surface_write_end();
+
+    pthread_mutex_unlock(&_surface_lock);
+}
+
+int egl_helper_find_mapping(EGLSurface surface, EGLNativeWindowType *window)
+{
+    for (;;) {
+        unsigned int seq = _surface_seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            /* A surface is being added or removed */
+            sched_yield();
+            continue;
+        }
+
+        struct surface_table *table = _surface_table.load(std::memory_order_acquire);
+        EGLNativeWindowType result = 0;
+        int found = 0;
+
+        if (table && surface != EGL_NO_SURFACE) {
+            struct surface_slot *slot = &table->slots[surface_probe(table, surface)];
+            if (slot->surface.load(std::memory_order_relaxed) == surface) {
+                result = slot->window.load(std::memory_order_relaxed);
+                found = 1;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_surface_seq.load(std::memory_order_relaxed) != seq)
+            continue;
+
+        if (found && window)
+            *window = result;
+        return found;
+    }
 }
 
 int egl_helper_has_mapping(EGLSurface surface)
 {
-    return (_surface_window_map.find(surface) != _surface_window_map.end());
+    return egl_helper_find_mapping(surface, NULL);
 }
 
 EGLNativeWindowType egl_helper_get_mapping(EGLSurface surface)
 {
-    std::map<EGLSurface,EGLNativeWindowType>::iterator it;
-    it = _surface_window_map.find(surface);
+    EGLNativeWindowType result = 0;
+    int found = egl_helper_find_mapping(surface, &result);
 
     /* Caller must check with egl_helper_has_mapping() before */
-    assert(it != _surface_window_map.end());
+    assert(found);
+    (void) found;
 
-    return it->second;
+    return result;
 }
 
 EGLNativeWindowType egl_helper_pop_mapping(EGLSurface surface)
 {
-    std::map<EGLSurface,EGLNativeWindowType>::iterator it;
-    it = _surface_window_map.find(surface);
+    pthread_mutex_lock(&_surface_lock);
+
+    struct surface_table *table = _surface_table.load(std::memory_order_relaxed);
+    assert(table != NULL);
+
+    size_t i = surface_probe(table, surface);
+    struct surface_slot *slots = table->slots;
 
     /* Caller must check with egl_helper_has_mapping() before */
-    assert(it != _surface_window_map.end());
+    assert(slots[i].surface.load(std::memory_order_relaxed) == surface);
+
+    EGLNativeWindowType result = slots[i].window.load(std::memory_order_relaxed);
+
+    surface_write_begin();
+
+    /* Move back the entries whose probe sequence went through the freed slot */
+    for (size_t j = (i + 1) & table->mask; ; j = (j + 1) & table->mask) {
+        EGLSurface s = slots[j].surface.load(std::memory_order_relaxed);
+        if (s == EGL_NO_SURFACE)
+            break;
+
+        size_t home = surface_hash(s) & table->mask;
+        if (((j - home) & table->mask) >= ((j - i) & table->mask)) {
+            slots[i].window.store(slots[j].window.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            slots[i].surface.store(s, std::memory_order_relaxed);
+            i = j;
+        }
+    }
+
+    slots[i].surface.store(EGL_NO_SURFACE, std::memory_order_relaxed);
+    slots[i].window.store(0, std::memory_order_relaxed);
+    table->used--;
+
+    surface_write_end();
+
+    pthread_mutex_unlock(&_surface_lock);
+
+    return result;
+}
+
+struct _EGLDisplay *egl_helper_push_display(struct _EGLDisplay *display, EGLNativeDisplayType native)
+{
+    pthread_rwlock_wrlock(&_display_map_lock);
+    struct display_entry &entry = _display_map[display->dpy];
+    if (!entry.display) {
+        entry.display = display;
+        entry.native = native;
+    }
+    struct _EGLDisplay *result = entry.display;
+    pthread_rwlock_unlock(&_display_map_lock);
+
+    return result;
+}
+
+struct _EGLDisplay *egl_helper_get_display(EGLDisplay dpy)
+{
+    struct _EGLDisplay *result = NULL;
+
+    pthread_rwlock_rdlock(&_display_map_lock);
+    std::unordered_map<EGLDisplay,struct display_entry>::iterator it = _display_map.find(dpy);
+    if (it != _display_map.end())
+        result = it->second.display;
+    pthread_rwlock_unlock(&_display_map_lock);
+
+    return result;
+}
+
+int egl_helper_get_native_display(EGLDisplay dpy, EGLNativeDisplayType *native)
+{
+    int result = 0;
+
+    pthread_rwlock_rdlock(&_display_map_lock);
+    std::unordered_map<EGLDisplay,struct display_entry>::iterator it = _display_map.find(dpy);
+    if (it != _display_map.end()) {
+        *native = it->second.native;
+        result = 1;
+    }
+    pthread_rwlock_unlock(&_display_map_lock);
+
+    return result;
+}
+
+struct _EGLDisplay *egl_helper_pop_display(EGLDisplay dpy)
+{
+    struct _EGLDisplay *result = NULL;
+
+    pthread_rwlock_wrlock(&_display_map_lock);
+    std::unordered_map<EGLDisplay,struct display_entry>::iterator it = _display_map.find(dpy);
+    if (it != _display_map.end()) {
+        result = it->second.display;
+        it->second.display = NULL;
+    }
+    pthread_rwlock_unlock(&_display_map_lock);
+
+    return result;
+}
+
+void egl_helper_push_context(EGLContext context, int client_version)
+{
+    pthread_rwlock_wrlock(&_context_version_lock);
+    _context_version_map[context] = client_version;
+    pthread_rwlock_unlock(&_context_version_lock);
+}
+
+int egl_helper_get_context_version(EGLContext context)
+{
+    int result = 0;
+
+    if (context == EGL_NO_CONTEXT)
+        return 0;
+
+    pthread_rwlock_rdlock(&_context_version_lock);
+    std::unordered_map<EGLContext,int>::iterator it = _context_version_map.find(context);
+    if (it != _context_version_map.end())
+        result = it->second;
+    pthread_rwlock_unlock(&_context_version_lock);
+
+    return result;
+}
+
+void egl_helper_pop_context(EGLContext context)
+{
+    pthread_rwlock_wrlock(&_context_version_lock);
+    _context_version_map.erase(context);
+    pthread_rwlock_unlock(&_context_version_lock);
+}
+
+static inline proc_map &proc_map_for(int client_version)
+{
+    if (client_version < 0 || client_version >= PROC_MAP_APIS)
+        client_version = 0;
+    return _proc_maps[client_version];
+}
+
+__eglMustCastToProperFunctionPointerType egl_helper_get_proc(int client_version, const char *procname)
+{
+    __eglMustCastToProperFunctionPointerType result = NULL;
+    proc_map &map = proc_map_for(client_version);
+
+    pthread_rwlock_rdlock(&_proc_map_lock);
+    proc_map::iterator it = map.find(procname);
+    if (it != map.end())
+        result = it->second;
+    pthread_rwlock_unlock(&_proc_map_lock);
+
+    return result;
+}
+
+void egl_helper_push_proc(int client_version, const char *procname, __eglMustCastToProperFunctionPointerType proc)
+{
+    proc_map &map = proc_map_for(client_version);
+
+    pthread_rwlock_wrlock(&_proc_map_lock);
+    proc_map::iterator it = map.find(procname);
+    if (it == map.end())
+        map.insert(std::make_pair(strdup(procname), proc));
+    else
+        it->second = proc;
+    pthread_rwlock_unlock(&_proc_map_lock);
+}
+
+struct egl_image *egl_helper_alloc_image(void)
+{
+    pthread_mutex_lock(&_image_pool_lock);
+
+    if (!_image_free_list) {
+        struct egl_image *slab = new egl_image[IMAGE_SLAB_SIZE];
+        for (int i = 0; i < IMAGE_SLAB_SIZE; i++) {
+            slab[i].next = _image_free_list;
+            _image_free_list = &slab[i];
+        }
+    }
+
+    struct egl_image *image = _image_free_list;
+    _image_free_list = image->next;
+
+    pthread_mutex_unlock(&_image_pool_lock);
+
+    memset(image, 0, sizeof(*image));
+    return image;
+}
+
+void egl_helper_free_image(struct egl_image *image)
+{
+    if (!image)
+        return;
+
+    pthread_mutex_lock(&_image_pool_lock);
+    image->next = _image_free_list;
+    _image_free_list = image;
+    pthread_mutex_unlock(&_image_pool_lock);
+}
+
+struct egl_image *egl_helper_get_cached_image(EGLDisplay dpy, EGLenum target, EGLClientBuffer buffer)
+{
+    struct egl_image *result = NULL;
+    typedef std::unordered_multimap<EGLClientBuffer,struct egl_image *>::iterator iterator;
+
+    pthread_mutex_lock(&_image_cache_lock);
+    std::pair<iterator,iterator> range = _image_cache.equal_range(buffer);
+    for (iterator it = range.first; it != range.second; ++it) {
+        if (it->second->dpy == dpy && it->second->target == target) {
+            result = it->second;
+            result->refcount++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_image_cache_lock);
 
-    EGLNativeWindowType result = it->second;
-    _surface_window_map.erase(it);
     return result;
 }
+
+void egl_helper_push_cached_image(struct egl_image *image)
+{
+    typedef std::unordered_multimap<EGLClientBuffer,struct egl_image *>::iterator iterator;
+
+    pthread_mutex_lock(&_image_cache_lock);
+    std::pair<iterator,iterator> range = _image_cache.equal_range(image->egl_buffer);
+    iterator it = range.first;
+    for (; it != range.second; ++it) {
+        if (it->second->dpy == image->dpy && it->second->target == image->target)
+            break;
+    }
+
+    /* If another thread imported the same buffer meanwhile, this image is
+     * destroyed as usual */
+    if (it == range.second) {
+        _image_cache.insert(std::make_pair(image->egl_buffer, image));
+        image->cached = 1;
+    }
+    pthread_mutex_unlock(&_image_cache_lock);
+}
+
+int egl_helper_unref_image(struct egl_image *image)
+{
+    int result;
+
+    pthread_mutex_lock(&_image_cache_lock);
+    if (image->refcount > 0)
+        image->refcount--;
+    /* Images the cache dropped while referenced go with their last reference */
+    result = !image->cached && image->refcount == 0;
+    pthread_mutex_unlock(&_image_cache_lock);
+
+    return result;
+}
+
+void egl_helper_invalidate_images(EGLDisplay dpy, EGLClientBuffer buffer,
+        void (*destroy)(struct egl_image *image))
+{
+    typedef std::unordered_multimap<EGLClientBuffer,struct egl_image *>::iterator iterator;
+    struct egl_image *unused = NULL;
+
+    pthread_mutex_lock(&_image_cache_lock);
+
+    iterator it, end;
+    if (buffer) {
+        std::pair<iterator,iterator> range = _image_cache.equal_range(buffer);
+        it = range.first;
+        end = range.second;
+    } else {
+        it = _image_cache.begin();
+        end = _image_cache.end();
+    }
+
+    while (it != end) {
+        struct egl_image *image = it->second;
+        if (!buffer && image->dpy != dpy) {
+            ++it;
+            continue;
+        }
+
+        it = _image_cache.erase(it);
+
+        /* Images still referenced are destroyed by eglDestroyImageKHR */
+        image->cached = 0;
+        if (image->refcount == 0) {
+            image->next = unused;
+            unused = image;
+        }
+    }
+
+    pthread_mutex_unlock(&_image_cache_lock);
+
+    while (unused) {
+        struct egl_image *image = unused;
+        unused = image->next;
+        destroy(image);
+    }
+}
@@ -29,6 +29,8 @@
 extern "C" {
 #endif
 
+struct _EGLDisplay;
+
 
 /* Add new mapping from surface to window */
 void egl_helper_push_mapping(EGLSurface surface, EGLNativeWindowType window);
@@ -36,12 +38,71 @@ void egl_helper_push_mapping(EGLSurface surface, EGLNativeWindowType window);
 /* Check if a mapping for a surface exist */
 int egl_helper_has_mapping(EGLSurface surface);
 
+/* Check if a mapping for a surface exist, and if so return it in window.
+ * Safe to call from any thread, without taking a lock. */
+int egl_helper_find_mapping(EGLSurface surface, EGLNativeWindowType *window);
+
 /* Return (without removing) the mapping for a surface */
 EGLNativeWindowType egl_helper_get_mapping(EGLSurface surface);
 
 /* Return and remove the mapping for a surface */
 EGLNativeWindowType egl_helper_pop_mapping(EGLSurface surface);
 
+/* Add the mapping from display->dpy to display, created from the native
+ * display native, unless there is one already. Returns the mapped display,
+ * which is not the one passed if it was. */
+struct _EGLDisplay *egl_helper_push_display(struct _EGLDisplay *display, EGLNativeDisplayType native);
+
+/* Return (without removing) the mapping for a display, or NULL */
+struct _EGLDisplay *egl_helper_get_display(EGLDisplay dpy);
+
+/* Return the native display a display was last mapped from, even after
+ * egl_helper_pop_display(). Returns 0 if it was never mapped. */
+int egl_helper_get_native_display(EGLDisplay dpy, EGLNativeDisplayType *native);
+
+/* Return the mapping for a display, or NULL, and unmap it. The display keeps
+ * its entry, with the native display, see egl_helper_get_native_display(). */
+struct _EGLDisplay *egl_helper_pop_display(EGLDisplay dpy);
+
+/* Remember the client API version a context was created for */
+void egl_helper_push_context(EGLContext context, int client_version);
+
+/* Return the client API version of a context, or 0 if unknown */
+int egl_helper_get_context_version(EGLContext context);
+
+/* Forget about a destroyed context */
+void egl_helper_pop_context(EGLContext context);
+
+/* Return the cached address of a function for a client API version, or NULL */
+__eglMustCastToProperFunctionPointerType egl_helper_get_proc(int client_version, const char *procname);
+
+/* Cache the address of a function for a client API version */
+void egl_helper_push_proc(int client_version, const char *procname, __eglMustCastToProperFunctionPointerType proc);
+
+struct egl_image;
+
+/* Allocate the wrapper of an EGLImage given to the application, from a pool */
+struct egl_image *egl_helper_alloc_image(void);
+
+/* Return the wrapper of an EGLImage to the pool */
+void egl_helper_free_image(struct egl_image *image);
+
+/* Return the image cached for a client buffer, with one more reference, or NULL */
+struct egl_image *egl_helper_get_cached_image(EGLDisplay dpy, EGLenum target, EGLClientBuffer buffer);
+
+/* Cache an image for its client buffer, unless another one was meanwhile */
+void egl_helper_push_cached_image(struct egl_image *image);
+
+/* Drop a reference to an image. Returns 1 if that was the last one and the
+ * image is not cached, so that it has to be destroyed. */
+int egl_helper_unref_image(struct egl_image *image);
+
+/* Remove the images of a client buffer, or of all the buffers of dpy if
+ * buffer is NULL, from the cache. Those the application doesn't reference
+ * anymore are passed to destroy. */
+void egl_helper_invalidate_images(EGLDisplay dpy, EGLClientBuffer buffer,
+        void (*destroy)(struct egl_image *image));
+
 
 #ifdef __cplusplus
 };
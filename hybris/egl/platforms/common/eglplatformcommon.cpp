@@ -258,6 +258,10 @@ extern "C" EGLBoolean eglplatformcommon_eglHybrisReleaseNativeBuffer(EGLClientBu
 {
 	RemoteWindowBuffer *buf = static_cast<RemoteWindowBuffer *>((ANativeWindowBuffer *) buffer);
 
+	/* Images libEGL kept for the buffer hold references to it */
+	if (my_egl_interface->release_buffer)
+		(*my_egl_interface->release_buffer)(buffer);
+
 	buf->common.decRef(&buf->common);
 	return EGL_TRUE;
 }
@@ -22,7 +22,9 @@
 #include <assert.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #if ANDROID_VERSION_MAJOR>=4 && ANDROID_VERSION_MINOR>=2 || ANDROID_VERSION_MAJOR>=5
 extern "C" {
@@ -32,9 +34,6 @@ extern "C" {
 
 #define FRAMEBUFFER_PARTITIONS 2
 
-static pthread_cond_t _cond = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
-
 
 FbDevNativeWindowBuffer::FbDevNativeWindowBuffer(alloc_device_t* alloc_device,
                             unsigned int width,
@@ -80,6 +79,9 @@ FbDevNativeWindow::FbDevNativeWindow( alloc_device_t* alloc,
     m_usage = GRALLOC_USAGE_HW_FB;
     m_bufferCount = 0;
     m_allocateBuffers = true;
+    m_frontBuf = NULL;
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
 
 #if ANDROID_VERSION_MAJOR>=4 && ANDROID_VERSION_MINOR>=2 || ANDROID_VERSION_MAJOR>=5
     if (m_fbDev->numFramebuffers>0)
@@ -90,6 +92,17 @@ FbDevNativeWindow::FbDevNativeWindow( alloc_device_t* alloc,
     setBufferCount(FRAMEBUFFER_PARTITIONS);
 #endif
 
+    // Unless disabled, buffers are posted from a thread of their own, so
+    // that eglSwapBuffers() neither waits for rendering to complete nor
+    // for the framebuffer to flip
+    const char *env = getenv("HYBRIS_FBDEV_POST_THREAD");
+    m_usePostThread = !env || atoi(env) != 0;
+    m_postQuit = false;
+    if (m_usePostThread && pthread_create(&m_postThread, NULL, postThread, this) != 0)
+    {
+        fprintf(stderr, "WARNING: %s: cannot start the post thread\n", __PRETTY_FUNCTION__);
+        m_usePostThread = false;
+    }
 }
 
 
@@ -97,7 +110,20 @@ FbDevNativeWindow::FbDevNativeWindow( alloc_device_t* alloc,
 
 FbDevNativeWindow::~FbDevNativeWindow()
 {
+    if (m_usePostThread)
+    {
+        // Buffers still queued are posted first
+        pthread_mutex_lock(&m_mutex);
+        m_postQuit = true;
+        pthread_cond_broadcast(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+        pthread_join(m_postThread, NULL);
+    }
+
     destroyBuffers();
+
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
 }
 
 
@@ -113,7 +139,7 @@ void FbDevNativeWindow::destroyBuffers()
         fbnb->common.decRef(&fbnb->common);
     }
     m_bufList.clear();
-    m_freeBufs = 0;
+    m_freeBufs.clear();
     m_frontBuf = NULL;
 }
 
@@ -156,7 +182,7 @@ int FbDevNativeWindow::dequeueBuffer(BaseNativeWindowBuffer** buffer, int *fence
     HYBRIS_TRACE_BEGIN("fbdev-platform", "dequeueBuffer", "");
     FbDevNativeWindowBuffer* fbnb=NULL;
 
-    pthread_mutex_lock(&_mutex);
+    pthread_mutex_lock(&m_mutex);
 
     if (m_allocateBuffers)
         reallocateBuffers();
@@ -174,27 +200,8 @@ int FbDevNativeWindow::dequeueBuffer(BaseNativeWindowBuffer** buffer, int *fence
     }
 #endif
 
-    while (m_freeBufs==0)
+    while (m_freeBufs.empty())
     {
-        pthread_cond_wait(&_cond, &_mutex);
-    }
-
-    while (1)
-    {
-        std::list<FbDevNativeWindowBuffer*>::iterator it = m_bufList.begin();
-        for (; it != m_bufList.end(); ++it)
-        {
-            if (*it==m_frontBuf)
-                continue;
-            if ((*it)->busy==0)
-            {
-                TRACE("Found a free non-front buffer");
-                break;
-            }
-        }
-
-        if (it == m_bufList.end())
-        {
 #if ANDROID_VERSION_MAJOR<=4 && ANDROID_VERSION_MINOR<2
             /*
              * This is acceptable in case you are on a stack that calls lock() before starting to render into buffer
@@ -203,32 +210,32 @@ int FbDevNativeWindow::dequeueBuffer(BaseNativeWindowBuffer** buffer, int *fence
              * This optimization allows eglSwapBuffers to return and you can begin to utilize the GPU for rendering. 
              * The actual lock() probably first comes at glFlush/eglSwapBuffers
             */
-            if (m_frontBuf && m_frontBuf->busy == 0)
-            {
-                TRACE("Used front buffer as buffer");
-                fbnb = m_frontBuf;
-                break;
-            }
-#endif
-            // have to wait once again
-            pthread_cond_wait(&_cond, &_mutex);
-            continue;
+        if (m_frontBuf && m_frontBuf->busy == 0)
+        {
+            TRACE("Used front buffer as buffer");
+            fbnb = m_frontBuf;
+            break;
         }
+#endif
+        pthread_cond_wait(&m_cond, &m_mutex);
+    }
 
-        fbnb = *it;
-        break;
+    if (!fbnb)
+    {
+        // The free buffer released the longest ago
+        fbnb = m_freeBufs.front();
+        m_freeBufs.pop_front();
     }
 
     HYBRIS_TRACE_END("fbdev-platform", "dequeueBuffer-wait", "");
     assert(fbnb!=NULL);
     fbnb->busy = 1;
-    m_freeBufs--;
 
     *buffer = fbnb;
     *fenceFd = -1;
 
     TRACE("%lu DONE --> %p", pthread_self(), fbnb);
-    pthread_mutex_unlock(&_mutex);
+    pthread_mutex_unlock(&m_mutex);
     HYBRIS_TRACE_END("fbdev-platform", "dequeueBuffer", "");
     return 0;
 }
@@ -259,14 +266,39 @@ int FbDevNativeWindow::queueBuffer(BaseNativeWindowBuffer* buffer, int fenceFd)
 
     HYBRIS_TRACE_BEGIN("fbdev-platform", "queueBuffer", "-%p", fbnb);
 
-    pthread_mutex_lock(&_mutex);
+    pthread_mutex_lock(&m_mutex);
 
     assert(fbnb->busy==1);
 
     fbnb->busy = 2;
 
-    pthread_mutex_unlock(&_mutex);
+    if (m_usePostThread)
+    {
+        PostItem item = { fbnb, fenceFd };
+        m_postQueue.push_back(item);
+        HYBRIS_TRACE_COUNTER("fbdev-platform", "post-queue", "%zu", m_postQueue.size());
+
+        pthread_cond_broadcast(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+
+        HYBRIS_TRACE_END("fbdev-platform", "queueBuffer", "-%p", fbnb);
+        return NO_ERROR;
+    }
+
+    pthread_mutex_unlock(&m_mutex);
+
+    int rv = post(fbnb, fenceFd);
+
+    HYBRIS_TRACE_END("fbdev-platform", "queueBuffer", "-%p", fbnb);
+    return rv;
+}
 
+/*
+ * Waits for the rendering to the buffer to complete, then puts it on
+ * screen. The buffer it replaces becomes free. Called without the lock.
+ */
+int FbDevNativeWindow::post(FbDevNativeWindowBuffer* fbnb, int fenceFd)
+{
 #if ANDROID_VERSION_MAJOR>=4 && ANDROID_VERSION_MINOR>=2 || ANDROID_VERSION_MAJOR>=5
     HYBRIS_TRACE_BEGIN("fbdev-platform", "queueBuffer_waiting_for_fence", "-%p", fbnb);
     if (fenceFd >= 0)
@@ -286,22 +318,54 @@ int FbDevNativeWindow::queueBuffer(BaseNativeWindowBuffer* buffer, int fenceFd)
     }
     HYBRIS_TRACE_END("fbdev-platform", "queueBuffer-post", "-%p", fbnb);
 
-    pthread_mutex_lock(&_mutex);
+    pthread_mutex_lock(&m_mutex);
 
+    FbDevNativeWindowBuffer* old = m_frontBuf;
     fbnb->busy=0;
     m_frontBuf = fbnb;
 
-    m_freeBufs++;
+    // The previous front buffer is off screen now. If it was dequeued
+    // meanwhile, it is put back by cancelBuffer instead
+    if (old && old != fbnb && old->busy == 0)
+        m_freeBufs.push_back(old);
 
     TRACE("%lu %p %p",pthread_self(), m_frontBuf, fbnb);
 
-    pthread_cond_signal(&_cond);
-    pthread_mutex_unlock(&_mutex);
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
 
-    HYBRIS_TRACE_END("fbdev-platform", "queueBuffer", "-%p", fbnb);
     return rv;
 }
 
+void *FbDevNativeWindow::postThread(void *data)
+{
+    FbDevNativeWindow* self = static_cast<FbDevNativeWindow*>(data);
+
+    pthread_mutex_lock(&self->m_mutex);
+    while (!self->m_postQuit || !self->m_postQueue.empty())
+    {
+        if (self->m_postQueue.empty())
+        {
+            pthread_cond_wait(&self->m_cond, &self->m_mutex);
+            continue;
+        }
+
+        // The buffer stays queued until it is on screen, see reallocateBuffers()
+        PostItem item = self->m_postQueue.front();
+        pthread_mutex_unlock(&self->m_mutex);
+
+        self->post(item.buffer, item.fenceFd);
+
+        pthread_mutex_lock(&self->m_mutex);
+        self->m_postQueue.pop_front();
+        HYBRIS_TRACE_COUNTER("fbdev-platform", "post-queue", "%zu", self->m_postQueue.size());
+        pthread_cond_broadcast(&self->m_cond);
+    }
+    pthread_mutex_unlock(&self->m_mutex);
+
+    return NULL;
+}
+
 
 /*
  * Hook used to cancel a buffer that has been dequeued.
@@ -333,16 +397,25 @@ int FbDevNativeWindow::cancelBuffer(BaseNativeWindowBuffer* buffer, int fenceFd)
     TRACE("");
     FbDevNativeWindowBuffer* fbnb = (FbDevNativeWindowBuffer*)buffer;
 
-    pthread_mutex_lock(&_mutex);
+    pthread_mutex_lock(&m_mutex);
+    releaseBuffer(fbnb);
+    pthread_mutex_unlock(&m_mutex);
 
-    fbnb->busy=0;
+    return 0;
+}
 
-    m_freeBufs++;
+/*
+ * Makes a dequeued buffer available again. Called with the lock held.
+ */
+void FbDevNativeWindow::releaseBuffer(FbDevNativeWindowBuffer* fbnb)
+{
+    fbnb->busy=0;
 
-    pthread_cond_signal(&_cond);
-    pthread_mutex_unlock(&_mutex);
+    // The front buffer is freed when the next one is posted
+    if (fbnb != m_frontBuf)
+        m_freeBufs.push_back(fbnb);
 
-    return 0;
+    pthread_cond_broadcast(&m_cond);
 }
 
 
@@ -354,16 +427,16 @@ int FbDevNativeWindow::lockBuffer(BaseNativeWindowBuffer* buffer)
 
     HYBRIS_TRACE_BEGIN("fbdev-platform", "lockBuffer", "-%p", fbnb);
 
-    pthread_mutex_lock(&_mutex);
+    pthread_mutex_lock(&m_mutex);
 
     // wait that the buffer we're locking is not front anymore
     while (m_frontBuf==fbnb)
     {
         TRACE("waiting %p %p", m_frontBuf, fbnb);
-        pthread_cond_wait(&_cond, &_mutex);
+        pthread_cond_wait(&m_cond, &m_mutex);
     }
 
-    pthread_mutex_unlock(&_mutex);
+    pthread_mutex_unlock(&m_mutex);
     HYBRIS_TRACE_END("fbdev-platform", "lockBuffer", "-%p", fbnb);
     return NO_ERROR;
 }
@@ -508,15 +581,22 @@ int FbDevNativeWindow::setBuffersFormat(int format)
 int FbDevNativeWindow::setBufferCount(int cnt)
 {
     TRACE("cnt=%d", cnt);
+    pthread_mutex_lock(&m_mutex);
     if (m_bufferCount != cnt) {
         m_bufferCount = cnt;
         m_allocateBuffers = true;
     }
+    pthread_mutex_unlock(&m_mutex);
     return NO_ERROR;
 }
 
 void FbDevNativeWindow::reallocateBuffers()
 {
+    // Called with the lock held, from dequeueBuffer(). The buffers queued
+    // last may still be waiting to be posted
+    while (!m_postQueue.empty())
+        pthread_cond_wait(&m_cond, &m_mutex);
+
     destroyBuffers();
 
     for(unsigned int i = 0; i < m_bufferCount; i++)
@@ -534,11 +614,11 @@ void FbDevNativeWindow::reallocateBuffers()
         if (fbnb->status)
         {
             fbnb->common.decRef(&fbnb->common);
-            fprintf(stderr,"WARNING: %s: allocated only %d buffers out of %d\n", __PRETTY_FUNCTION__, m_freeBufs, m_bufferCount);
+            fprintf(stderr,"WARNING: %s: allocated only %d buffers out of %d\n", __PRETTY_FUNCTION__, (int) m_bufList.size(), m_bufferCount);
             break;
         }
 
-        m_freeBufs++;
+        m_freeBufs.push_back(fbnb);
         m_bufList.push_back(fbnb);
     }
 
@@ -22,6 +22,8 @@
 #include <hardware/gralloc.h>
 
 #include <list>
+#include <deque>
+#include <pthread.h>
 
 
 class FbDevNativeWindowBuffer : public BaseNativeWindowBuffer {
@@ -75,6 +77,9 @@ protected:
 private:
     void destroyBuffers();
     void reallocateBuffers();
+    void releaseBuffer(FbDevNativeWindowBuffer *fbnb);
+    int post(FbDevNativeWindowBuffer *fbnb, int fenceFd);
+    static void *postThread(void *data);
 
 private:
     framebuffer_device_t* m_fbDev;
@@ -82,11 +87,26 @@ private:
     unsigned int m_usage;
     unsigned int m_bufFormat;
     unsigned int m_bufferCount;
-    int m_freeBufs;
     bool m_allocateBuffers;
 
     std::list<FbDevNativeWindowBuffer*> m_bufList;
+    // Buffers that are neither dequeued, queued for posting nor on screen,
+    // in the order they were released
+    std::deque<FbDevNativeWindowBuffer*> m_freeBufs;
     FbDevNativeWindowBuffer* m_frontBuf;
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+
+    // Buffers queued by EGL, with their acquire fence, for postThread()
+    struct PostItem {
+        FbDevNativeWindowBuffer *buffer;
+        int fenceFd;
+    };
+    std::deque<PostItem> m_postQueue;
+    bool m_usePostThread;
+    bool m_postQuit;
+    pthread_t m_postThread;
 };
 
 #endif
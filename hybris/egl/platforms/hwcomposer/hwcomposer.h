@@ -27,6 +27,19 @@ struct ANativeWindowBuffer;
 typedef void (*HWCPresentCallback)(void *user_data, struct ANativeWindow *window,
                                    struct ANativeWindowBuffer *buffer);
 
+/** When a HWC ANativeWindow calls its present callback.
+ *
+ * \sa HWCNativeWindowSetPresentMode
+ */
+enum HWCPresentMode {
+    /** From eglSwapBuffers(), in the rendering thread. This is the default. */
+    HWC_PRESENT_MODE_IMMEDIATE = 0,
+    /** From a presenter thread owned by the window. */
+    HWC_PRESENT_MODE_THREAD,
+    /** Only from HWCNativeWindowPresentPending(). */
+    HWC_PRESENT_MODE_DEFERRED
+};
+
 /** Create a new HWC ANativeWindow.
  *
  * The Window can be casted to EGLNativeWindowType and used to create
@@ -34,6 +47,8 @@ typedef void (*HWCPresentCallback)(void *user_data, struct ANativeWindow *window
  * The specified present callback will be called by the window when a new
  * buffer is ready to be presented on screen. It is responsibility of the
  * caller to make sure that happens, by using the hwcomposer API.
+ * The window has 2 buffers, unless the HYBRIS_HWC_BUFFER_COUNT environment
+ * variable or native_window_set_buffer_count() say otherwise.
  * Returns the window on success or NULL on failure.
  *
  * \param width The width of the window in pixels.
@@ -58,6 +73,38 @@ struct ANativeWindow *HWCNativeWindowCreate(unsigned int width, unsigned int hei
  */
 void HWCNativeWindowDestroy(struct ANativeWindow *window);
 
+/** Set how the present callback of a HWC ANativeWindow is called.
+ *
+ * Buffers swapped by EGL are queued for presentation, and the present
+ * callback is always called without holding the window lock, in the order
+ * the buffers were queued. With HWC_PRESENT_MODE_THREAD or
+ * HWC_PRESENT_MODE_DEFERRED, the rendering thread can dequeue its next
+ * buffer while the previous one is being presented; it only blocks when
+ * all the buffers of the window are queued.
+ * Windows start in HWC_PRESENT_MODE_IMMEDIATE, or in HWC_PRESENT_MODE_THREAD
+ * if the HYBRIS_HWC_PRESENT_THREAD environment variable is set to 1.
+ * Returns 0 on success or -errno on failure.
+ *
+ * \param window The window, as returned by HWCNativeWindowCreate().
+ * \param mode The new present mode.
+ *
+ * \sa HWCNativeWindowPresentPending
+ */
+int HWCNativeWindowSetPresentMode(struct ANativeWindow *window, enum HWCPresentMode mode);
+
+/** Present the buffers queued on a HWC ANativeWindow.
+ *
+ * Calls the present callback for every buffer queued so far, from the
+ * calling thread. This is meant for HWC_PRESENT_MODE_DEFERRED, typically
+ * from the thread handling vsync; note that eglSwapBuffers() blocks when
+ * all the buffers of the window are queued, so it must not be the only
+ * caller in that mode.
+ * Returns the number of buffers presented.
+ *
+ * \sa HWCNativeWindowSetPresentMode
+ */
+int HWCNativeWindowPresentPending(struct ANativeWindow *window);
+
 /** Get the current fence FD on a buffer.
  *
  * The buffer must be a buffer passed from the HWC layer trough the present
@@ -42,6 +42,15 @@ extern "C" struct ANativeWindow *HWCNativeWindowCreate(unsigned int width, unsig
             , cb(p)
             , cb_data(d)
         {
+            const char *env = getenv("HYBRIS_HWC_PRESENT_THREAD");
+            if (env && atoi(env) > 0)
+                setPresentMode(HWC_PRESENT_MODE_THREAD);
+        }
+
+        ~Window()
+        {
+            // Stop the presenter thread while present() can still be called
+            setPresentMode(HWC_PRESENT_MODE_DEFERRED);
         }
 
         void present(HWComposerNativeWindowBuffer *b)
@@ -62,7 +71,17 @@ extern "C" struct ANativeWindow *HWCNativeWindowCreate(unsigned int width, unsig
 
 extern "C" void HWCNativeWindowDestroy(struct ANativeWindow *window)
 {
-    delete window;
+    delete static_cast<HWComposerNativeWindow *>(window);
+}
+
+extern "C" int HWCNativeWindowSetPresentMode(struct ANativeWindow *window, enum HWCPresentMode mode)
+{
+    return static_cast<HWComposerNativeWindow *>(window)->setPresentMode(mode);
+}
+
+extern "C" int HWCNativeWindowPresentPending(struct ANativeWindow *window)
+{
+    return static_cast<HWComposerNativeWindow *>(window)->presentPending();
 }
 
 struct _BufferFenceAccessor : public HWComposerNativeWindowBuffer {
@@ -97,6 +116,7 @@ HWComposerNativeWindowBuffer::HWComposerNativeWindowBuffer(alloc_device_t* alloc
     fenceFd = -1;
     busy = 0;
     status = 0;
+    released = 0;
     m_alloc = alloc_device;
 
     if (m_alloc) {
@@ -124,6 +144,10 @@ HWComposerNativeWindowBuffer::~HWComposerNativeWindowBuffer()
 HWComposerNativeWindow::HWComposerNativeWindow(unsigned int width, unsigned int height, unsigned int format)
 {
     pthread_mutex_init(&m_mutex, 0);
+    pthread_cond_init(&m_cond, 0);
+    pthread_mutex_init(&m_presentMutex, 0);
+    m_presentMode = HWC_PRESENT_MODE_IMMEDIATE;
+    m_presentQuit = false;
     m_alloc = NULL;
     m_width = width;
     m_height = height;
@@ -131,6 +155,11 @@ HWComposerNativeWindow::HWComposerNativeWindow(unsigned int width, unsigned int
     m_usage = GRALLOC_USAGE_HW_COMPOSER|GRALLOC_USAGE_HW_FB;
     m_bufferCount = 2;
     m_nextBuffer = 0;
+    m_releaseCount = 0;
+
+    const char *env = getenv("HYBRIS_HWC_BUFFER_COUNT");
+    if (env && atoi(env) > 0)
+        m_bufferCount = atoi(env);
 }
 
 void HWComposerNativeWindow::setup(gralloc_module_t* gralloc, alloc_device_t* alloc)
@@ -140,6 +169,14 @@ void HWComposerNativeWindow::setup(gralloc_module_t* gralloc, alloc_device_t* al
 
 HWComposerNativeWindow::~HWComposerNativeWindow()
 {
+    // Subclasses have to stop the presenter thread, see Window above
+    assert(m_presentMode != HWC_PRESENT_MODE_THREAD);
+
+    while (!m_presentQueue.empty()) {
+        HWComposerNativeWindowBuffer *b = m_presentQueue.front();
+        m_presentQueue.pop_front();
+        b->common.decRef(&b->common);
+    }
     destroyBuffers();
 }
 
@@ -199,21 +236,23 @@ int HWComposerNativeWindow::dequeueBuffer(BaseNativeWindowBuffer** buffer, int *
 
     pthread_mutex_lock(&m_mutex);
 
-    // Allocate buffers if the list is empty, typically on the first call
-    if (m_bufList.empty())
+    // Allocate the missing buffers, typically on the first call
+    if (m_bufList.size() < m_bufferCount)
         allocateBuffers();
     assert(!m_bufList.empty());
     assert(m_nextBuffer < m_bufList.size());
 
+    // Wait for a buffer if they are all queued for presentation (or
+    // dequeued and not yet queued).
+    HWComposerNativeWindowBuffer *b;
+    HYBRIS_TRACE_BEGIN("hwcomposer-platform", "dequeueBuffer_wait_for_buffer", "");
+    while ((b = selectBuffer()) == NULL)
+        pthread_cond_wait(&m_cond, &m_mutex);
+    HYBRIS_TRACE_END("hwcomposer-platform", "dequeueBuffer_wait_for_buffer", "");
 
-    // Grabe the next available buffer in the list and assign m_nextBuffer to
-    // the next one.
-    HWComposerNativeWindowBuffer *b = m_bufList.at(m_nextBuffer);
-    TRACE("idx=%d, buffer=%p, fence=%d", m_nextBuffer, b, b->fenceFd);
+    TRACE("buffer=%p, fence=%d", b, b->fenceFd);
+    b->busy = 1;
     *buffer = b;
-    m_nextBuffer++;
-    if (m_nextBuffer >= m_bufList.size())
-        m_nextBuffer = 0;
 
     // assign the buffer's fence to fenceFd and close/reset our fd.
     int fence = b->fenceFd;
@@ -257,15 +296,182 @@ int HWComposerNativeWindow::queueBuffer(BaseNativeWindowBuffer* buffer, int fenc
     pthread_mutex_lock(&m_mutex);
     assert(b->fenceFd == -1); // We reset it in dequeue, so it better be -1 still..
     b->fenceFd = fenceFd;
-    this->present(b);
+
+    // The buffer stays busy until it has been presented
+    b->common.incRef(&b->common);
+    m_presentQueue.push_back(b);
+    HYBRIS_TRACE_COUNTER("hwcomposer-platform", "present_queue", "%i", m_presentQueue.size());
+    pthread_cond_broadcast(&m_cond);
+    int mode = m_presentMode;
     pthread_mutex_unlock(&m_mutex);
 
+    if (mode == HWC_PRESENT_MODE_IMMEDIATE)
+        presentNext();
+
     TRACE("%lu %p %d", pthread_self(), b, b->fenceFd);
     HYBRIS_TRACE_END("hwcomposer-platform", "queueBuffer", "-%p", b);
 
     return 0;
 }
 
+/*
+ * Calls present() for the oldest queued buffer, without holding m_mutex so
+ * that the rendering thread can dequeue another buffer meanwhile.
+ *
+ * Returns false if no buffer was queued.
+ */
+bool HWComposerNativeWindow::presentNext()
+{
+    pthread_mutex_lock(&m_presentMutex);
+    pthread_mutex_lock(&m_mutex);
+    if (m_presentQueue.empty()) {
+        pthread_mutex_unlock(&m_mutex);
+        pthread_mutex_unlock(&m_presentMutex);
+        return false;
+    }
+    HWComposerNativeWindowBuffer *b = m_presentQueue.front();
+    m_presentQueue.pop_front();
+    pthread_mutex_unlock(&m_mutex);
+
+    HYBRIS_TRACE_BEGIN("hwcomposer-platform", "present", "-%p", b);
+    this->present(b);
+    HYBRIS_TRACE_END("hwcomposer-platform", "present", "-%p", b);
+
+    pthread_mutex_lock(&m_mutex);
+    releaseBuffer(b);
+    pthread_mutex_unlock(&m_mutex);
+    pthread_mutex_unlock(&m_presentMutex);
+
+    b->common.decRef(&b->common);
+    return true;
+}
+
+/*
+ * Makes a buffer available to dequeueBuffer() again. Called with m_mutex
+ * locked.
+ */
+void HWComposerNativeWindow::releaseBuffer(HWComposerNativeWindowBuffer *buffer)
+{
+    buffer->busy = 0;
+    buffer->released = ++m_releaseCount;
+    pthread_cond_broadcast(&m_cond);
+}
+
+/*
+ * Picks the buffer to render to next, among the ones not busy: the first
+ * one from m_nextBuffer on whose release fence has already signaled, so
+ * that the GPU doesn't have to wait for it, or else the one released the
+ * longest ago, whose fence is likely to signal first. Displays don't
+ * necessarily release buffers in the order they were presented.
+ * Called with m_mutex locked. Returns NULL if all buffers are busy.
+ */
+HWComposerNativeWindowBuffer *HWComposerNativeWindow::selectBuffer()
+{
+    HWComposerNativeWindowBuffer *oldest = NULL;
+    unsigned int count = m_bufList.size(), oldestIdx = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int idx = (m_nextBuffer + i) % count;
+        HWComposerNativeWindowBuffer *b = m_bufList.at(idx);
+
+        if (b->busy)
+            continue;
+
+        if (b->fenceFd != -1 && sync_wait(b->fenceFd, 0) == 0) {
+            // No need to hand out a fence that has already signaled
+            close(b->fenceFd);
+            b->fenceFd = -1;
+        }
+
+        if (b->fenceFd == -1) {
+            m_nextBuffer = (idx + 1) % count;
+            return b;
+        }
+
+        if (!oldest || b->released < oldest->released) {
+            oldest = b;
+            oldestIdx = idx;
+        }
+    }
+
+    if (oldest) {
+        HYBRIS_TRACE_BEGIN("hwcomposer-platform", "dequeueBuffer_unsignaled_fence", "-%p", oldest);
+        HYBRIS_TRACE_END("hwcomposer-platform", "dequeueBuffer_unsignaled_fence", "-%p", oldest);
+        m_nextBuffer = (oldestIdx + 1) % count;
+    }
+
+    return oldest;
+}
+
+int HWComposerNativeWindow::presentPending()
+{
+    int presented = 0;
+
+    while (presentNext())
+        presented++;
+
+    return presented;
+}
+
+void *HWComposerNativeWindow::presentThread(void *data)
+{
+    HWComposerNativeWindow *self = static_cast<HWComposerNativeWindow *>(data);
+
+    pthread_mutex_lock(&self->m_mutex);
+    while (!self->m_presentQuit) {
+        if (self->m_presentQueue.empty()) {
+            pthread_cond_wait(&self->m_cond, &self->m_mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&self->m_mutex);
+        self->presentNext();
+        pthread_mutex_lock(&self->m_mutex);
+    }
+    pthread_mutex_unlock(&self->m_mutex);
+
+    return NULL;
+}
+
+/*
+ * Starts or stops the presenter thread as needed, see HWCPresentMode.
+ *
+ * Returns 0 on success or -errno on error.
+ */
+int HWComposerNativeWindow::setPresentMode(int mode)
+{
+    int ret = 0;
+
+    TRACE("mode=%d", mode);
+
+    if (mode < HWC_PRESENT_MODE_IMMEDIATE || mode > HWC_PRESENT_MODE_DEFERRED)
+        return -EINVAL;
+
+    pthread_mutex_lock(&m_mutex);
+    int old = m_presentMode;
+
+    if (old == HWC_PRESENT_MODE_THREAD && mode != HWC_PRESENT_MODE_THREAD) {
+        m_presentQuit = true;
+        pthread_cond_broadcast(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+        pthread_join(m_presentThread, NULL);
+        pthread_mutex_lock(&m_mutex);
+        m_presentQuit = false;
+    } else if (mode == HWC_PRESENT_MODE_THREAD && old != HWC_PRESENT_MODE_THREAD) {
+        ret = -pthread_create(&m_presentThread, NULL, presentThread, this);
+        if (ret)
+            mode = old;
+    }
+
+    m_presentMode = mode;
+    pthread_mutex_unlock(&m_mutex);
+
+    // Whatever is left in the queue is presented as of the new mode
+    if (mode == HWC_PRESENT_MODE_IMMEDIATE)
+        presentPending();
+
+    return ret;
+}
+
 int HWComposerNativeWindow::getFenceBufferFd(HWComposerNativeWindowBuffer *buffer)
 {
     return buffer->fenceFd;
@@ -311,6 +517,7 @@ int HWComposerNativeWindow::cancelBuffer(BaseNativeWindowBuffer* buffer, int fen
     // Assign the fence so we can pass it on in dequeue when the buffer is
     // again acquired.
     fbnb->fenceFd = fenceFd;
+    releaseBuffer(fbnb);
 
     pthread_mutex_unlock(&m_mutex);
     return 0;
@@ -474,9 +681,16 @@ int HWComposerNativeWindow::setBuffersFormat(int format)
 int HWComposerNativeWindow::setBufferCount(int count)
 {
     TRACE("cnt=%d", count);
-    if ((unsigned int) count != m_bufferCount)
+    if (count < 1)
+        return -EINVAL;
+
+    pthread_mutex_lock(&m_mutex);
+    // More buffers are allocated on the next dequeue, while keeping the
+    // current ones; fewer buffers are reallocated from scratch.
+    if ((unsigned int) count < m_bufList.size())
         destroyBuffers();
     m_bufferCount = count;
+    pthread_mutex_unlock(&m_mutex);
     return NO_ERROR;
 }
 
@@ -486,7 +700,7 @@ void HWComposerNativeWindow::allocateBuffers()
     // m_mutex, so we do this without locking here.
     TRACE("cnt=%d", m_bufferCount);
 
-    for(unsigned int i = 0; i < m_bufferCount; i++)
+    for(unsigned int i = m_bufList.size(); i < m_bufferCount; i++)
     {
         HWComposerNativeWindowBuffer *b
          = new HWComposerNativeWindowBuffer(m_alloc, m_width, m_height, m_bufFormat, m_usage);
@@ -500,14 +714,14 @@ void HWComposerNativeWindow::allocateBuffers()
         if (b->status) {
             b->common.decRef(&b->common);
             fprintf(stderr,"WARNING: %s: allocated only %d buffers out of %d\n", __PRETTY_FUNCTION__, m_bufList.size(), m_bufferCount);
+            // Don't retry on every dequeue
+            if (!m_bufList.empty())
+                m_bufferCount = m_bufList.size();
             break;
         }
 
         m_bufList.push_back(b);
     }
-
-    // Restart the count, to avoid out-of-bounds access if it shrinked.
-    m_nextBuffer = 0;
 }
 
 /*
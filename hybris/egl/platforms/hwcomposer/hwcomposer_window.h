@@ -22,6 +22,7 @@
 #include <hardware/gralloc.h>
 
 #include <vector>
+#include <deque>
 
 
 class HWComposerNativeWindowBuffer : public BaseNativeWindowBuffer {
@@ -39,6 +40,8 @@ protected:
     int busy;
     int fenceFd;
     int status;
+    // when the buffer was last released, see HWComposerNativeWindow::selectBuffer()
+    unsigned int released;
     alloc_device_t* m_alloc;
 };
 
@@ -52,6 +55,9 @@ public:
 
     int getFenceBufferFd(HWComposerNativeWindowBuffer *buffer);
     void setFenceBufferFd(HWComposerNativeWindowBuffer *buffer, int fd);
+
+    int setPresentMode(int mode);
+    int presentPending();
 protected:
     // overloads from BaseNativeWindow
     virtual int setSwapInterval(int interval);
@@ -80,6 +86,10 @@ protected:
 private:
     void destroyBuffers();
     void allocateBuffers();
+    bool presentNext();
+    HWComposerNativeWindowBuffer *selectBuffer();
+    void releaseBuffer(HWComposerNativeWindowBuffer *buffer);
+    static void *presentThread(void *data);
 
 private:
     framebuffer_device_t* m_fbDev;
@@ -89,11 +99,21 @@ private:
     std::vector<HWComposerNativeWindowBuffer*> m_bufList;
     unsigned int m_bufferCount;
     unsigned int m_nextBuffer;
+    unsigned int m_releaseCount;
 
     int m_width;
     int m_height;
 
     pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+
+    // Buffers queued by EGL, waiting for present(); m_presentMutex keeps
+    // them in order when several threads present
+    std::deque<HWComposerNativeWindowBuffer*> m_presentQueue;
+    pthread_mutex_t m_presentMutex;
+    int m_presentMode;
+    pthread_t m_presentThread;
+    bool m_presentQuit;
 };
 
 #endif
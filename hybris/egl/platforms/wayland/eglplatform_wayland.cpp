@@ -253,9 +253,10 @@ extern "C" const char *waylandws_eglQueryString(EGLDisplay dpy, EGLint name, con
 	const char *ret = eglplatformcommon_eglQueryString(dpy, name, real_eglQueryString);
 	if (ret && name == EGL_EXTENSIONS)
 	{
-		static char eglextensionsbuf[1024];
-		snprintf(eglextensionsbuf, 1022, "%s %s", ret,
-			"EGL_EXT_swap_buffers_with_damage EGL_WL_create_wayland_buffer_from_image"
+		static char eglextensionsbuf[2048];
+		snprintf(eglextensionsbuf, sizeof(eglextensionsbuf), "%s %s", ret,
+			"EGL_EXT_swap_buffers_with_damage EGL_WL_create_wayland_buffer_from_image "
+			"EGL_EXT_buffer_age"
 		);
 		ret = eglextensionsbuf;
 	}
@@ -286,6 +287,12 @@ extern "C" void waylandws_setSwapInterval(EGLDisplay dpy, EGLNativeWindowType wi
 	window->setSwapInterval(interval);
 }
 
+extern "C" EGLint waylandws_getBufferAge(EGLDisplay dpy, EGLNativeWindowType win)
+{
+	WaylandNativeWindow *window = static_cast<WaylandNativeWindow *>((struct ANativeWindow *)win);
+	return window->bufferAge();
+}
+
 struct ws_module ws_module_info = {
 	waylandws_init_module,
 	waylandws_GetDisplay,
@@ -298,6 +305,7 @@ struct ws_module ws_module_info = {
 	waylandws_prepareSwap,
 	waylandws_finishSwap,
 	waylandws_setSwapInterval,
+	waylandws_getBufferAge,
 };
 
 
@@ -32,6 +32,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 #include "logging.h"
 #include <eglhybris.h>
@@ -206,14 +209,38 @@ WaylandNativeWindow::WaylandNativeWindow(struct wl_egl_window *window, struct wl
     m_freeBufs = 0;
     m_damage_rects = NULL;
     m_damage_n_rects = 0;
+    m_frame = 0;
     m_lastBuffer = 0;
+    m_reserved = NULL;
     setBufferCount(3);
+
+    m_useDispatchThread = false;
+    m_dispatchError = 0;
+    const char *env = getenv("HYBRIS_WAYLAND_DISPATCH_THREAD");
+    if (env && atoi(env) > 0) {
+        m_dispatchWakeFd = eventfd(0, EFD_CLOEXEC);
+        if (m_dispatchWakeFd >= 0 &&
+            pthread_create(&m_dispatchThread, NULL, dispatch_thread, this) == 0) {
+            m_useDispatchThread = true;
+        } else {
+            TRACE("cannot start the dispatch thread, dispatching from the render threads");
+            if (m_dispatchWakeFd >= 0)
+                close(m_dispatchWakeFd);
+        }
+    }
     HYBRIS_TRACE_END("wayland-platform", "create_window", "");
 }
 
 WaylandNativeWindow::~WaylandNativeWindow()
 {
     std::list<WaylandNativeWindowBuffer *>::iterator it = m_bufList.begin();
+    if (m_useDispatchThread) {
+        uint64_t quit = 1;
+        write(m_dispatchWakeFd, &quit, sizeof(quit));
+        pthread_join(m_dispatchThread, NULL);
+        close(m_dispatchWakeFd);
+        m_useDispatchThread = false;
+    }
     destroyBuffers();
     if (frame_callback)
         wl_callback_destroy(frame_callback);
@@ -280,7 +307,6 @@ void WaylandNativeWindow::releaseBuffer(struct wl_buffer *buffer)
         posted.erase(it);
         TRACE("released posted buffer: %p", buffer);
         pwnb->busy = 0;
-        unlock();
         return;
     }
 
@@ -321,13 +347,14 @@ void WaylandNativeWindow::releaseBuffer(struct wl_buffer *buffer)
 }
 
 
-int WaylandNativeWindow::dequeueBuffer(BaseNativeWindowBuffer **buffer, int *fenceFd){
-    HYBRIS_TRACE_BEGIN("wayland-platform", "dequeueBuffer", "");
-
+/*
+ * Waits for a free buffer and takes it, re-allocating it if it doesn't match
+ * the window anymore. Returns NULL if there is none. Called with the lock.
+ */
+WaylandNativeWindowBuffer *WaylandNativeWindow::takeBuffer()
+{
     WaylandNativeWindowBuffer *wnb=NULL;
-    TRACE("%p", buffer);
 
-    lock();
     readQueue(false);
 
     HYBRIS_TRACE_BEGIN("wayland-platform", "dequeueBuffer_wait_for_buffer", "");
@@ -359,11 +386,9 @@ int WaylandNativeWindow::dequeueBuffer(BaseNativeWindowBuffer **buffer, int *fen
 
     }
     if (it==m_bufList.end()) {
-        unlock();
         HYBRIS_TRACE_BEGIN("wayland-platform", "dequeueBuffer_no_free_buffers", "");
         HYBRIS_TRACE_END("wayland-platform", "dequeueBuffer_no_free_buffers", "");
-        TRACE("%p: no free buffers", buffer);
-        return NO_ERROR;
+        return NULL;
     }
 
     wnb = *it;
@@ -384,8 +409,6 @@ int WaylandNativeWindow::dequeueBuffer(BaseNativeWindowBuffer **buffer, int *fen
     }
 
     wnb->busy = 1;
-    *buffer = wnb;
-    queue.push_back(wnb);
     --m_freeBufs;
 
     HYBRIS_TRACE_COUNTER("wayland-platform", "m_freeBufs", "%i", m_freeBufs);
@@ -393,6 +416,38 @@ int WaylandNativeWindow::dequeueBuffer(BaseNativeWindowBuffer **buffer, int *fen
     HYBRIS_TRACE_END("wayland-platform", "dequeueBuffer_gotBuffer", "-%p", wnb);
     HYBRIS_TRACE_END("wayland-platform", "dequeueBuffer_wait_for_buffer", "");
 
+    return wnb;
+}
+
+int WaylandNativeWindow::dequeueBuffer(BaseNativeWindowBuffer **buffer, int *fenceFd){
+    HYBRIS_TRACE_BEGIN("wayland-platform", "dequeueBuffer", "");
+
+    WaylandNativeWindowBuffer *wnb=NULL;
+    TRACE("%p", buffer);
+
+    lock();
+
+    /* The buffer whose age was queried, if it still matches the window */
+    wnb = m_reserved;
+    m_reserved = NULL;
+    if (wnb && (wnb->width != m_window->width || wnb->height != m_window->height
+                || wnb->format != m_format || wnb->usage != m_usage)) {
+        wnb->busy = 0;
+        ++m_freeBufs;
+        wnb = NULL;
+    }
+
+    if (!wnb)
+        wnb = takeBuffer();
+    if (!wnb) {
+        unlock();
+        TRACE("%p: no free buffers", buffer);
+        return NO_ERROR;
+    }
+
+    *buffer = wnb;
+    queue.push_back(wnb);
+
     unlock();
     return NO_ERROR;
 }
@@ -463,6 +518,13 @@ int WaylandNativeWindow::readQueue(bool block)
 {
     int ret = 0;
 
+    if (m_useDispatchThread) {
+        // The events are already dispatched, and cond is broadcast after each batch
+        if (block && m_dispatchError == 0)
+            pthread_cond_wait(&cond, &mutex);
+        return m_dispatchError;
+    }
+
     if (++m_queueReads == 1) {
         if (block) {
             ret = wl_display_dispatch_queue(m_display, wl_queue);
@@ -495,6 +557,75 @@ int WaylandNativeWindow::readQueue(bool block)
     return ret;
 }
 
+void *WaylandNativeWindow::dispatch_thread(void *data)
+{
+    static_cast<WaylandNativeWindow *>(data)->dispatchEvents();
+    return NULL;
+}
+
+/*
+ * Optional (HYBRIS_WAYLAND_DISPATCH_THREAD=1) per-window thread, which reads
+ * and dispatches the events of wl_queue as soon as they arrive: buffer
+ * releases and frame callbacks then only wake up the render threads through
+ * cond, instead of these blocking in wl_display_dispatch_queue() with the
+ * window locked.
+ */
+void WaylandNativeWindow::dispatchEvents()
+{
+    struct pollfd fds[2];
+    bool quit = false;
+    int ret = 0;
+
+    fds[0].fd = wl_display_get_fd(m_display);
+    fds[0].events = POLLIN;
+    fds[1].fd = m_dispatchWakeFd;
+    fds[1].events = POLLIN;
+
+    while (!quit && ret >= 0) {
+        // Listeners expect the window to be locked, as with readQueue()
+        lock();
+        while (ret >= 0 && wl_display_prepare_read_queue(m_display, wl_queue) != 0)
+            ret = wl_display_dispatch_queue_pending(m_display, wl_queue);
+        pthread_cond_broadcast(&cond);
+        unlock();
+
+        if (ret < 0)
+            break;
+
+        wl_display_flush(m_display);
+
+        fds[0].revents = fds[1].revents = 0;
+        ret = poll(fds, 2, -1);
+        if (ret < 0 && errno == EINTR) {
+            wl_display_cancel_read(m_display);
+            ret = 0;
+            continue;
+        }
+
+        if (ret < 0 || fds[1].revents) {
+            wl_display_cancel_read(m_display);
+            quit = fds[1].revents != 0;
+        } else if (fds[0].revents & POLLIN) {
+            HYBRIS_TRACE_BEGIN("wayland-platform", "dispatch_thread_read", "");
+            ret = wl_display_read_events(m_display);
+            HYBRIS_TRACE_END("wayland-platform", "dispatch_thread_read", "");
+        } else {
+            wl_display_cancel_read(m_display);
+            ret = -1;
+        }
+    }
+
+    if (quit)
+        return;
+
+    TRACE("wayland event dispatch failed");
+    lock();
+    m_dispatchError = -1;
+    pthread_cond_broadcast(&cond);
+    unlock();
+    check_fatal_error(m_display);
+}
+
 void WaylandNativeWindow::prepareSwap(EGLint *damage_rects, EGLint damage_n_rects)
 {
     lock();
@@ -503,6 +634,65 @@ void WaylandNativeWindow::prepareSwap(EGLint *damage_rects, EGLint damage_n_rect
     unlock();
 }
 
+/*
+ * Damage what changed in the buffer, or all of it if we don't know.
+ * EGL rectangles have their origin at the bottom left of the surface, while
+ * Wayland ones have theirs at the top left.
+ */
+void WaylandNativeWindow::damage(WaylandNativeWindowBuffer *wnb)
+{
+    if (m_damage_n_rects <= 0 || !m_damage_rects) {
+        wl_surface_damage(m_window->surface, 0, 0, wnb->width, wnb->height);
+        return;
+    }
+
+#ifdef WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION
+    bool buffer_damage = wl_proxy_get_version((struct wl_proxy *) m_window->surface) >=
+                         WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION;
+#endif
+
+    for (int i = 0; i < m_damage_n_rects; i++) {
+        EGLint *rect = &m_damage_rects[i * 4];
+        int32_t y = wnb->height - rect[1] - rect[3];
+
+        TRACE("%p DAMAGE AREA: %d,%d %dx%d", wnb, rect[0], y, rect[2], rect[3]);
+#ifdef WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION
+        if (buffer_damage) {
+            wl_surface_damage_buffer(m_window->surface, rect[0], y, rect[2], rect[3]);
+            continue;
+        }
+#endif
+        // Without a buffer transform or scale, these are the same coordinates
+        wl_surface_damage(m_window->surface, rect[0], y, rect[2], rect[3]);
+    }
+}
+
+/*
+ * EGL_EXT_buffer_age of the buffer being rendered to: the number of frames
+ * since it was presented, or 0 if its content is unknown. The age may be
+ * queried before drawing, so before the buffer is dequeued: the buffer is
+ * then taken now, and handed out by the next dequeueBuffer().
+ */
+EGLint WaylandNativeWindow::bufferAge()
+{
+    WaylandNativeWindowBuffer *wnb;
+    EGLint age = 0;
+
+    lock();
+    if (!queue.empty()) {
+        wnb = queue.back();
+    } else {
+        if (!m_reserved)
+            m_reserved = takeBuffer();
+        wnb = m_reserved;
+    }
+    if (wnb && wnb->frame)
+        age = m_frame + 1 - wnb->frame;
+    unlock();
+
+    return age;
+}
+
 void WaylandNativeWindow::finishSwap()
 {
     int ret = 0;
@@ -544,8 +734,9 @@ void WaylandNativeWindow::finishSwap()
     }
 
     wl_surface_attach(m_window->surface, wnb->wlbuffer, 0, 0);
-    wl_surface_damage(m_window->surface, 0, 0, wnb->width, wnb->height);
+    damage(wnb);
     wl_surface_commit(m_window->surface);
+    wnb->frame = ++m_frame;
     // Some compositors, namely Weston, queue buffer release events instead
     // of sending them immediately.  If a frame event is used, this should
     // not be a problem.  Without a frame event, we need to send a sync
@@ -629,7 +820,10 @@ int WaylandNativeWindow::cancelBuffer(BaseNativeWindowBuffer* buffer, int fenceF
     }
     wnb->youngest = 1;
 
-    if (m_queueReads != 0) {
+    if (m_useDispatchThread) {
+        // Threads waiting for a free buffer only wait on cond
+        pthread_cond_broadcast(&cond);
+    } else if (m_queueReads != 0) {
         // Some thread is waiting on wl_display_dispatch_queue(), possibly waiting for a wl_buffer.release
         // event. Since we have now cancelled a buffer push an artificial event so that the dispatch returns
         // and the thread can notice the cancelled buffer. This means there is a delay of one roundtrip,
@@ -713,6 +907,11 @@ void WaylandNativeWindow::destroyBuffer(WaylandNativeWindowBuffer* wnb)
 
     assert(wnb != NULL);
 
+    if (wnb == m_reserved) {
+        m_reserved = NULL;
+        ++m_freeBufs;
+    }
+
     int ret = 0;
     while (ret != -1 && wnb->creation_callback)
         ret = wl_display_dispatch_queue(m_display, wl_queue);
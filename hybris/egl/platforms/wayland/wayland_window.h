@@ -42,7 +42,7 @@ extern "C" {
 class WaylandNativeWindowBuffer : public BaseNativeWindowBuffer
 {
 public:
-    WaylandNativeWindowBuffer() : wlbuffer(0), busy(0), youngest(0), other(0), creation_callback(0) {}
+    WaylandNativeWindowBuffer() : wlbuffer(0), busy(0), youngest(0), frame(0), other(0), creation_callback(0) {}
     WaylandNativeWindowBuffer(ANativeWindowBuffer *other)
     {
         ANativeWindowBuffer::width = other->width;
@@ -56,11 +56,14 @@ public:
         this->busy = 0;
         this->other = other;
         this->youngest = 0;
+        this->frame = 0;
     }
 
     struct wl_buffer *wlbuffer;
     int busy;
     int youngest;
+    // the frame this buffer was last presented in, 0 if never
+    unsigned int frame;
     ANativeWindowBuffer *other;
     struct wl_callback *creation_callback;
 
@@ -160,8 +163,10 @@ public:
     virtual int setSwapInterval(int interval);
     void prepareSwap(EGLint *damage_rects, EGLint damage_n_rects);
     void finishSwap();
+    EGLint bufferAge();
 
     static void sync_callback(void *data, struct wl_callback *callback, uint32_t serial);
+    static void *dispatch_thread(void *data);
     static void registry_handle_global(void *data, struct wl_registry *registry, uint32_t name,
                        const char *interface, uint32_t version);
     static void resize_callback(struct wl_egl_window *egl_window, void *);
@@ -191,9 +196,12 @@ protected:
 
 private:
     WaylandNativeWindowBuffer *addBuffer();
+    WaylandNativeWindowBuffer *takeBuffer();
     void destroyBuffer(WaylandNativeWindowBuffer *);
     void destroyBuffers();
     int readQueue(bool block);
+    void dispatchEvents();
+    void damage(WaylandNativeWindowBuffer *wnb);
 
     std::list<WaylandNativeWindowBuffer *> m_bufList;
     std::list<WaylandNativeWindowBuffer *> fronted;
@@ -203,6 +211,8 @@ private:
     struct wl_egl_window *m_window;
     struct wl_display *m_display;
     WaylandNativeWindowBuffer *m_lastBuffer;
+    // taken by bufferAge() for the next dequeueBuffer()
+    WaylandNativeWindowBuffer *m_reserved;
     unsigned int m_width;
     unsigned int m_height;
     unsigned int m_format;
@@ -214,8 +224,14 @@ private:
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     int m_queueReads;
+    // events of wl_queue are dispatched by m_dispatchThread, see dispatchEvents()
+    bool m_useDispatchThread;
+    pthread_t m_dispatchThread;
+    int m_dispatchWakeFd;
+    int m_dispatchError;
     int m_freeBufs;
     EGLint *m_damage_rects, m_damage_n_rects;
+    unsigned int m_frame;
     struct wl_callback *frame_callback;
     int m_swap_interval;
     static int wayland_roundtrip(WaylandNativeWindow *display);
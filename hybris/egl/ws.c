@@ -118,4 +118,12 @@ void ws_setSwapInterval(EGLDisplay dpy, EGLNativeWindowType win, EGLint interval
 		ws->setSwapInterval(dpy, win, interval);
 }
 
+EGLint ws_getBufferAge(EGLDisplay dpy, EGLNativeWindowType win)
+{
+	_init_ws();
+	if (ws->getBufferAge)
+		return ws->getBufferAge(dpy, win);
+	return -1;
+}
+
 // vim:ts=4:sw=4:noexpandtab
@@ -8,6 +8,8 @@ struct ws_egl_interface {
 
 	int (*has_mapping)(EGLSurface surface);
 	EGLNativeWindowType (*get_mapping)(EGLSurface surface);
+	/* To be called before a buffer is released by eglHybrisReleaseNativeBuffer */
+	void (*release_buffer)(EGLClientBuffer buffer);
 };
 
 struct egl_image
@@ -15,6 +17,12 @@ struct egl_image
     EGLImageKHR egl_image;
     EGLClientBuffer egl_buffer;
     EGLenum target;
+
+    /* Only used by libEGL */
+    EGLDisplay dpy;
+    int refcount;
+    int cached;
+    struct egl_image *next;
 };
 
 /* Defined in egl.c */
@@ -37,6 +45,8 @@ struct ws_module {
 	void (*prepareSwap)(EGLDisplay dpy, EGLNativeWindowType win, EGLint *damage_rects, EGLint damage_n_rects);
 	void (*finishSwap)(EGLDisplay dpy, EGLNativeWindowType win);
 	void (*setSwapInterval)(EGLDisplay dpy, EGLNativeWindowType win, EGLint interval);
+	/* Returns the EGL_BUFFER_AGE_EXT of the back buffer the next frame is drawn to, or -1 if the platform doesn't track it */
+	EGLint (*getBufferAge)(EGLDisplay dpy, EGLNativeWindowType win);
 };
 
 struct _EGLDisplay *ws_GetDisplay(EGLNativeDisplayType native);
@@ -49,5 +59,6 @@ const char *ws_eglQueryString(EGLDisplay dpy, EGLint name, const char *(*real_eg
 void ws_prepareSwap(EGLDisplay dpy, EGLNativeWindowType win, EGLint *damage_rects, EGLint damage_n_rects);
 void ws_finishSwap(EGLDisplay dpy, EGLNativeWindowType win);
 void ws_setSwapInterval(EGLDisplay dpy, EGLNativeWindowType win, EGLint interval);
+EGLint ws_getBufferAge(EGLDisplay dpy, EGLNativeWindowType win);
 
 #endif
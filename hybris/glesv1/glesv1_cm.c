@@ -24,6 +24,8 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+/* GL entry points are called too often to check on each call if resolved */
+#define HYBRIS_BINDING_EAGER
 #include <hybris/common/binding.h>
 
 #define GLESV1_CM_LIBRARY_PATH "libGLESv1_CM.so"
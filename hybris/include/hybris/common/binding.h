@@ -67,13 +67,6 @@ int android_dladdr(const void *addr, void *info);
         *(fptr) = (void *) android_dlsym(name##_handle, sym); \
     }
 
-#define HYBRIS_LIBRARY_INITIALIZE(name, path) \
-    void *name##_handle; \
-    void hybris_##name##_initialize() \
-    { \
-        name##_handle = android_dlopen(path, RTLD_LAZY); \
-    }
-
 #define HYBRIS_LIRBARY_CHECK_SYMBOL(name) \
     bool hybris_##name##_check_for_symbol(const char *sym) \
     { \
@@ -82,6 +75,16 @@ int android_dladdr(const void *addr, void *info);
 
 
 
+#ifndef HYBRIS_BINDING_EAGER
+
+#define HYBRIS_LIBRARY_INITIALIZE(name, path) \
+    void *name##_handle; \
+    void hybris_##name##_initialize() \
+    { \
+        name##_handle = android_dlopen(path, RTLD_LAZY); \
+    }
+
+
 #define HYBRIS_IMPLEMENT_FUNCTION_CHECKED0(name, return_type, symbol) \
     return_type symbol() \
     { \
@@ -642,6 +645,612 @@ int android_dladdr(const void *addr, void *info);
     }
 
 
+#else /* HYBRIS_BINDING_EAGER */
+
+/**
+ * Eager binding, for libraries whose entry points are called often enough
+ * that checking on every call whether they are resolved shows, such as GL.
+ * Define HYBRIS_BINDING_EAGER before including this header: the library is
+ * then opened when it is loaded, as glesv2 does, and each wrapper is a
+ * single jump through a pointer that is already set.
+ *
+ * Each wrapper adds its pointer to the table in the "hybris_binding_<name>"
+ * section, which the constructor walks using the bounds the linker defines.
+ **/
+
+struct hybris_binding
+{
+    const char *symbol;
+    void **fptr;
+};
+
+#define HYBRIS_LIBRARY_INITIALIZE(name, path) \
+    void *name##_handle; \
+    extern struct hybris_binding __start_hybris_binding_##name[] __attribute__((weak)); \
+    extern struct hybris_binding __stop_hybris_binding_##name[] __attribute__((weak)); \
+    void hybris_##name##_initialize() \
+    { \
+        struct hybris_binding *b; \
+        name##_handle = android_dlopen(path, RTLD_LAZY); \
+        if (!name##_handle) \
+            return; \
+        for (b = __start_hybris_binding_##name; b < __stop_hybris_binding_##name; b++) \
+            *b->fptr = android_dlsym(name##_handle, b->symbol); \
+    } \
+    static void __attribute__((constructor)) hybris_##name##_bind() \
+    { \
+        hybris_##name##_initialize(); \
+    }
+
+#define HYBRIS_BIND_SYMBOL(name, symbol, fptr) \
+    static struct hybris_binding hybris_binding_##name##_##symbol \
+        __attribute__((section("hybris_binding_" #name), used, aligned(sizeof(void *)))) = \
+        { #symbol, (void **) &fptr }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED0(name, return_type, symbol) \
+    static return_type (*hybris_##name##_##symbol)() FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol() \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION0(name, return_type, symbol) \
+    static return_type (*hybris_##name##_##symbol)() FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol() \
+    { \
+        return hybris_##name##_##symbol(); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED1(name, return_type, symbol, a1) \
+    static return_type (*hybris_##name##_##symbol)(a1) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION1(name, return_type, symbol, a1) \
+    static return_type (*hybris_##name##_##symbol)(a1) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1) \
+    { \
+        return hybris_##name##_##symbol(n1); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED2(name, return_type, symbol, a1, a2) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION2(name, return_type, symbol, a1, a2) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2) \
+    { \
+        return hybris_##name##_##symbol(n1, n2); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED3(name, return_type, symbol, a1, a2, a3) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION3(name, return_type, symbol, a1, a2, a3) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED4(name, return_type, symbol, a1, a2, a3, a4) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION4(name, return_type, symbol, a1, a2, a3, a4) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED5(name, return_type, symbol, a1, a2, a3, a4, a5) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION5(name, return_type, symbol, a1, a2, a3, a4, a5) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED6(name, return_type, symbol, a1, a2, a3, a4, a5, a6) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION6(name, return_type, symbol, a1, a2, a3, a4, a5, a6) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED7(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION7(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED8(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION8(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED9(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION9(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED10(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION10(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED11(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION11(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED12(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION12(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED13(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION13(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED14(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION14(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED15(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION15(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED16(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION16(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED17(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION17(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED18(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17, a18 n18) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17, n18); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION18(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17, a18 n18) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17, n18); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED19(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17, a18 n18, a19 n19) \
+    { \
+        if (!hybris_##name##_##symbol) \
+            return -EINVAL; \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17, n18, n19); \
+    }
+
+#define HYBRIS_IMPLEMENT_FUNCTION19(name, return_type, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19) \
+    static return_type (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    return_type symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17, a18 n18, a19 n19) \
+    { \
+        return hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17, n18, n19); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION0(name, symbol) \
+    static void (*hybris_##name##_##symbol)() FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol() \
+    { \
+        hybris_##name##_##symbol(); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION1(name, symbol, a1) \
+    static void (*hybris_##name##_##symbol)(a1) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1) \
+    { \
+        hybris_##name##_##symbol(n1); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION2(name, symbol, a1, a2) \
+    static void (*hybris_##name##_##symbol)(a1, a2) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2) \
+    { \
+        hybris_##name##_##symbol(n1, n2); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION3(name, symbol, a1, a2, a3) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION4(name, symbol, a1, a2, a3, a4) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION5(name, symbol, a1, a2, a3, a4, a5) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION6(name, symbol, a1, a2, a3, a4, a5, a6) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION7(name, symbol, a1, a2, a3, a4, a5, a6, a7) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION8(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION9(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION10(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION11(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION12(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION13(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION14(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION15(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION16(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION17(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION18(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17, a18 n18) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17, n18); \
+    }
+
+
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION19(name, symbol, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19) \
+    static void (*hybris_##name##_##symbol)(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19) FP_ATTRIB; \
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \
+    void symbol(a1 n1, a2 n2, a3 n3, a4 n4, a5 n5, a6 n6, a7 n7, a8 n8, a9 n9, a10 n10, a11 n11, a12 n12, a13 n13, a14 n14, a15 n15, a16 n16, a17 n17, a18 n18, a19 n19) \
+    { \
+        hybris_##name##_##symbol(n1, n2, n3, n4, n5, n6, n7, n8, n9, n10, n11, n12, n13, n14, n15, n16, n17, n18, n19); \
+    }
+
+
+#endif /* HYBRIS_BINDING_EAGER */
+
+
 /**
  *         XXX AUTO-GENERATED FILE XXX
  *
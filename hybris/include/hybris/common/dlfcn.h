@@ -18,11 +18,36 @@
 #ifndef _HYBRIS_DLFCN_H_
 #define _HYBRIS_DLFCN_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Flags of hybris_dlextinfo, the ANDROID_DLEXT_* flags of <android/dlext.h> */
+#define HYBRIS_DLEXT_RESERVED_ADDRESS           0x1
+#define HYBRIS_DLEXT_RESERVED_ADDRESS_HINT      0x2
+#define HYBRIS_DLEXT_WRITE_RELRO                0x4
+#define HYBRIS_DLEXT_USE_RELRO                  0x8
+#define HYBRIS_DLEXT_USE_LIBRARY_FD             0x10
+#define HYBRIS_DLEXT_USE_LIBRARY_FD_OFFSET      0x20
+#define HYBRIS_DLEXT_FORCE_LOAD                 0x40
+
+/* android_dlextinfo, for programs built without the Android headers */
+typedef struct {
+    uint64_t flags;
+    void *reserved_addr;
+    size_t reserved_size;
+    int relro_fd;
+    int library_fd;
+    int64_t library_fd_offset;
+    void *library_namespace;
+} hybris_dlextinfo;
+
 void *hybris_dlopen(const char *filename, int flag);
+/* android_dlopen_ext(), fails with the jb linker */
+void *hybris_dlopen_ext(const char *filename, int flag, const hybris_dlextinfo *extinfo);
 void *hybris_dlsym(void *handle, const char *symbol);
 int   hybris_dlclose(void *handle);
 const char *hybris_dlerror(void);
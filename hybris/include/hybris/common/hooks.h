@@ -29,6 +29,10 @@ typedef void* (*hybris_hook_cb)(const char *symbol_name, const char *requester);
 
 void hybris_set_hook_callback(hybris_hook_cb callback);
 
+/* Resolve a symbol the same way the linker does when relocating a library:
+ * returns the hybris hook for symbol_name, or NULL if bionic should provide it. */
+void *hybris_get_hooked_symbol(const char *symbol_name, const char *requester);
+
 #ifdef __cplusplus
 }
 #endif
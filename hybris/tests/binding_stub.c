@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Stand-in for an Android library, loaded by test_binding through the hybris
+ * linker. It is built without libc so that it has nothing to pull in, and
+ * exports each function twice, once for the lazy and once for the eager
+ * wrappers. Its functions use the calling convention of Android code.
+ */
+
+#include <hybris/common/floating_point_abi.h>
+
+static int FP_ATTRIB add(int a, int b)
+{
+	return a + b;
+}
+
+static float last;
+
+static void FP_ATTRIB color(float r, float g, float b, float a)
+{
+	last = r + g + b + a;
+}
+
+static float FP_ATTRIB get_color(void)
+{
+	return last;
+}
+
+int FP_ATTRIB binding_lazy_add(int a, int b) __attribute__((alias("add")));
+void FP_ATTRIB binding_lazy_color(float r, float g, float b, float a) __attribute__((alias("color")));
+float FP_ATTRIB binding_lazy_get_color(void) __attribute__((alias("get_color")));
+
+int FP_ATTRIB binding_eager_add(int a, int b) __attribute__((alias("add")));
+void FP_ATTRIB binding_eager_color(float r, float g, float b, float a) __attribute__((alias("color")));
+float FP_ATTRIB binding_eager_get_color(void) __attribute__((alias("get_color")));
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Stand-in for a vendor library with thousands of PLT entries, loaded by
+ * test_lazy_binding through the hybris linker. lazy_call(n) calls the n-th
+ * of its 4096 functions, lazy_<n in octal>(), which returns n: they are
+ * exported, so the calls go through the PLT. lazy_args() passes its
+ * arguments on to lazy_store(), through the PLT too, which stores them in
+ * lazy_ints[] and lazy_doubles[]: all the argument registers are in use
+ * when it is bound. lazy_getenv() calls getenv(), which only the hooks
+ * provide. It is built without libc, so that it has nothing to pull in.
+ */
+
+#define INDEX(a, b, c, d) ((((a) * 8 + (b)) * 8 + (c)) * 8 + (d))
+
+#define EACH_D(m, a, b, c) \
+	m(a, b, c, 0) m(a, b, c, 1) m(a, b, c, 2) m(a, b, c, 3) \
+	m(a, b, c, 4) m(a, b, c, 5) m(a, b, c, 6) m(a, b, c, 7)
+#define EACH_C(m, a, b) \
+	EACH_D(m, a, b, 0) EACH_D(m, a, b, 1) EACH_D(m, a, b, 2) EACH_D(m, a, b, 3) \
+	EACH_D(m, a, b, 4) EACH_D(m, a, b, 5) EACH_D(m, a, b, 6) EACH_D(m, a, b, 7)
+#define EACH_B(m, a) \
+	EACH_C(m, a, 0) EACH_C(m, a, 1) EACH_C(m, a, 2) EACH_C(m, a, 3) \
+	EACH_C(m, a, 4) EACH_C(m, a, 5) EACH_C(m, a, 6) EACH_C(m, a, 7)
+#define EACH(m) \
+	EACH_B(m, 0) EACH_B(m, 1) EACH_B(m, 2) EACH_B(m, 3) \
+	EACH_B(m, 4) EACH_B(m, 5) EACH_B(m, 6) EACH_B(m, 7)
+
+#define DEFINE(a, b, c, d) \
+	int lazy_##a##b##c##d(void) { return INDEX(a, b, c, d); }
+#define CALL(a, b, c, d) \
+	case INDEX(a, b, c, d): return lazy_##a##b##c##d();
+
+EACH(DEFINE)
+
+int lazy_call(int n)
+{
+	switch (n) {
+	EACH(CALL)
+	}
+
+	return -1;
+}
+
+const int lazy_count = INDEX(7, 7, 7, 7) + 1;
+
+int lazy_ints[8];
+double lazy_doubles[8];
+
+void lazy_store(int i0, int i1, int i2, int i3, int i4, int i5, int i6, int i7,
+		double d0, double d1, double d2, double d3,
+		double d4, double d5, double d6, double d7)
+{
+	lazy_ints[0] = i0; lazy_ints[1] = i1; lazy_ints[2] = i2; lazy_ints[3] = i3;
+	lazy_ints[4] = i4; lazy_ints[5] = i5; lazy_ints[6] = i6; lazy_ints[7] = i7;
+	lazy_doubles[0] = d0; lazy_doubles[1] = d1; lazy_doubles[2] = d2; lazy_doubles[3] = d3;
+	lazy_doubles[4] = d4; lazy_doubles[5] = d5; lazy_doubles[6] = d6; lazy_doubles[7] = d7;
+}
+
+void lazy_args(int i0, int i1, int i2, int i3, int i4, int i5, int i6, int i7,
+		double d0, double d1, double d2, double d3,
+		double d4, double d5, double d6, double d7)
+{
+	lazy_store(i0, i1, i2, i3, i4, i5, i6, i7, d0, d1, d2, d3, d4, d5, d6, d7);
+}
+
+char *getenv(const char *name);
+
+char *lazy_getenv(const char *name)
+{
+	return getenv(name);
+}
+
+// vim:ts=4:sw=4:noexpandtab
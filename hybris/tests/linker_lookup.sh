@@ -0,0 +1,85 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 agent <agent@local>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Builds the libraries test_linker_lookup resolves symbols against, twice:
+# with GNU hash tables in <directory>/gnu and with SysV ones only, like old
+# vendor libraries, in <directory>/sysv. Each liblookup_<n>.so defines
+# <symbols> functions, and liblookup.so needs all of them and refers to
+# <lookups> symbols picked at random: half of them are theirs, half are
+# weak ones no library defines. They are built without libc, so that the
+# hybris linker has nothing else to load, and find each other through
+# DT_RUNPATH.
+#
+# Usage: linker_lookup.sh <compiler> <directory> <libraries> <symbols> <lookups>
+
+set -e
+
+CC="$1"
+DIR="$2"
+LIBRARIES="$3"
+SYMBOLS="$4"
+LOOKUPS="$5"
+
+mkdir -p "$DIR"
+
+n=0
+while [ $n -lt $LIBRARIES ]; do
+	awk -v n=$n -v symbols=$SYMBOLS 'BEGIN {
+		for (i = 0; i < symbols; i++)
+			printf "int lookup_%d_%d(void) { return %d; }\n", n, i, i
+	}' > "$DIR/lookup_$n.c"
+	n=$((n + 1))
+done
+
+# The same symbols every time
+awk -v libraries=$LIBRARIES -v symbols=$SYMBOLS -v lookups=$LOOKUPS 'BEGIN {
+	srand(1)
+	for (i = 0; i < lookups; i++) {
+		if (i % 2 == 0) {
+			name[i] = sprintf("lookup_%d_%d", int(rand() * libraries), int(rand() * symbols))
+			weak[i] = ""
+		} else {
+			name[i] = sprintf("missing_%d", i)
+			weak[i] = " __attribute__((weak))"
+		}
+		if (!(name[i] in declared)) {
+			printf "extern int %s(void)%s;\n", name[i], weak[i]
+			declared[name[i]] = 1
+		}
+	}
+	printf "int (*const lookup_table[])(void) = {\n"
+	for (i = 0; i < lookups; i++)
+		printf "\t%s,\n", name[i]
+	printf "};\n"
+	printf "const unsigned long lookup_count = %d;\n", lookups
+}' > "$DIR/lookup.c"
+
+for style in gnu sysv; do
+	FLAGS="-shared -fPIC -nostdlib -Wl,--hash-style=$style -Wl,--enable-new-dtags,-rpath,\$ORIGIN"
+	libs=""
+	mkdir -p "$DIR/$style"
+
+	n=0
+	while [ $n -lt $LIBRARIES ]; do
+		$CC $FLAGS -Wl,-soname,liblookup_$n.so -o "$DIR/$style/liblookup_$n.so" "$DIR/lookup_$n.c"
+		libs="$libs -llookup_$n"
+		n=$((n + 1))
+	done
+
+	$CC $FLAGS -L"$DIR/$style" -Wl,-soname,liblookup.so -o "$DIR/$style/liblookup.so" "$DIR/lookup.c" $libs
+done
+
+rm -f "$DIR"/*.c
@@ -0,0 +1,92 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 agent <agent@local>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Builds the dependency tree of libraries test_linker_load loads:
+# libtree_<n>.so needs libtree_<2n+1>.so and libtree_<2n+2>.so, up to
+# libtree_<count-1>.so, and all of them need libtree_common.so. They are
+# built without libc, so that the hybris linker has nothing else to load,
+# and find each other through DT_RUNPATH. Each library also defines a few
+# functions, and has a table of those of its children, so that the linker
+# has symbols to look up.
+#
+# Usage: linker_tree.sh <compiler> <directory> <count>
+
+set -e
+
+CC="$1"
+DIR="$2"
+COUNT="$3"
+
+FLAGS="-shared -fPIC -nostdlib -Wl,--enable-new-dtags,-rpath,\$ORIGIN -L$DIR"
+
+mkdir -p "$DIR"
+
+echo "int tree_common = 1;" > "$DIR/tree_common.c"
+$CC $FLAGS -Wl,-soname,libtree_common.so -o "$DIR/libtree_common.so" "$DIR/tree_common.c"
+
+# Functions each library defines, and refers to in its children
+FUNCTIONS=64
+
+# Leaves first, so that every library is linked against its children
+i=$((COUNT - 1))
+while [ $i -ge 0 ]; do
+	left=$((2 * i + 1))
+	right=$((2 * i + 2))
+	src="$DIR/tree_$i.c"
+	libs="-ltree_common"
+
+	{
+		echo "extern int tree_common;"
+		# Some read-only data, so that there is something to read
+		echo "const char tree_data_$i[65536] = { $i };"
+		f=0
+		while [ $f -lt $FUNCTIONS ]; do
+			echo "int tree_${i}_$f(void) { return $f; }"
+			for child in $left $right; do
+				[ $child -lt $COUNT ] && echo "int tree_${child}_$f(void);"
+			done
+			f=$((f + 1))
+		done
+		if [ $left -lt $COUNT ]; then
+			echo "int (*const tree_table_$i[])(void) = {"
+			f=0
+			while [ $f -lt $FUNCTIONS ]; do
+				for child in $left $right; do
+					[ $child -lt $COUNT ] && echo "	tree_${child}_$f,"
+				done
+				f=$((f + 1))
+			done
+			echo "};"
+		fi
+		[ $left -lt $COUNT ] && echo "int tree_$left(void);"
+		[ $right -lt $COUNT ] && echo "int tree_$right(void);"
+		echo "int tree_$i(void)"
+		echo "{"
+		echo "	int value = tree_common + $i;"
+		[ $left -lt $COUNT ] && echo "	value += tree_$left();"
+		[ $right -lt $COUNT ] && echo "	value += tree_$right();"
+		echo "	return value;"
+		echo "}"
+	} > "$src"
+
+	[ $left -lt $COUNT ] && libs="$libs -ltree_$left"
+	[ $right -lt $COUNT ] && libs="$libs -ltree_$right"
+
+	$CC $FLAGS -Wl,-soname,libtree_$i.so -o "$DIR/libtree_$i.so" "$src" $libs
+	i=$((i - 1))
+done
+
+rm -f "$DIR"/*.c
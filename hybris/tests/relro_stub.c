@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Stand-in for a large Android library, like a GL driver, loaded by
+ * test_relro through the hybris linker. Its table of pointers to its own
+ * functions is relocated at load time, so it fills a few MB of RELRO. It is
+ * built without libc so that it has nothing to pull in.
+ */
+
+#define TABLE_SIZE (512 * 1024)
+
+static int first(void)
+{
+	return 1;
+}
+
+static int second(void)
+{
+	return 2;
+}
+
+int (*const relro_table[TABLE_SIZE])(void) = {
+	[0 ... TABLE_SIZE / 2 - 1] = first,
+	[TABLE_SIZE / 2 ... TABLE_SIZE - 1] = second,
+};
+
+const unsigned long relro_table_size = TABLE_SIZE;
+
+// vim:ts=4:sw=4:noexpandtab
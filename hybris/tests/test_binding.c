@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Measures what a call through the HYBRIS_IMPLEMENT_FUNCTIONn wrappers costs
+ * on top of calling the Android function directly, with the wrappers that
+ * resolve their symbol on first call and with the ones bound when the
+ * library is loaded (HYBRIS_BINDING_EAGER). The functions called are in a
+ * stub library (binding_stub.c) and do next to nothing.
+ *
+ * Usage: test_binding [calls]
+ */
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <hybris/common/dlfcn.h>
+#include <hybris/common/floating_point_abi.h>
+
+/* From test_binding_lazy.c */
+int binding_lazy_add(int a, int b);
+void binding_lazy_color(float r, float g, float b, float a);
+float binding_lazy_get_color(void);
+
+/* From test_binding_eager.c */
+int binding_eager_add(int a, int b);
+void binding_eager_color(float r, float g, float b, float a);
+float binding_eager_get_color(void);
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *what, int calls, double add, double color, double direct_add, double direct_color)
+{
+	printf("%-8s %8.2f %8.2f %8.2f %8.2f\n", what,
+		add / calls * 1e9, color / calls * 1e9,
+		(add - direct_add) / calls * 1e9, (color - direct_color) / calls * 1e9);
+}
+
+int main(int argc, char **argv)
+{
+	int (*add)(int, int) FP_ATTRIB;
+	void (*color)(float, float, float, float) FP_ATTRIB;
+	double start, direct_add, direct_color, add_time, color_time;
+	float got;
+	int i, calls, sum;
+
+	calls = argc > 1 ? atoi(argv[1]) : 50000000;
+
+	void *handle = hybris_dlopen(BINDING_STUB_PATH, RTLD_NOW);
+	assert(handle != NULL);
+	add = hybris_dlsym(handle, "binding_lazy_add");
+	assert(add != NULL);
+	color = hybris_dlsym(handle, "binding_lazy_color");
+	assert(color != NULL);
+
+	/* Both flavours reach the stub */
+	sum = binding_lazy_add(1, 2);
+	assert(sum == 3);
+	sum = binding_eager_add(3, 4);
+	assert(sum == 7);
+	binding_lazy_color(1.0, 2.0, 3.0, 4.0);
+	got = binding_eager_get_color();
+	assert(got == 10.0);
+	binding_eager_color(1.0, 1.0, 1.0, 1.0);
+	got = binding_lazy_get_color();
+	assert(got == 4.0);
+
+	printf("%d calls, times in ns per call\n", calls);
+	printf("%-8s %8s %8s %8s %8s\n", "", "int", "float", "+int", "+float");
+
+	for (start = now(), sum = 0, i = 0; i < calls; i++)
+		sum = add(sum, 1);
+	direct_add = now() - start;
+	assert(sum == calls);
+	for (start = now(), i = 0; i < calls; i++)
+		color(1.0, 0.0, 0.0, 1.0);
+	direct_color = now() - start;
+	report("direct", calls, direct_add, direct_color, direct_add, direct_color);
+
+	for (start = now(), sum = 0, i = 0; i < calls; i++)
+		sum = binding_lazy_add(sum, 1);
+	add_time = now() - start;
+	assert(sum == calls);
+	for (start = now(), i = 0; i < calls; i++)
+		binding_lazy_color(1.0, 0.0, 0.0, 1.0);
+	color_time = now() - start;
+	report("lazy", calls, add_time, color_time, direct_add, direct_color);
+
+	for (start = now(), sum = 0, i = 0; i < calls; i++)
+		sum = binding_eager_add(sum, 1);
+	add_time = now() - start;
+	assert(sum == calls);
+	for (start = now(), i = 0; i < calls; i++)
+		binding_eager_color(1.0, 0.0, 0.0, 1.0);
+	color_time = now() - start;
+	report("eager", calls, add_time, color_time, direct_add, direct_color);
+
+	hybris_dlclose(handle);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
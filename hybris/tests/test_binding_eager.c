@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Wrappers bound to the stub library when loaded, for test_binding */
+
+#include <dlfcn.h>
+#include <stddef.h>
+
+#define HYBRIS_BINDING_EAGER
+#include <hybris/common/binding.h>
+
+HYBRIS_LIBRARY_INITIALIZE(eager_stub, BINDING_STUB_PATH);
+
+HYBRIS_IMPLEMENT_FUNCTION2(eager_stub, int, binding_eager_add, int, int);
+HYBRIS_IMPLEMENT_VOID_FUNCTION4(eager_stub, binding_eager_color, float, float, float, float);
+HYBRIS_IMPLEMENT_FUNCTION0(eager_stub, float, binding_eager_get_color);
+
+// vim:ts=4:sw=4:noexpandtab
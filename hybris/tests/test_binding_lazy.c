@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/* Wrappers resolving the stub library on first call, for test_binding */
+
+#include <dlfcn.h>
+#include <stddef.h>
+
+#include <hybris/common/binding.h>
+
+HYBRIS_LIBRARY_INITIALIZE(lazy_stub, BINDING_STUB_PATH);
+
+HYBRIS_IMPLEMENT_FUNCTION2(lazy_stub, int, binding_lazy_add, int, int);
+HYBRIS_IMPLEMENT_VOID_FUNCTION4(lazy_stub, binding_lazy_color, float, float, float, float);
+HYBRIS_IMPLEMENT_FUNCTION0(lazy_stub, float, binding_lazy_get_color);
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Cycles displays through eglGetDisplay and eglTerminate on the null
+ * platform, the way headless test harnesses do, first from one thread then
+ * from several. Checks that every display is unmapped when terminated and
+ * that the cost of a cycle doesn't grow with the number of displays seen,
+ * then that a terminated display can be initialized again and given a
+ * window surface.
+ *
+ * The null platform always returns the same display, so the map of displays
+ * is also filled with as many distinct ones, fake displays mapped and
+ * unmapped the way eglGetDisplay and eglTerminate do. Checks that they all
+ * stay mapped at once and that mapping one doesn't cost more as the map
+ * grows.
+ *
+ * Usage: test_egl_displays [cycles] [threads]
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <EGL/egl.h>
+
+#include "../egl/helper.h"
+#include "../egl/ws.h"
+
+#define BATCHES 10
+
+/* From libEGL */
+struct _EGLDisplay *hybris_egl_display_get_mapping(EGLDisplay dpy);
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *cycle_thread(void *data)
+{
+	int i, n = *(int *) data;
+
+	for (i = 0; i < n; i++) {
+		EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		assert(dpy != EGL_NO_DISPLAY);
+		eglTerminate(dpy);
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	double batch[BATCHES];
+	struct _EGLDisplay *mapping;
+	EGLDisplay again;
+	EGLBoolean ok;
+	int i, j, cycles, nthreads;
+
+	cycles = argc > 1 ? atoi(argv[1]) : 10000;
+	nthreads = argc > 2 ? atoi(argv[2]) : 4;
+
+	/* Read when the first display is created */
+	setenv("EGL_PLATFORM", "null", 1);
+
+	for (i = 0; i < BATCHES; i++) {
+		double start = now();
+
+		for (j = 0; j < cycles / BATCHES; j++) {
+			EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			assert(dpy != EGL_NO_DISPLAY);
+			mapping = hybris_egl_display_get_mapping(dpy);
+			assert(mapping != NULL);
+			again = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			assert(again == dpy);
+
+			ok = eglTerminate(dpy);
+			assert(ok == EGL_TRUE);
+			mapping = hybris_egl_display_get_mapping(dpy);
+			assert(mapping == NULL);
+		}
+
+		batch[i] = (now() - start) / (cycles / BATCHES) * 1e6;
+		printf("cycles %6d-%6d: %8.2f us/cycle\n", i * (cycles / BATCHES),
+			(i + 1) * (cycles / BATCHES) - 1, batch[i]);
+	}
+
+	/* The last displays cost no more than the first ones, give or take noise */
+	assert(batch[BATCHES - 1] < batch[0] * 3 + 10);
+
+	/* Distinct displays, all mapped at once. Their handles are their own
+	 * addresses, which the driver can't return. */
+	struct _EGLDisplay *fakes = calloc(cycles, sizeof(*fakes));
+	EGLNativeDisplayType native;
+	int found;
+	assert(fakes != NULL);
+
+	for (i = 0; i < BATCHES; i++) {
+		double start = now();
+
+		for (j = i * (cycles / BATCHES); j < (i + 1) * (cycles / BATCHES); j++) {
+			fakes[j].dpy = (EGLDisplay) &fakes[j];
+			mapping = egl_helper_push_display(&fakes[j], (EGLNativeDisplayType) (fakes + j));
+			assert(mapping == &fakes[j]);
+			mapping = hybris_egl_display_get_mapping(fakes[j].dpy);
+			assert(mapping == &fakes[j]);
+		}
+
+		batch[i] = (now() - start) / (cycles / BATCHES) * 1e6;
+		printf("displays %6d-%6d: %8.2f us/display\n", i * (cycles / BATCHES),
+			(i + 1) * (cycles / BATCHES) - 1, batch[i]);
+	}
+
+	assert(batch[BATCHES - 1] < batch[0] * 3 + 10);
+
+	for (j = 0; j < cycles / BATCHES * BATCHES; j++) {
+		mapping = hybris_egl_display_get_mapping(fakes[j].dpy);
+		assert(mapping == &fakes[j]);
+		mapping = egl_helper_pop_display(fakes[j].dpy);
+		assert(mapping == &fakes[j]);
+		mapping = hybris_egl_display_get_mapping(fakes[j].dpy);
+		assert(mapping == NULL);
+
+		/* For eglInitialize to map it again */
+		found = egl_helper_get_native_display(fakes[j].dpy, &native);
+		assert(found && native == (EGLNativeDisplayType) (fakes + j));
+	}
+	free(fakes);
+
+	/* Concurrent cycles, each thread maps and unmaps the same display */
+	pthread_t threads[nthreads];
+	int per_thread = cycles / nthreads;
+	double start = now();
+
+	for (i = 0; i < nthreads; i++) {
+		int err = pthread_create(&threads[i], NULL, cycle_thread, &per_thread);
+		assert(err == 0);
+	}
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+
+	printf("%d threads: %8.2f us/cycle\n", nthreads,
+		(now() - start) / (per_thread * nthreads) * 1e6);
+
+	/* Whichever thread terminated last, a display is mapped on demand */
+	EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	mapping = hybris_egl_display_get_mapping(dpy);
+	assert(mapping != NULL);
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+	ok = eglTerminate(dpy);
+	assert(ok == EGL_TRUE);
+	mapping = hybris_egl_display_get_mapping(dpy);
+	assert(mapping == NULL);
+
+	/* EGL allows initializing a terminated display again */
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+	mapping = hybris_egl_display_get_mapping(dpy);
+	assert(mapping != NULL);
+
+	const EGLint attribs[] = {
+		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint nconfigs;
+	ok = eglChooseConfig(dpy, attribs, &config, 1, &nconfigs);
+	assert(ok == EGL_TRUE && nconfigs == 1);
+
+	EGLSurface surface = eglCreateWindowSurface(dpy, config, (EGLNativeWindowType) NULL, NULL);
+	assert(surface != EGL_NO_SURFACE);
+	ok = eglDestroySurface(dpy, surface);
+	assert(ok == EGL_TRUE);
+
+	ok = eglTerminate(dpy);
+	assert(ok == EGL_TRUE);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
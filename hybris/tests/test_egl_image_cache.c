@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Imports a few native buffers as EGLImages over and over, like a video
+ * player does with its decoder's output buffers, with the image cache
+ * (HYBRIS_EGL_IMAGE_CACHE) on. Checks that the same image comes back while
+ * the buffer lives, and that releasing the buffer drops it, even while the
+ * image is referenced more than once, then compares the time an import takes
+ * with the time the first one took. Runs on the null platform.
+ *
+ * Usage: test_egl_image_cache [frames] [buffers]
+ */
+
+#include <android-config.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "hybris_nativebufferext.h"
+
+#define MAX_BUFFERS 16
+
+static PFNEGLHYBRISCREATENATIVEBUFFERPROC eglHybrisCreateNativeBuffer;
+static PFNEGLHYBRISRELEASENATIVEBUFFERPROC eglHybrisReleaseNativeBuffer;
+static PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR;
+static PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static EGLClientBuffer create_buffer(void)
+{
+	EGLClientBuffer buffer;
+	EGLint stride;
+
+	EGLBoolean ok = eglHybrisCreateNativeBuffer(320, 240,
+			HYBRIS_USAGE_SW_WRITE_RARELY | HYBRIS_USAGE_HW_TEXTURE,
+			HYBRIS_PIXEL_FORMAT_RGBA_8888, &stride, &buffer);
+	assert(ok == EGL_TRUE);
+	return buffer;
+}
+
+int main(int argc, char **argv)
+{
+	EGLClientBuffer buffers[MAX_BUFFERS];
+	EGLImageKHR first[MAX_BUFFERS];
+	const EGLint attribs[] = {
+		EGL_IMAGE_PRESERVED_KHR, EGL_TRUE,
+		EGL_NONE
+	};
+	EGLBoolean ok;
+	int i, frames, nbuffers;
+
+	frames = argc > 1 ? atoi(argv[1]) : 1000;
+	nbuffers = argc > 2 ? atoi(argv[2]) : 4;
+	if (nbuffers > MAX_BUFFERS)
+		nbuffers = MAX_BUFFERS;
+
+	/* Read when the first image is created */
+	setenv("HYBRIS_EGL_IMAGE_CACHE", "1", 1);
+	setenv("EGL_PLATFORM", "null", 1);
+
+	EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+
+	eglHybrisCreateNativeBuffer = (PFNEGLHYBRISCREATENATIVEBUFFERPROC) eglGetProcAddress("eglHybrisCreateNativeBuffer");
+	eglHybrisReleaseNativeBuffer = (PFNEGLHYBRISRELEASENATIVEBUFFERPROC) eglGetProcAddress("eglHybrisReleaseNativeBuffer");
+	eglCreateImageKHR = (PFNEGLCREATEIMAGEKHRPROC) eglGetProcAddress("eglCreateImageKHR");
+	eglDestroyImageKHR = (PFNEGLDESTROYIMAGEKHRPROC) eglGetProcAddress("eglDestroyImageKHR");
+	assert(eglHybrisCreateNativeBuffer != NULL && eglHybrisReleaseNativeBuffer != NULL);
+	assert(eglCreateImageKHR != NULL && eglDestroyImageKHR != NULL);
+
+	for (i = 0; i < nbuffers; i++)
+		buffers[i] = create_buffer();
+
+	/* First imports, which create the images */
+	double start = now();
+	for (i = 0; i < nbuffers; i++) {
+		first[i] = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[i], attribs);
+		assert(first[i] != EGL_NO_IMAGE_KHR);
+		ok = eglDestroyImageKHR(dpy, first[i]);
+		assert(ok == EGL_TRUE);
+	}
+	double cold = (now() - start) / nbuffers;
+
+	/* Steady state: one import per frame, the image is dropped once drawn */
+	start = now();
+	for (i = 0; i < frames; i++) {
+		int b = i % nbuffers;
+		EGLImageKHR image = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[b], attribs);
+		assert(image == first[b]);
+		ok = eglDestroyImageKHR(dpy, image);
+		assert(ok == EGL_TRUE);
+	}
+	double warm = (now() - start) / frames;
+
+	printf("%d buffers: %8.2f us for the first import, %8.2f us afterwards\n",
+		nbuffers, cold * 1e6, warm * 1e6);
+
+	/* Images that are still referenced survive their buffer, uncached */
+	EGLImageKHR held = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[0], NULL);
+	assert(held == first[0]);
+	eglHybrisReleaseNativeBuffer(buffers[0]);
+	ok = eglDestroyImageKHR(dpy, held);
+	assert(ok == EGL_TRUE);
+
+	/* Even with several references when the buffer goes */
+	buffers[0] = create_buffer();
+	EGLImageKHR image = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[0], NULL);
+	assert(image != EGL_NO_IMAGE_KHR);
+	EGLImageKHR again = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[0], NULL);
+	assert(again == image);
+	eglHybrisReleaseNativeBuffer(buffers[0]);
+	ok = eglDestroyImageKHR(dpy, image);
+	assert(ok == EGL_TRUE);
+	ok = eglDestroyImageKHR(dpy, again);
+	assert(ok == EGL_TRUE);
+
+	/* The image went back to the pool once: new images each get a wrapper
+	 * of their own */
+	EGLClientBuffer spare = create_buffer();
+	buffers[0] = create_buffer();
+	image = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[0], NULL);
+	again = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, spare, NULL);
+	assert(image != EGL_NO_IMAGE_KHR && again != EGL_NO_IMAGE_KHR);
+	assert(image != again);
+	ok = eglDestroyImageKHR(dpy, again);
+	assert(ok == EGL_TRUE);
+	eglHybrisReleaseNativeBuffer(spare);
+
+	/* A new buffer gets an image of its own, referenced twice */
+	again = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_HYBRIS, buffers[0], NULL);
+	assert(again == image);
+	ok = eglDestroyImageKHR(dpy, image);
+	assert(ok == EGL_TRUE);
+	ok = eglDestroyImageKHR(dpy, image);
+	assert(ok == EGL_TRUE);
+
+	for (i = 0; i < nbuffers; i++)
+		eglHybrisReleaseNativeBuffer(buffers[i]);
+
+	eglTerminate(dpy);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
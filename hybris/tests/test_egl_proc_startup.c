@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Startup benchmark for eglGetProcAddress: resolves every OpenGL ES 2.0
+ * entry point the way toolkits do when a context is created, then again
+ * for a second context. Also checks that functions are resolved for the
+ * API of the current context, not of the last one created. Runs on the
+ * null platform, with pbuffers.
+ *
+ * Usage: test_egl_proc_startup [rounds]
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <EGL/egl.h>
+
+static const char *names[] = {
+	"glActiveTexture", "glAttachShader", "glBindAttribLocation",
+	"glBindBuffer", "glBindFramebuffer", "glBindRenderbuffer", "glBindTexture",
+	"glBlendColor", "glBlendEquation", "glBlendEquationSeparate",
+	"glBlendFunc", "glBlendFuncSeparate", "glBufferData", "glBufferSubData",
+	"glCheckFramebufferStatus", "glClear", "glClearColor", "glClearDepthf",
+	"glClearStencil", "glColorMask", "glCompileShader",
+	"glCompressedTexImage2D", "glCompressedTexSubImage2D", "glCopyTexImage2D",
+	"glCopyTexSubImage2D", "glCreateProgram", "glCreateShader", "glCullFace",
+	"glDeleteBuffers", "glDeleteFramebuffers", "glDeleteProgram",
+	"glDeleteRenderbuffers", "glDeleteShader", "glDeleteTextures",
+	"glDepthFunc", "glDepthMask", "glDepthRangef", "glDetachShader",
+	"glDisable", "glDisableVertexAttribArray", "glDrawArrays",
+	"glDrawElements", "glEnable", "glEnableVertexAttribArray", "glFinish",
+	"glFlush", "glFramebufferRenderbuffer", "glFramebufferTexture2D",
+	"glFrontFace", "glGenBuffers", "glGenerateMipmap", "glGenFramebuffers",
+	"glGenRenderbuffers", "glGenTextures", "glGetActiveAttrib",
+	"glGetActiveUniform", "glGetAttachedShaders", "glGetAttribLocation",
+	"glGetBooleanv", "glGetBufferParameteriv", "glGetError", "glGetFloatv",
+	"glGetFramebufferAttachmentParameteriv", "glGetIntegerv", "glGetProgramiv",
+	"glGetProgramInfoLog", "glGetRenderbufferParameteriv", "glGetShaderiv",
+	"glGetShaderInfoLog", "glGetShaderPrecisionFormat", "glGetShaderSource",
+	"glGetString", "glGetTexParameterfv", "glGetTexParameteriv",
+	"glGetUniformfv", "glGetUniformiv", "glGetUniformLocation",
+	"glGetVertexAttribfv", "glGetVertexAttribiv", "glGetVertexAttribPointerv",
+	"glHint", "glIsBuffer", "glIsEnabled", "glIsFramebuffer", "glIsProgram",
+	"glIsRenderbuffer", "glIsShader", "glIsTexture", "glLineWidth",
+	"glLinkProgram", "glPixelStorei", "glPolygonOffset", "glReadPixels",
+	"glReleaseShaderCompiler", "glRenderbufferStorage", "glSampleCoverage",
+	"glScissor", "glShaderBinary", "glShaderSource", "glStencilFunc",
+	"glStencilFuncSeparate", "glStencilMask", "glStencilMaskSeparate",
+	"glStencilOp", "glStencilOpSeparate", "glTexImage2D", "glTexParameterf",
+	"glTexParameterfv", "glTexParameteri", "glTexParameteriv",
+	"glTexSubImage2D", "glUniform1f", "glUniform1fv", "glUniform1i",
+	"glUniform1iv", "glUniform2f", "glUniform2fv", "glUniform2i",
+	"glUniform2iv", "glUniform3f", "glUniform3fv", "glUniform3i",
+	"glUniform3iv", "glUniform4f", "glUniform4fv", "glUniform4i",
+	"glUniform4iv", "glUniformMatrix2fv", "glUniformMatrix3fv",
+	"glUniformMatrix4fv", "glUseProgram", "glValidateProgram",
+	"glVertexAttrib1f", "glVertexAttrib1fv", "glVertexAttrib2f",
+	"glVertexAttrib2fv", "glVertexAttrib3f", "glVertexAttrib3fv",
+	"glVertexAttrib4f", "glVertexAttrib4fv", "glVertexAttribPointer",
+	"glViewport"
+};
+
+#define NAMES (sizeof(names) / sizeof(names[0]))
+
+static EGLDisplay dpy;
+static EGLConfig config;
+static EGLSurface surface;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static EGLContext create_context(int client_version)
+{
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, client_version,
+		EGL_NONE
+	};
+
+	EGLContext context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+	assert(context != EGL_NO_CONTEXT);
+	return context;
+}
+
+/* Resolves all the names, returns the time it took in us */
+static double resolve_all(__eglMustCastToProperFunctionPointerType *procs)
+{
+	unsigned int i;
+
+	double start = now();
+	for (i = 0; i < NAMES; i++)
+		procs[i] = eglGetProcAddress(names[i]);
+	return (now() - start) * 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	__eglMustCastToProperFunctionPointerType first[NAMES], procs[NAMES];
+	EGLint num_config;
+	EGLBoolean ok;
+	unsigned int i;
+	int round, rounds;
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT | EGL_OPENGL_ES2_BIT,
+		EGL_NONE
+	};
+	const EGLint pbuffer_attribs[] = {
+		EGL_WIDTH, 64,
+		EGL_HEIGHT, 64,
+		EGL_NONE
+	};
+
+	rounds = argc > 1 ? atoi(argv[1]) : 100;
+
+	/* Read when the display is created */
+	setenv("EGL_PLATFORM", "null", 1);
+
+	dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+	ok = eglChooseConfig(dpy, config_attribs, &config, 1, &num_config);
+	assert(ok == EGL_TRUE && num_config == 1);
+	surface = eglCreatePbufferSurface(dpy, config, pbuffer_attribs);
+	assert(surface != EGL_NO_SURFACE);
+
+	EGLContext gles2 = create_context(2);
+	ok = eglMakeCurrent(dpy, surface, surface, gles2);
+	assert(ok == EGL_TRUE);
+
+	/* What a toolkit does once it made its first context current */
+	double cold = resolve_all(first);
+	for (i = 0; i < NAMES; i++)
+		assert(first[i] != NULL);
+
+	/* ... and for every other context */
+	double warm = 0;
+	for (round = 0; round < rounds; round++) {
+		warm += resolve_all(procs);
+		for (i = 0; i < NAMES; i++)
+			assert(procs[i] == first[i]);
+	}
+	warm /= rounds;
+
+	printf("%u functions: %10.1f us the first time, %10.1f us afterwards\n",
+		(unsigned int) NAMES, cold, warm);
+
+	/* A GLES 1 context created later doesn't change what the current one gets */
+	EGLContext gles1 = create_context(1);
+	resolve_all(procs);
+	for (i = 0; i < NAMES; i++)
+		assert(procs[i] == first[i]);
+
+	/* Once current, it gets functions from libGLESv1_CM, if there is one */
+	void *clear2 = (void *) eglGetProcAddress("glClear");
+	ok = eglMakeCurrent(dpy, surface, surface, gles1);
+	assert(ok == EGL_TRUE);
+	void *clear1 = (void *) eglGetProcAddress("glClear");
+	printf("glClear: %p for GLES 2, %p for GLES 1\n", clear2, clear1);
+
+	/* Back to the GLES 2 context */
+	ok = eglMakeCurrent(dpy, surface, surface, gles2);
+	assert(ok == EGL_TRUE);
+	resolve_all(procs);
+	for (i = 0; i < NAMES; i++)
+		assert(procs[i] == first[i]);
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(dpy, gles1);
+	eglDestroyContext(dpy, gles2);
+	eglDestroySurface(dpy, surface);
+	eglTerminate(dpy);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Swaps from several rendering threads at once on the null platform, each
+ * with a surface and a context of its own: the first thread renders to the
+ * display surface, the others to pbuffers. Every swap looks its surface up
+ * in the surface to window map the threads share: the display surface is
+ * found there, the pbuffers are not.
+ *
+ * Meanwhile, other threads keep adding surfaces to the map and removing
+ * them, like eglCreateWindowSurface() and eglDestroySurface() do (the null
+ * platform only has one window), and another one checks that lookups never
+ * miss the display surface nor find a surface with the wrong window.
+ *
+ * Usage: test_egl_swap_threads [swaps per thread] [max threads]
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "../egl/helper.h"
+
+#define MAX_THREADS 16
+#define CHURN_THREADS 2
+/* Enough for the map to grow while they are all in */
+#define CHURN_SURFACES 64
+
+static EGLDisplay dpy;
+static EGLConfig config;
+static EGLSurface window_surface;
+static EGLNativeWindowType window;
+static int swaps;
+static int stop;
+
+/* Stand-ins for the surfaces of the churn threads, mapped to windows of
+ * their own */
+static char churn_surfaces[CHURN_THREADS][CHURN_SURFACES];
+
+static EGLNativeWindowType churn_window(EGLSurface surface)
+{
+	return (EGLNativeWindowType) ~(uintptr_t) surface;
+}
+
+struct renderer {
+	pthread_t thread;
+	int index;
+	double elapsed;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *render_thread(void *data)
+{
+	struct renderer *r = data;
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+	const EGLint pbuffer_attribs[] = {
+		EGL_WIDTH, 64,
+		EGL_HEIGHT, 64,
+		EGL_NONE
+	};
+	EGLSurface surface;
+	EGLBoolean ok;
+	int i;
+
+	if (r->index == 0)
+		surface = window_surface;
+	else
+		surface = eglCreatePbufferSurface(dpy, config, pbuffer_attribs);
+	assert(surface != EGL_NO_SURFACE);
+
+	EGLContext context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+	assert(context != EGL_NO_CONTEXT);
+	ok = eglMakeCurrent(dpy, surface, surface, context);
+	assert(ok == EGL_TRUE);
+	eglSwapInterval(dpy, 0);
+
+	double start = now();
+	for (i = 0; i < swaps; i++) {
+		glClearColor((i & 1) ? 1.0 : 0.0, 0.0, 0.0, 1.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		ok = eglSwapBuffers(dpy, surface);
+		assert(ok == EGL_TRUE);
+	}
+	r->elapsed = now() - start;
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(dpy, context);
+	if (surface != window_surface)
+		eglDestroySurface(dpy, surface);
+	eglReleaseThread();
+
+	return NULL;
+}
+
+/* Adds all its surfaces to the map, then removes them in another order,
+ * until the renderers are done */
+static void *churn_thread(void *data)
+{
+	char *surfaces = data;
+	long rounds = 0;
+	int i;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		for (i = 0; i < CHURN_SURFACES; i++)
+			egl_helper_push_mapping(&surfaces[i], churn_window(&surfaces[i]));
+		for (i = 0; i < CHURN_SURFACES; i++) {
+			EGLSurface surface = &surfaces[(i * 7) % CHURN_SURFACES];
+			EGLNativeWindowType popped = egl_helper_pop_mapping(surface);
+			assert(popped == churn_window(surface));
+		}
+		rounds++;
+	}
+
+	return (void *) rounds;
+}
+
+static void *lookup_thread(void *data)
+{
+	long lookups = 0;
+	int i = 0;
+
+	while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+		EGLSurface surface = &churn_surfaces[i % CHURN_THREADS][i % CHURN_SURFACES];
+		EGLNativeWindowType found_window;
+		int found;
+
+		found = egl_helper_find_mapping(window_surface, &found_window);
+		assert(found && found_window == window);
+
+		found = egl_helper_find_mapping(surface, &found_window);
+		assert(!found || found_window == churn_window(surface));
+
+		lookups++;
+		i++;
+	}
+
+	return (void *) lookups;
+}
+
+static void run(int nthreads)
+{
+	struct renderer renderers[MAX_THREADS];
+	pthread_t churners[CHURN_THREADS], lookup;
+	double total = 0, worst = 0;
+	void *rounds, *lookups;
+	long churned = 0;
+	int i, err;
+
+	__atomic_store_n(&stop, 0, __ATOMIC_RELAXED);
+	for (i = 0; i < CHURN_THREADS; i++) {
+		err = pthread_create(&churners[i], NULL, churn_thread, churn_surfaces[i]);
+		assert(err == 0);
+	}
+	err = pthread_create(&lookup, NULL, lookup_thread, NULL);
+	assert(err == 0);
+
+	for (i = 0; i < nthreads; i++) {
+		renderers[i].index = i;
+		err = pthread_create(&renderers[i].thread, NULL, render_thread, &renderers[i]);
+		assert(err == 0);
+	}
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(renderers[i].thread, NULL);
+		total += renderers[i].elapsed;
+		if (renderers[i].elapsed > worst)
+			worst = renderers[i].elapsed;
+	}
+
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < CHURN_THREADS; i++) {
+		pthread_join(churners[i], &rounds);
+		churned += (long) rounds;
+	}
+	pthread_join(lookup, &lookups);
+
+	printf("%2d threads: %8.2f us/swap, %10.0f swaps/s overall, "
+		"%ld surfaces added and removed, %ld lookups\n", nthreads,
+		total / (nthreads * swaps) * 1e6, nthreads * swaps / worst,
+		churned * CHURN_SURFACES, (long) lookups);
+}
+
+int main(int argc, char **argv)
+{
+	EGLint num_config;
+	EGLBoolean ok;
+	int nthreads, max_threads;
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_WINDOW_BIT | EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_NONE
+	};
+
+	swaps = argc > 1 ? atoi(argv[1]) : 2000;
+	max_threads = argc > 2 ? atoi(argv[2]) : 8;
+	if (max_threads > MAX_THREADS)
+		max_threads = MAX_THREADS;
+
+	/* Read when the display is created */
+	setenv("EGL_PLATFORM", "null", 1);
+
+	dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+	ok = eglChooseConfig(dpy, config_attribs, &config, 1, &num_config);
+	assert(ok == EGL_TRUE && num_config == 1);
+
+	/* The null platform creates the display surface's window */
+	window_surface = eglCreateWindowSurface(dpy, config, (EGLNativeWindowType) 0, NULL);
+	assert(window_surface != EGL_NO_SURFACE);
+	window = egl_helper_get_mapping(window_surface);
+
+	printf("%d swaps per thread\n", swaps);
+	for (nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+		run(nthreads);
+
+	eglDestroySurface(dpy, window_surface);
+	eglTerminate(dpy);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
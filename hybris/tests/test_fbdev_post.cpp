@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Drives a fbdev ANativeWindow the way EGL does, on top of a stand-in
+ * framebuffer device whose post() sleeps as long as waiting for the flip
+ * would take, and a stand-in allocator. Compares the frame rate when
+ * buffers are posted from queueBuffer and from the poster thread
+ * (HYBRIS_FBDEV_POST_THREAD), and checks that buffers are posted in the
+ * order they were queued and are never handed out while queued or on screen.
+ * Doesn't need a framebuffer, nor gralloc.
+ *
+ * Usage: test_fbdev_post [frames] [post time in ms] [render time in ms]
+ */
+
+#include <android-config.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <fbdev_window.h>
+
+#define NUM_FRAMEBUFFERS 3
+
+static int post_ms, render_ms;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<buffer_handle_t> queued, posted;
+static buffer_handle_t front;
+static pthread_t render_thread;
+static bool posted_from_render_thread;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Stand-in framebuffer device */
+
+static int fb_post(struct framebuffer_device_t *dev, buffer_handle_t buffer)
+{
+	usleep(post_ms * 1000);
+
+	pthread_mutex_lock(&mutex);
+	posted.push_back(buffer);
+	front = buffer;
+	posted_from_render_thread = pthread_equal(render_thread, pthread_self());
+	pthread_mutex_unlock(&mutex);
+
+	return 0;
+}
+
+static int fb_set_swap_interval(struct framebuffer_device_t *dev, int interval)
+{
+	return 0;
+}
+
+/* Stand-in allocator, whose handles are never dereferenced */
+
+static int alloc_alloc(struct alloc_device_t *dev, int w, int h, int format,
+                       int usage, buffer_handle_t *handle, int *stride)
+{
+	native_handle_t *nh = (native_handle_t *) calloc(1, sizeof(native_handle_t));
+
+	nh->version = sizeof(native_handle_t);
+	*handle = nh;
+	*stride = w;
+	return 0;
+}
+
+static int alloc_free(struct alloc_device_t *dev, buffer_handle_t handle)
+{
+	free((void *) handle);
+	return 0;
+}
+
+/* Renders frames and returns the frame rate */
+static double run(framebuffer_device_t *fb, alloc_device_t *alloc, int frames, bool post_thread)
+{
+	double queue_sum = 0, queue_max = 0;
+	ANativeWindowBuffer *buffer;
+	int i, fence;
+
+	/* Read when the native window is created */
+	setenv("HYBRIS_FBDEV_POST_THREAD", post_thread ? "1" : "0", 1);
+
+	queued.clear();
+	posted.clear();
+	front = NULL;
+	render_thread = pthread_self();
+
+	FbDevNativeWindow *native = new FbDevNativeWindow(alloc, fb);
+	ANativeWindow *window = native;
+
+	double start = now();
+	for (i = 0; i < frames; i++) {
+		int err = window->dequeueBuffer(window, &buffer, &fence);
+		assert(err == 0);
+		assert(fence == -1);
+
+		/* Neither on screen, nor waiting to be */
+		pthread_mutex_lock(&mutex);
+		assert(buffer->handle != front);
+		for (size_t j = posted.size(); j < queued.size(); j++)
+			assert(queued[j] != buffer->handle);
+		queued.push_back(buffer->handle);
+		pthread_mutex_unlock(&mutex);
+
+		usleep(render_ms * 1000);
+
+		double t0 = now();
+		err = window->queueBuffer(window, buffer, -1);
+		double t1 = now();
+		assert(err == 0);
+
+		queue_sum += t1 - t0;
+		if (t1 - t0 > queue_max)
+			queue_max = t1 - t0;
+	}
+
+	/* Posts what is still queued */
+	delete native;
+	double elapsed = now() - start;
+
+	assert(posted == queued);
+	assert(posted_from_render_thread == !post_thread);
+
+	printf("%-14s %8.2f %8.2f %8.2f %8.1f\n",
+		post_thread ? "post thread" : "queueBuffer",
+		queue_sum / frames * 1e3, queue_max * 1e3,
+		elapsed / frames * 1e3, frames / elapsed);
+
+	return frames / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+	framebuffer_device_t fb;
+	alloc_device_t alloc;
+
+	int frames = argc > 1 ? atoi(argv[1]) : 120;
+	post_ms = argc > 2 ? atoi(argv[2]) : 8;
+	render_ms = argc > 3 ? atoi(argv[3]) : 6;
+
+	memset(&fb, 0, sizeof(fb));
+	fb.width = 64;
+	fb.height = 64;
+	fb.stride = 64;
+	fb.format = HAL_PIXEL_FORMAT_RGBA_8888;
+	fb.minSwapInterval = 1;
+	fb.maxSwapInterval = 1;
+	fb.numFramebuffers = NUM_FRAMEBUFFERS;
+	fb.setSwapInterval = fb_set_swap_interval;
+	fb.post = fb_post;
+
+	memset(&alloc, 0, sizeof(alloc));
+	alloc.alloc = alloc_alloc;
+	alloc.free = alloc_free;
+
+	printf("%d frames, %d buffers, %d ms to post, %d ms to render, times in ms\n",
+		frames, NUM_FRAMEBUFFERS, post_ms, render_ms);
+	printf("%-14s %8s %8s %8s %8s\n", "posted from", "queue", "worst",
+		"frame", "fps");
+
+	double inline_fps = run(&fb, &alloc, frames, false);
+	double thread_fps = run(&fb, &alloc, frames, true);
+
+	/* Rendering the next frame overlaps with posting the previous one */
+	assert(thread_fps > inline_fps);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
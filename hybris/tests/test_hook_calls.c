@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Microbenchmark for the overhead of calling hot libc functions through
+ * their hooks, compared to calling glibc directly. Hooks bound straight
+ * to glibc (see HOOK_DIRECT and --enable-direct-hooks) show no overhead.
+ *
+ * Usage: test_hook_calls [iterations]
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <hybris/common/hooks.h>
+
+static const char text[] = "The quick brown fox jumps over the lazy dog";
+static char buffer[64];
+static FILE *devnull;
+static int iterations;
+
+/* Called through volatile pointers, so that the compiler can't inline them */
+static void *(*volatile glibc_memcpy)(void *, const void *, size_t) = memcpy;
+static size_t (*volatile glibc_strlen)(const char *) = strlen;
+static int (*volatile glibc_memcmp)(const void *, const void *, size_t) = memcmp;
+static int (*volatile glibc_strcmp)(const char *, const char *) = strcmp;
+static void *(*volatile glibc_malloc)(size_t) = malloc;
+static int (*volatile glibc_fputs)(const char *, FILE *) = fputs;
+
+static void *(*hook_memcpy)(void *, const void *, size_t);
+static size_t (*hook_strlen)(const char *);
+static int (*hook_memcmp)(const void *, const void *, size_t);
+static int (*hook_strcmp)(const char *, const char *);
+static void *(*hook_malloc)(size_t);
+static void (*hook_free)(void *);
+static int (*hook_fputs)(const char *, FILE *);
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *hook(const char *name)
+{
+	void *func = hybris_get_hooked_symbol(name, "test_hook_calls");
+	assert(func != NULL);
+	return func;
+}
+
+/* Times the call, in ns */
+#define TIME(call, result) \
+	do { \
+		double start = now(); \
+		for (i = 0; i < iterations; i++) \
+			call; \
+		result = (now() - start) * 1e9 / iterations; \
+	} while (0)
+
+/* Prints the times of the glibc and hooked calls, and the difference */
+#define BENCH(name, glibc_call, hook_call) \
+	do { \
+		double direct, hooked; \
+		int i; \
+		TIME(glibc_call, direct); \
+		TIME(hook_call, hooked); \
+		printf("%-8s %8.2f %8.2f %8.2f\n", name, direct, hooked, hooked - direct); \
+	} while (0)
+
+int main(int argc, char **argv)
+{
+	iterations = argc > 1 ? atoi(argv[1]) : 10000000;
+
+	hook_memcpy = hook("memcpy");
+	hook_strlen = hook("strlen");
+	hook_memcmp = hook("memcmp");
+	hook_strcmp = hook("strcmp");
+	hook_malloc = hook("malloc");
+	hook_free = hook("free");
+	hook_fputs = hook("fputs");
+
+	devnull = fopen("/dev/null", "w");
+	assert(devnull != NULL);
+
+	/* The hooks must still behave like glibc */
+	void *copied = hook_memcpy(buffer, text, sizeof(text));
+	assert(copied == buffer);
+	size_t length = hook_strlen(text);
+	assert(length == strlen(text));
+	int compared = hook_memcmp(buffer, text, sizeof(text));
+	assert(compared == 0);
+	compared = hook_strcmp(buffer, text);
+	assert(compared == 0);
+
+	printf("%d iterations, ns per call\n", iterations);
+	printf("%-8s %8s %8s %8s\n", "", "glibc", "hook", "overhead");
+
+	BENCH("memcpy", glibc_memcpy(buffer, text, sizeof(text)), hook_memcpy(buffer, text, sizeof(text)));
+	BENCH("strlen", glibc_strlen(text), hook_strlen(text));
+	BENCH("memcmp", glibc_memcmp(buffer, text, sizeof(text)), hook_memcmp(buffer, text, sizeof(text)));
+	BENCH("strcmp", glibc_strcmp(buffer, text), hook_strcmp(buffer, text));
+	BENCH("malloc", free(glibc_malloc(32)), hook_free(hook_malloc(32)));
+	BENCH("fputs", glibc_fputs(text, devnull), hook_fputs(text, devnull));
+
+	fclose(devnull);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
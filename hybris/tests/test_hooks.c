@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Microbenchmark for the hook lookup done by the linker for every symbol
+ * relocation: all undefined dynamic symbols of a bionic library are
+ * resolved through hybris_get_hooked_symbol() a number of times.
+ *
+ * Usage: test_hooks [library] [iterations]
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hybris/common/hooks.h>
+
+#if defined(__LP64__)
+#define DEFAULT_LIBRARY "/system/lib64/libEGL.so"
+#else
+#define DEFAULT_LIBRARY "/system/lib/libEGL.so"
+#endif
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : DEFAULT_LIBRARY;
+	int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+	const char **names = NULL;
+	size_t count = 0, hooked = 0, n;
+	struct stat st;
+	int fd, i;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return 1;
+	}
+
+	int err = fstat(fd, &st);
+	assert(err == 0);
+	char *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	assert(base != MAP_FAILED);
+	close(fd);
+
+	ElfW(Ehdr) *ehdr = (ElfW(Ehdr) *) base;
+	assert(memcmp(ehdr->e_ident, ELFMAG, SELFMAG) == 0);
+	ElfW(Shdr) *shdr = (ElfW(Shdr) *) (base + ehdr->e_shoff);
+
+	for (i = 0; i < ehdr->e_shnum; i++) {
+		if (shdr[i].sh_type != SHT_DYNSYM)
+			continue;
+
+		ElfW(Sym) *syms = (ElfW(Sym) *) (base + shdr[i].sh_offset);
+		const char *strtab = base + shdr[shdr[i].sh_link].sh_offset;
+		size_t nsyms = shdr[i].sh_size / sizeof(ElfW(Sym));
+
+		names = calloc(nsyms, sizeof(char *));
+		for (n = 1; n < nsyms; n++) {
+			if (syms[n].st_shndx == SHN_UNDEF && syms[n].st_name != 0)
+				names[count++] = strtab + syms[n].st_name;
+		}
+		break;
+	}
+
+	assert(names != NULL);
+
+	/* The first lookup also builds the hook table, keep it out of the timing */
+	for (n = 0; n < count; n++) {
+		if (hybris_get_hooked_symbol(names[n], path))
+			hooked++;
+	}
+
+	double start = now();
+	for (i = 0; i < iterations; i++) {
+		for (n = 0; n < count; n++)
+			hybris_get_hooked_symbol(names[n], path);
+	}
+	double elapsed = now() - start;
+
+	printf("%s: %zu undefined symbols, %zu hooked\n", path, count, hooked);
+	printf("%d iterations: %.3f ms total, %.1f ns per lookup\n", iterations,
+		elapsed * 1e3, elapsed * 1e9 / ((double) iterations * (count ? count : 1)));
+
+	free(names);
+	munmap(base, st.st_size);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
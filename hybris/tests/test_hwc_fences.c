@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Checks which buffer a HWC ANativeWindow hands out when the display
+ * releases buffers out of order. The fake present callback gives each
+ * buffer a release fence on a sw_sync timeline, which the test advances
+ * by hand. Doesn't need a display, nor gralloc: the buffers are never
+ * allocated, but it needs /dev/sw_sync (CONFIG_SW_SYNC).
+ */
+
+#include <android-config.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <system/window.h>
+#include <sync/sync.h>
+#include <hwcomposer.h>
+
+/* From libsync */
+int sw_sync_timeline_create(void);
+int sw_sync_timeline_inc(int fd, unsigned count);
+int sw_sync_fence_create(int fd, const char *name, unsigned value);
+
+static int timeline;
+
+/* The timeline values at which the display releases the presented buffers */
+static const unsigned release_at[] = { 3, 1, 2 };
+static int presented;
+
+static void present(void *user_data, struct ANativeWindow *window,
+                    struct ANativeWindowBuffer *buffer)
+{
+	int fence = sw_sync_fence_create(timeline, "release", release_at[presented++ % 3]);
+
+	assert(fence >= 0);
+	int previous = HWCNativeBufferGetFence(buffer);
+	assert(previous == -1);
+	HWCNativeBufferSetFence(buffer, fence);
+}
+
+static ANativeWindowBuffer *dequeue(struct ANativeWindow *window, int *fence)
+{
+	ANativeWindowBuffer *buffer;
+
+	int err = window->dequeueBuffer(window, &buffer, fence);
+	assert(err == 0);
+	return buffer;
+}
+
+int main(int argc, char **argv)
+{
+	ANativeWindowBuffer *buffers[5], *old[3], *b;
+	int i, j, found, fence, err;
+
+	timeline = sw_sync_timeline_create();
+	if (timeline < 0) {
+		perror("Cannot create a sw_sync timeline, skipping");
+		return 0;
+	}
+
+	struct ANativeWindow *window = HWCNativeWindowCreate(64, 64,
+			HAL_PIXEL_FORMAT_RGBA_8888, present, NULL);
+	assert(window != NULL);
+	err = native_window_set_buffer_count(window, 3);
+	assert(err == 0);
+
+	/* Present the 3 buffers, in order */
+	for (i = 0; i < 3; i++) {
+		buffers[i] = dequeue(window, &fence);
+		assert(fence == -1);
+	}
+	for (i = 0; i < 3; i++) {
+		err = window->queueBuffer(window, buffers[i], -1);
+		assert(err == 0);
+	}
+	assert(presented == 3);
+
+	/* The display releases the second buffer first */
+	err = sw_sync_timeline_inc(timeline, 1);
+	assert(err == 0);
+	b = dequeue(window, &fence);
+	assert(b == buffers[1]);
+	assert(fence == -1);
+	err = window->cancelBuffer(window, b, -1);
+	assert(err == 0);
+
+	/* ... it is still the only one released */
+	b = dequeue(window, &fence);
+	assert(b == buffers[1]);
+	assert(fence == -1);
+
+	/* Nothing else released, so the buffer presented first is the best bet */
+	b = dequeue(window, &fence);
+	assert(b == buffers[0]);
+	assert(fence >= 0);
+	err = sync_wait(fence, 0);
+	assert(err < 0);
+	close(fence);
+
+	/* Then the third buffer is released */
+	err = sw_sync_timeline_inc(timeline, 1);
+	assert(err == 0);
+	b = dequeue(window, &fence);
+	assert(b == buffers[2]);
+	assert(fence == -1);
+
+	for (i = 0; i < 3; i++) {
+		err = window->cancelBuffer(window, buffers[i], -1);
+		assert(err == 0);
+		old[i] = buffers[i];
+	}
+
+	/* Growing the window keeps the current buffers */
+	err = native_window_set_buffer_count(window, 5);
+	assert(err == 0);
+	for (i = 0; i < 5; i++) {
+		buffers[i] = dequeue(window, &fence);
+		assert(fence == -1);
+		for (j = 0; j < i; j++)
+			assert(buffers[j] != buffers[i]);
+	}
+	for (i = 0; i < 3; i++) {
+		for (found = 0, j = 0; j < 5; j++)
+			found |= buffers[j] == old[i];
+		assert(found);
+	}
+	for (i = 0; i < 5; i++) {
+		err = window->cancelBuffer(window, buffers[i], -1);
+		assert(err == 0);
+	}
+
+	HWCNativeWindowDestroy(window);
+	close(timeline);
+
+	printf("buffers handed out in release order\n");
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Drives a HWC ANativeWindow the way EGL does, with a fake present callback
+ * that sleeps as long as a hwcomposer prepare/set would take. Compares the
+ * time the rendering thread spends in dequeueBuffer/queueBuffer when the
+ * callback is called from queueBuffer and from the presenter thread.
+ * Doesn't need a display, nor gralloc: the buffers are never allocated.
+ *
+ * Usage: test_hwc_present [frames] [present time in ms] [render time in ms]
+ */
+
+#include <android-config.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <system/window.h>
+#include <hwcomposer.h>
+
+static int present_ms, render_ms;
+
+struct presenter {
+	int presented;
+	pthread_t thread;
+	int same_thread;
+	ANativeWindowBuffer *last;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void present(void *user_data, struct ANativeWindow *window,
+                    struct ANativeWindowBuffer *buffer)
+{
+	struct presenter *p = user_data;
+
+	/* Buffers are presented in the order they were queued, never twice in a row */
+	assert(buffer != p->last);
+	p->last = buffer;
+	p->presented++;
+	p->same_thread = pthread_equal(p->thread, pthread_self());
+
+	usleep(present_ms * 1000);
+}
+
+/* Renders frames and returns the average time spent swapping, in ms */
+static double run(int frames, enum HWCPresentMode mode)
+{
+	struct presenter p = { 0, pthread_self(), 0, NULL };
+	double dequeue_sum = 0, dequeue_max = 0, queue_sum = 0, queue_max = 0;
+	ANativeWindowBuffer *buffer;
+	int i, fence, err;
+
+	struct ANativeWindow *window = HWCNativeWindowCreate(64, 64,
+			HAL_PIXEL_FORMAT_RGBA_8888, present, &p);
+	assert(window != NULL);
+	err = native_window_set_buffer_count(window, 3);
+	assert(err == 0);
+	err = HWCNativeWindowSetPresentMode(window, mode);
+	assert(err == 0);
+
+	double start = now();
+	for (i = 0; i < frames; i++) {
+		double t0 = now();
+		err = window->dequeueBuffer(window, &buffer, &fence);
+		double t1 = now();
+		assert(err == 0);
+
+		usleep(render_ms * 1000);
+
+		double t2 = now();
+		err = window->queueBuffer(window, buffer, -1);
+		double t3 = now();
+		assert(err == 0);
+
+		dequeue_sum += t1 - t0;
+		if (t1 - t0 > dequeue_max)
+			dequeue_max = t1 - t0;
+		queue_sum += t3 - t2;
+		if (t3 - t2 > queue_max)
+			queue_max = t3 - t2;
+	}
+	double elapsed = now() - start;
+
+	/* Stop the thread, presenting what is still queued */
+	err = HWCNativeWindowSetPresentMode(window, HWC_PRESENT_MODE_IMMEDIATE);
+	assert(err == 0);
+	assert(p.presented == frames);
+	if (mode == HWC_PRESENT_MODE_THREAD)
+		assert(!p.same_thread);
+
+	printf("%-10s %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+		mode == HWC_PRESENT_MODE_THREAD ? "thread" : "immediate",
+		dequeue_sum / frames * 1e3, dequeue_max * 1e3,
+		queue_sum / frames * 1e3, queue_max * 1e3,
+		elapsed / frames * 1e3);
+
+	HWCNativeWindowDestroy(window);
+
+	return (dequeue_sum + queue_sum) / frames * 1e3;
+}
+
+/* Nothing is presented until asked to */
+static void deferred(void)
+{
+	struct presenter p = { 0, pthread_self(), 0, NULL };
+	ANativeWindowBuffer *buffer;
+	int i, fence, err, pending;
+
+	struct ANativeWindow *window = HWCNativeWindowCreate(64, 64,
+			HAL_PIXEL_FORMAT_RGBA_8888, present, &p);
+	assert(window != NULL);
+	err = native_window_set_buffer_count(window, 3);
+	assert(err == 0);
+	err = HWCNativeWindowSetPresentMode(window, HWC_PRESENT_MODE_DEFERRED);
+	assert(err == 0);
+
+	for (i = 0; i < 2; i++) {
+		err = window->dequeueBuffer(window, &buffer, &fence);
+		assert(err == 0);
+		err = window->queueBuffer(window, buffer, -1);
+		assert(err == 0);
+	}
+
+	assert(p.presented == 0);
+	pending = HWCNativeWindowPresentPending(window);
+	assert(pending == 2);
+	assert(p.presented == 2 && p.same_thread);
+	pending = HWCNativeWindowPresentPending(window);
+	assert(pending == 0);
+
+	HWCNativeWindowDestroy(window);
+}
+
+int main(int argc, char **argv)
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 120;
+	present_ms = argc > 2 ? atoi(argv[2]) : 8;
+	render_ms = argc > 3 ? atoi(argv[3]) : 6;
+
+	deferred();
+
+	printf("%d frames, %d ms to present, %d ms to render, times in ms\n",
+		frames, present_ms, render_ms);
+	printf("%-10s %8s %8s %8s %8s %8s\n", "present", "dequeue", "worst",
+		"queue", "worst", "frame");
+
+	double immediate = run(frames, HWC_PRESENT_MODE_IMMEDIATE);
+	double thread = run(frames, HWC_PRESENT_MODE_THREAD);
+
+	/* The rendering thread only waits for presentation when it is ahead */
+	assert(thread < immediate);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Loads a library with 4096 functions called through its PLT (see
+ * lazy_stub.c) through the hybris linker with RTLD_LAZY, without and with
+ * lazy binding (HYBRIS_LD_BIND_LAZY), each time in a new process. Times the
+ * dlopen(), then calls some of the functions from several threads at once,
+ * and a hooked one. Checks they return what they should and, from the
+ * report of the linker at exit, that only the PLT slots of the functions
+ * called were bound. Also checks that a first call doesn't wait for a
+ * dlopen() in another thread, which may be waiting for it, and that it
+ * gets all of its arguments, in registers included.
+ *
+ * Each architecture has its own resolver trampoline. Those of the other
+ * architectures are checked with qemu-user, libhybris being cross-built,
+ * e.g. for armhf:
+ *   qemu-arm -L /usr/arm-linux-gnueabihf test_lazy_binding
+ *
+ * Usage: test_lazy_binding [library] [functions called] [threads]
+ */
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hybris/common/dlfcn.h>
+#include <hybris/common/hooks.h>
+
+#define MAX_THREADS 16
+
+static const char *path;
+static char copy[] = "/tmp/test_lazy_binding.XXXXXX/liblazy_copy.so";
+static int called;
+
+static int (*lazy_call)(int n);
+
+struct result {
+	double elapsed;
+	int count;
+	long deferred;
+	long bound;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Every thread calls the same functions, each starting somewhere else */
+static void *call_thread(void *data)
+{
+	int i, first = *(int *) data;
+
+	for (i = 0; i < called; i++) {
+		int n = (first + i) % called;
+		int result = lazy_call(n);
+		assert(result == n);
+	}
+
+	return NULL;
+}
+
+/* Makes the first call to lazy_0() */
+static void *first_call_thread(void *data)
+{
+	int result = lazy_call(0);
+	assert(result == 0);
+	return NULL;
+}
+
+/* Called while the linker links the copy of the library. Waits for another
+ * thread to call a function for the first time, like a constructor joining
+ * a worker thread would. */
+static void *hook(const char *symbol, const char *requester)
+{
+	pthread_t thread;
+
+	if (strcmp(symbol, "getenv") == 0 && strstr(requester, "/liblazy_copy.so") != NULL) {
+		int err = pthread_create(&thread, NULL, first_call_thread, NULL);
+		assert(err == 0);
+		pthread_join(thread, NULL);
+	}
+
+	return NULL;
+}
+
+/* Copies the library, for the linker to load it again */
+static void copy_library(void)
+{
+	char buffer[65536];
+	size_t size;
+	char *slash = strrchr(copy, '/');
+
+	*slash = '\0';
+	char *dir = mkdtemp(copy);
+	assert(dir != NULL);
+	*slash = '/';
+
+	FILE *from = fopen(path, "rb");
+	FILE *to = fopen(copy, "wb");
+	assert(from != NULL && to != NULL);
+	while ((size = fread(buffer, 1, sizeof(buffer), from)) > 0) {
+		size_t written = fwrite(buffer, 1, size, to);
+		assert(written == size);
+	}
+	fclose(from);
+	fclose(to);
+}
+
+/* Reads the report of the linker at exit from the log */
+static void read_report(const char *log, struct result *result)
+{
+	char line[512];
+	FILE *f = fopen(log, "r");
+
+	assert(f != NULL);
+	result->deferred = result->bound = 0;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		const char *report = strstr(line, "[ Lazy binding at exit: ");
+		if (report != NULL) {
+			int matched = sscanf(report, "[ Lazy binding at exit: %ld slots deferred, %ld bound",
+					&result->deferred, &result->bound);
+			assert(matched == 2);
+		}
+	}
+	fclose(f);
+}
+
+/* Loads the library in a new process */
+static void run(int lazy, int nthreads, struct result *result)
+{
+	char log[] = "/tmp/test_lazy_binding.XXXXXX";
+	int fds[2], status, log_fd, err;
+	ssize_t n;
+
+	log_fd = mkstemp(log);
+	assert(log_fd >= 0);
+	err = pipe(fds);
+	assert(err == 0);
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid == 0) {
+		pthread_t threads[MAX_THREADS];
+		int first[MAX_THREADS], i;
+
+		/* Read when the linker is loaded. It reports on stderr. */
+		setenv("HYBRIS_LD_BIND_LAZY", lazy ? "1" : "0", 1);
+		setenv("HYBRIS_LD_DEBUG", "1", 1);
+		setenv("TEST_LAZY_BINDING", "1", 1);
+		dup2(log_fd, STDERR_FILENO);
+		close(log_fd);
+
+		double start = now();
+		void *handle = hybris_dlopen(path, RTLD_LAZY);
+		double elapsed = now() - start;
+		assert(handle != NULL);
+
+		lazy_call = hybris_dlsym(handle, "lazy_call");
+		assert(lazy_call != NULL);
+		result->count = *(const int *) hybris_dlsym(handle, "lazy_count");
+		assert(called <= result->count);
+
+		/* lazy_store() is bound with all the argument registers in use */
+		void (*lazy_args)(int, int, int, int, int, int, int, int,
+				double, double, double, double, double, double, double, double) =
+			hybris_dlsym(handle, "lazy_args");
+		const int *ints = hybris_dlsym(handle, "lazy_ints");
+		const double *doubles = hybris_dlsym(handle, "lazy_doubles");
+		assert(lazy_args != NULL && ints != NULL && doubles != NULL);
+		lazy_args(1, 2, 3, 4, 5, 6, 7, 8, 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5);
+		for (i = 0; i < 8; i++)
+			assert(ints[i] == i + 1 && doubles[i] == i + 0.5);
+
+		/* lazy_0() is bound while the linker links the copy, from another
+		 * thread. Dies rather than deadlocks if that thread waits for it. */
+		copy_library();
+		hybris_set_hook_callback(hook);
+		alarm(30);
+		void *copy_handle = hybris_dlopen(copy, RTLD_NOW);
+		alarm(0);
+		hybris_set_hook_callback(NULL);
+		assert(copy_handle != NULL);
+		unlink(copy);
+		*strrchr(copy, '/') = '\0';
+		rmdir(copy);
+
+		for (i = 0; i < nthreads; i++) {
+			first[i] = i * called / nthreads;
+			err = pthread_create(&threads[i], NULL, call_thread, &first[i]);
+			assert(err == 0);
+		}
+		for (i = 0; i < nthreads; i++)
+			pthread_join(threads[i], NULL);
+
+		/* getenv() comes from the hooks */
+		char *(*lazy_getenv)(const char *name) = hybris_dlsym(handle, "lazy_getenv");
+		assert(lazy_getenv != NULL);
+		char *value = lazy_getenv("TEST_LAZY_BINDING");
+		assert(value == getenv("TEST_LAZY_BINDING"));
+
+		result->elapsed = elapsed;
+		n = write(fds[1], result, sizeof(*result));
+		assert(n == sizeof(*result));
+
+		/* The linker reports at exit */
+		exit(0);
+	}
+
+	close(log_fd);
+	close(fds[1]);
+	n = read(fds[0], result, sizeof(*result));
+	assert(n == sizeof(*result));
+	close(fds[0]);
+	pid_t waited = waitpid(pid, &status, 0);
+	assert(waited == pid);
+	assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	read_report(log, result);
+	unlink(log);
+}
+
+int main(int argc, char **argv)
+{
+	struct result eager, lazy;
+	int nthreads;
+
+	path = argc > 1 ? argv[1] : LAZY_STUB_PATH;
+	called = argc > 2 ? atoi(argv[2]) : 100;
+	nthreads = argc > 3 ? atoi(argv[3]) : 4;
+	if (nthreads > MAX_THREADS)
+		nthreads = MAX_THREADS;
+
+	assert(called > 0);
+
+	/* The linker must be loaded by the children, with their environment */
+	run(0, nthreads, &eager);
+	run(1, nthreads, &lazy);
+
+	printf("%d functions, %d of them called from %d threads\n", lazy.count, called, nthreads);
+	printf("%-8s %10s %10s %10s\n", "binding", "dlopen ms", "deferred", "bound");
+	printf("%-8s %10.2f %10s %10s\n", "eager", eager.elapsed * 1e3, "-", "-");
+	printf("%-8s %10.2f %10ld %10ld\n", "lazy", lazy.elapsed * 1e3, lazy.deferred, lazy.bound);
+
+	/* The lazy_<n>() slots, the lazy_store() one and the getenv() one */
+	assert(lazy.deferred == lazy.count + 2);
+	assert(lazy.bound == called + 2);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
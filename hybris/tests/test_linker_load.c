@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Loads the dependency tree of libraries built by linker_tree.sh through
+ * the hybris linker, libtree_0.so and the 100 libraries below it, the way a
+ * vendor GL or camera library pulls in its dependencies. The libraries are
+ * dropped from the page cache before each run, so that loading waits on
+ * storage as it does after boot. Each run loads the tree in a new process,
+ * with the libraries read and mapped by one thread and by several
+ * (HYBRIS_LD_LOAD_THREADS), and checks the whole tree was linked.
+ *
+ * Then loads the tree from the page cache, without and with the relocation
+ * cache (HYBRIS_LD_RELOC_CACHE) in a temporary directory: once to fill it,
+ * then from it.
+ *
+ * Usage: test_linker_load [tree directory] [libraries] [runs]
+ */
+
+#include <assert.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hybris/common/dlfcn.h>
+
+static const char *dir;
+static int count;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void drop_cache(const char *name)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fd = open(path, O_RDONLY);
+	assert(fd >= 0);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+/* What tree_<n>() returns, see linker_tree.sh */
+static int tree_value(int n)
+{
+	if (n >= count)
+		return 0;
+	return 1 + n + tree_value(2 * n + 1) + tree_value(2 * n + 2);
+}
+
+static void drop_tree_cache(void)
+{
+	char name[64];
+	int i;
+
+	for (i = 0; i < count; i++) {
+		snprintf(name, sizeof(name), "libtree_%d.so", i);
+		drop_cache(name);
+	}
+	drop_cache("libtree_common.so");
+}
+
+/* Loads the tree in a new process and returns how long it took */
+static double run(const char *threads, const char *reloc_cache)
+{
+	char path[PATH_MAX];
+	int fds[2], status, err;
+	double elapsed;
+	ssize_t n;
+
+	err = pipe(fds);
+	assert(err == 0);
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid == 0) {
+		/* Read when the linker is loaded */
+		setenv("HYBRIS_LD_LOAD_THREADS", threads, 1);
+		if (reloc_cache)
+			setenv("HYBRIS_LD_RELOC_CACHE", reloc_cache, 1);
+
+		snprintf(path, sizeof(path), "%s/libtree_0.so", dir);
+		double start = now();
+		void *handle = hybris_dlopen(path, RTLD_NOW);
+		elapsed = now() - start;
+		assert(handle != NULL);
+
+		int (*tree_0)(void) = hybris_dlsym(handle, "tree_0");
+		assert(tree_0 != NULL);
+		int value = tree_0();
+		assert(value == tree_value(0));
+
+		n = write(fds[1], &elapsed, sizeof(elapsed));
+		assert(n == sizeof(elapsed));
+		_exit(0);
+	}
+
+	close(fds[1]);
+	n = read(fds[0], &elapsed, sizeof(elapsed));
+	assert(n == sizeof(elapsed));
+	close(fds[0]);
+	pid_t waited = waitpid(pid, &status, 0);
+	assert(waited == pid);
+	assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	return elapsed;
+}
+
+static void remove_dir(const char *path)
+{
+	char file[PATH_MAX];
+	struct dirent *entry;
+	DIR *d = opendir(path);
+	int err;
+
+	assert(d != NULL);
+	while ((entry = readdir(d)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+		snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+		err = unlink(file);
+		assert(err == 0);
+	}
+	closedir(d);
+	err = rmdir(path);
+	assert(err == 0);
+}
+
+int main(int argc, char **argv)
+{
+	double serial = 0, parallel = 0, uncached = 0, warm = 0, cold, t;
+	char reloc_cache[] = "/tmp/test_linker_load.XXXXXX";
+	int i, runs;
+
+	dir = argc > 1 ? argv[1] : LINKER_TREE_DIR;
+	count = argc > 2 ? atoi(argv[2]) : 100;
+	runs = argc > 3 ? atoi(argv[3]) : 5;
+
+	printf("%d libraries from %s, times in ms\n", count + 1, dir);
+	printf("%4s %10s %10s\n", "run", "1 thread", "4 threads");
+
+	for (i = 0; i < runs; i++) {
+		drop_tree_cache();
+		t = run("1", NULL);
+		serial += t;
+		printf("%4d %10.2f", i, t * 1e3);
+
+		drop_tree_cache();
+		t = run("4", NULL);
+		parallel += t;
+		printf(" %10.2f\n", t * 1e3);
+	}
+
+	printf("%4s %10.2f %10.2f\n", "avg", serial / runs * 1e3, parallel / runs * 1e3);
+
+	/* Relocation cache, the files stay in the page cache from now on */
+	char *made = mkdtemp(reloc_cache);
+	assert(made != NULL);
+	cold = run("1", reloc_cache);
+
+	printf("\n%4s %10s %10s\n", "run", "no cache", "cached");
+	for (i = 0; i < runs; i++) {
+		t = run("1", NULL);
+		uncached += t;
+		printf("%4d %10.2f", i, t * 1e3);
+
+		t = run("1", reloc_cache);
+		warm += t;
+		printf(" %10.2f\n", t * 1e3);
+	}
+
+	printf("%4s %10.2f %10.2f\n", "avg", uncached / runs * 1e3, warm / runs * 1e3);
+	printf("filling the relocation cache: %.2f\n", cold * 1e3);
+
+	remove_dir(reloc_cache);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Loads liblookup.so, built by linker_lookup.sh, through the hybris linker:
+ * binding it resolves 50000 symbols picked at random against the group of
+ * libraries it needs, half of which none of them defines, the way a vendor
+ * library probes for optional entry points. Each run loads it in a new
+ * process, once with libraries that have GNU hash tables and once with
+ * libraries that only have SysV ones, and checks every symbol was bound to
+ * the right function, or left unresolved.
+ *
+ * Usage: test_linker_lookup [lookup directory] [runs]
+ */
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hybris/common/dlfcn.h>
+
+static const char *dir;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Even entries are defined, odd ones are weak and undefined */
+static void check(void *handle)
+{
+	int (*const *table)(void) = hybris_dlsym(handle, "lookup_table");
+	const unsigned long *count = hybris_dlsym(handle, "lookup_count");
+	unsigned long i;
+
+	assert(table != NULL && count != NULL);
+	for (i = 0; i < *count; i++) {
+		if (i % 2)
+			assert(table[i] == NULL);
+		else
+			assert(table[i] != NULL);
+	}
+
+	/* lookup_<n>_<i>() returns <i> */
+	int (*first)(void) = hybris_dlsym(handle, "lookup_0_7");
+	assert(first != NULL);
+	int value = first();
+	assert(value == 7);
+}
+
+/* Loads liblookup.so from <dir>/<style> in a new process, returns how long it took */
+static double run(const char *style)
+{
+	char path[PATH_MAX];
+	int fds[2], status, err;
+	double elapsed;
+	ssize_t n;
+
+	err = pipe(fds);
+	assert(err == 0);
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid == 0) {
+		snprintf(path, sizeof(path), "%s/%s/liblookup.so", dir, style);
+		double start = now();
+		void *handle = hybris_dlopen(path, RTLD_NOW);
+		elapsed = now() - start;
+		assert(handle != NULL);
+
+		check(handle);
+
+		n = write(fds[1], &elapsed, sizeof(elapsed));
+		assert(n == sizeof(elapsed));
+		_exit(0);
+	}
+
+	close(fds[1]);
+	n = read(fds[0], &elapsed, sizeof(elapsed));
+	assert(n == sizeof(elapsed));
+	close(fds[0]);
+	pid_t waited = waitpid(pid, &status, 0);
+	assert(waited == pid);
+	assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+	double gnu = 0, sysv = 0, t;
+	int i, runs;
+
+	dir = argc > 1 ? argv[1] : LINKER_LOOKUP_DIR;
+	runs = argc > 2 ? atoi(argv[2]) : 5;
+
+	printf("liblookup.so from %s, times in ms\n", dir);
+	printf("%4s %10s %10s\n", "run", "GNU hash", "SysV hash");
+
+	for (i = 0; i < runs; i++) {
+		t = run("gnu");
+		gnu += t;
+		printf("%4d %10.2f", i, t * 1e3);
+
+		t = run("sysv");
+		sysv += t;
+		printf(" %10.2f\n", t * 1e3);
+	}
+
+	printf("%4s %10.2f %10.2f\n", "avg", gnu / runs * 1e3, sysv / runs * 1e3);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
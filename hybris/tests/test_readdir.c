@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Scans a synthetic directory tree from several threads at once through
+ * the dirent.h hooks, checking that every thread sees every entry (which
+ * fails if concurrent directory streams share their readdir storage).
+ *
+ * Usage: test_readdir [threads] [directories] [files per directory]
+ */
+
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hybris/common/hooks.h>
+
+/* "struct dirent" from bionic/libc/include/dirent.h */
+struct bionic_dirent {
+	uint64_t         d_ino;
+	int64_t          d_off;
+	unsigned short   d_reclen;
+	unsigned char    d_type;
+	char             d_name[256];
+};
+
+static DIR *(*hook_opendir)(const char *);
+static struct bionic_dirent *(*hook_readdir)(DIR *);
+static int (*hook_closedir)(DIR *);
+
+static char root[] = "/tmp/test_readdir.XXXXXX";
+static int ndirs, nfiles;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *hook(const char *name)
+{
+	void *func = hybris_get_hooked_symbol(name, "test_readdir");
+	assert(func != NULL);
+	return func;
+}
+
+/* Returns the number of regular files below path */
+static int scan(const char *path)
+{
+	struct bionic_dirent *entry;
+	char child[PATH_MAX];
+	int count = 0;
+
+	DIR *dir = hook_opendir(path);
+	assert(dir != NULL);
+
+	while ((entry = hook_readdir(dir)) != NULL) {
+		if (entry->d_name[0] == '.')
+			continue;
+
+		if (entry->d_type == DT_DIR) {
+			snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+			count += scan(child);
+		} else {
+			count++;
+		}
+	}
+
+	int err = hook_closedir(dir);
+	assert(err == 0);
+
+	return count;
+}
+
+static void *worker(void *arg)
+{
+	int count = scan(root);
+	assert(count == ndirs * nfiles);
+	return NULL;
+}
+
+static void populate(int create)
+{
+	char path[PATH_MAX];
+	int d, f;
+
+	for (d = 0; d < ndirs; d++) {
+		snprintf(path, sizeof(path), "%s/dir%d", root, d);
+		if (create) {
+			int err = mkdir(path, 0755);
+			assert(err == 0);
+		}
+
+		for (f = 0; f < nfiles; f++) {
+			snprintf(path, sizeof(path), "%s/dir%d/file%d", root, d, f);
+			if (create)
+				close(open(path, O_CREAT | O_WRONLY, 0644));
+			else
+				unlink(path);
+		}
+
+		if (!create) {
+			snprintf(path, sizeof(path), "%s/dir%d", root, d);
+			rmdir(path);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int nthreads = argc > 1 ? atoi(argv[1]) : 8;
+	pthread_t *threads;
+	int i;
+
+	ndirs = argc > 2 ? atoi(argv[2]) : 100;
+	nfiles = argc > 3 ? atoi(argv[3]) : 200;
+
+	hook_opendir = hook("opendir");
+	hook_readdir = hook("readdir");
+	hook_closedir = hook("closedir");
+
+	char *dir = mkdtemp(root);
+	assert(dir != NULL);
+	populate(1);
+
+	threads = calloc(nthreads, sizeof(pthread_t));
+
+	double start = now();
+	for (i = 0; i < nthreads; i++) {
+		int err = pthread_create(&threads[i], NULL, worker, NULL);
+		assert(err == 0);
+	}
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	double elapsed = now() - start;
+
+	printf("%d threads scanned %d entries each: %.3f ms, %.1f ns per entry\n",
+		nthreads, ndirs * nfiles, elapsed * 1e3,
+		elapsed * 1e9 / ((double) nthreads * ndirs * nfiles));
+
+	populate(0);
+	rmdir(root);
+	free(threads);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Loads a library with a few MB of RELRO (see relro_stub.c) through the
+ * hybris linker in two processes at once, like a compositor and a GL client
+ * would, and reports how much of its RELRO each one holds as private dirty
+ * memory, and its proportional set size (PSS):
+ * - loaded as usual,
+ * - loaded with hybris_dlopen_ext(), at an address the parent reserved for
+ *   both, the first process writing its RELRO to a file
+ *   (HYBRIS_DLEXT_WRITE_RELRO) and the second one using it
+ *   (HYBRIS_DLEXT_USE_RELRO),
+ * - loaded as usual with HYBRIS_RELRO_DIR set, which does the same.
+ * Checks that the processes share the RELRO in the last two cases.
+ *
+ * Usage: test_relro [library]
+ */
+
+#include <assert.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <hybris/common/dlfcn.h>
+
+#define RESERVED_SIZE (64 * 1024 * 1024)
+
+enum mode {
+	MODE_USUAL,
+	MODE_EXT,
+	MODE_DIR,
+};
+
+struct usage {
+	long private_dirty;
+	long pss;
+};
+
+static const char *library;
+static char dir[] = "/tmp/test_relro.XXXXXX";
+static void *reserved;
+
+/* Sums up the memory of the mappings overlapping [start, end), in kB */
+static struct usage measure(unsigned long start, unsigned long end)
+{
+	struct usage usage = { 0, 0 };
+	unsigned long from, to;
+	char line[512];
+	int in_range = 0;
+	long kb;
+
+	FILE *smaps = fopen("/proc/self/smaps", "r");
+	assert(smaps != NULL);
+
+	while (fgets(line, sizeof(line), smaps)) {
+		if (sscanf(line, "%lx-%lx ", &from, &to) == 2)
+			in_range = from < end && to > start;
+		else if (in_range && sscanf(line, "Private_Dirty: %ld kB", &kb) == 1)
+			usage.private_dirty += kb;
+		else if (in_range && sscanf(line, "Pss: %ld kB", &kb) == 1)
+			usage.pss += kb;
+	}
+
+	fclose(smaps);
+	return usage;
+}
+
+static void *load(enum mode mode, int index)
+{
+	char path[PATH_MAX];
+	hybris_dlextinfo extinfo;
+	void *handle;
+
+	switch (mode) {
+	case MODE_USUAL:
+		return hybris_dlopen(library, RTLD_NOW);
+	case MODE_EXT:
+		snprintf(path, sizeof(path), "%s/relro", dir);
+		memset(&extinfo, 0, sizeof(extinfo));
+		extinfo.flags = HYBRIS_DLEXT_RESERVED_ADDRESS;
+		extinfo.reserved_addr = reserved;
+		extinfo.reserved_size = RESERVED_SIZE;
+		if (index == 0) {
+			extinfo.flags |= HYBRIS_DLEXT_WRITE_RELRO;
+			extinfo.relro_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		} else {
+			extinfo.flags |= HYBRIS_DLEXT_USE_RELRO;
+			extinfo.relro_fd = open(path, O_RDONLY);
+		}
+		assert(extinfo.relro_fd >= 0);
+		handle = hybris_dlopen_ext(library, RTLD_NOW, &extinfo);
+		close(extinfo.relro_fd);
+		return handle;
+	case MODE_DIR:
+		/* Read when the linker is loaded */
+		setenv("HYBRIS_RELRO_DIR", dir, 1);
+		return hybris_dlopen(library, RTLD_NOW);
+	}
+
+	return NULL;
+}
+
+/* Loads the library, then measures its RELRO when asked to */
+static void child(enum mode mode, int index, int command, int result)
+{
+	struct usage usage;
+	unsigned long i;
+	ssize_t n;
+	char c = 0;
+
+	void *handle = load(mode, index);
+	assert(handle != NULL);
+
+	int (*const *table)(void) = hybris_dlsym(handle, "relro_table");
+	const unsigned long *size = hybris_dlsym(handle, "relro_table_size");
+	assert(table != NULL && size != NULL);
+	int first = table[0](), last = table[*size - 1]();
+	assert(first == 1 && last == 2);
+
+	/* Reads the whole table, so that it is all counted */
+	for (i = 0; i < *size; i++)
+		assert(table[i] == table[i < *size / 2 ? 0 : *size - 1]);
+	if (mode == MODE_EXT)
+		assert((void *) table >= reserved && (char *) table < (char *) reserved + RESERVED_SIZE);
+
+	n = write(result, &c, 1);
+	assert(n == 1);
+
+	n = read(command, &c, 1);
+	assert(n == 1);
+	usage = measure((unsigned long) table, (unsigned long) (table + *size));
+	n = write(result, &usage, sizeof(usage));
+	assert(n == sizeof(usage));
+
+	/* Until the parent is done with both */
+	read(command, &c, 1);
+	_exit(0);
+}
+
+static void run(enum mode mode, const char *name, struct usage usage[2])
+{
+	int command[2][2], result[2][2], status, err, i;
+	pid_t pids[2], waited;
+	ssize_t n;
+	char c = 0;
+
+	for (i = 0; i < 2; i++) {
+		err = pipe(command[i]);
+		assert(err == 0);
+		err = pipe(result[i]);
+		assert(err == 0);
+
+		pids[i] = fork();
+		assert(pids[i] >= 0);
+		if (pids[i] == 0) {
+			close(command[i][1]);
+			child(mode, i, command[i][0], result[i][1]);
+		}
+
+		/* The second process starts once the first one has loaded the library */
+		n = read(result[i][0], &c, 1);
+		assert(n == 1);
+	}
+
+	for (i = 0; i < 2; i++) {
+		n = write(command[i][1], &c, 1);
+		assert(n == 1);
+		n = read(result[i][0], &usage[i], sizeof(usage[i]));
+		assert(n == sizeof(usage[i]));
+	}
+
+	/* The second process has the first one's pipes too */
+	for (i = 0; i < 2; i++)
+		close(command[i][1]);
+
+	for (i = 0; i < 2; i++) {
+		waited = waitpid(pids[i], &status, 0);
+		assert(waited == pids[i]);
+		assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+		close(command[i][0]);
+		close(result[i][0]);
+		close(result[i][1]);
+	}
+
+	printf("%-18s %10ld %10ld %10ld %10ld\n", name,
+		usage[0].private_dirty, usage[0].pss,
+		usage[1].private_dirty, usage[1].pss);
+}
+
+static void clear_dir(void)
+{
+	char path[PATH_MAX];
+	struct dirent *entry;
+	DIR *d = opendir(dir);
+	int err;
+
+	assert(d != NULL);
+	while ((entry = readdir(d)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+		err = unlink(path);
+		assert(err == 0);
+	}
+	closedir(d);
+}
+
+int main(int argc, char **argv)
+{
+	struct usage usual[2], ext[2], shared[2];
+	int err;
+
+	library = argc > 1 ? argv[1] : RELRO_STUB_PATH;
+
+	/* The children load the linker, the parent doesn't */
+	char *made = mkdtemp(dir);
+	assert(made != NULL);
+	reserved = mmap(NULL, RESERVED_SIZE, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	assert(reserved != MAP_FAILED);
+
+	printf("RELRO of %s, in kB\n", library);
+	printf("%-18s %10s %10s %10s %10s\n", "", "1st dirty", "1st PSS", "2nd dirty", "2nd PSS");
+
+	run(MODE_USUAL, "usual", usual);
+	run(MODE_EXT, "hybris_dlopen_ext", ext);
+	clear_dir();
+	run(MODE_DIR, "HYBRIS_RELRO_DIR", shared);
+	clear_dir();
+
+	err = rmdir(dir);
+	assert(err == 0);
+
+	/* Both processes map the RELRO from the file, and share it */
+	assert(ext[1].private_dirty < usual[1].private_dirty / 4);
+	assert(shared[1].private_dirty < usual[1].private_dirty / 4);
+	assert(shared[0].pss + shared[1].pss < (usual[0].pss + usual[1].pss) * 3 / 4);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
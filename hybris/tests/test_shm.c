@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Multi-process test and benchmark for process-shared locks, which live
+ * in the hybris shared memory region.
+ *
+ * Usage: test_shm [processes] [iterations] [objects] [cycles]
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hybris/common/hooks.h>
+
+/* Large enough for any bionic pthread type */
+typedef struct {
+	int value[16];
+} bionic_lock_t;
+
+struct shared {
+	bionic_lock_t common_mutex;
+	volatile int counter;
+	int nobjects;
+	bionic_lock_t *objects;
+	bionic_lock_t mutexes[];
+};
+
+static int (*mutex_init)(bionic_lock_t *, const pthread_mutexattr_t *);
+static int (*mutex_lock)(bionic_lock_t *);
+static int (*mutex_unlock)(bionic_lock_t *);
+static int (*mutex_destroy)(bionic_lock_t *);
+static int (*cond_init)(bionic_lock_t *, const pthread_condattr_t *);
+static int (*cond_destroy)(bionic_lock_t *);
+static int (*rwlockattr_init)(bionic_lock_t *);
+static int (*rwlockattr_setpshared)(bionic_lock_t *, int);
+static int (*rwlockattr_destroy)(bionic_lock_t *);
+static int (*rwlock_init)(bionic_lock_t *, const bionic_lock_t *);
+static int (*rwlock_destroy)(bionic_lock_t *);
+
+static void *hook(const char *name)
+{
+	void *func = hybris_get_hooked_symbol(name, "test_shm");
+	assert(func != NULL);
+	return func;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void init_pshared_mutex(bionic_lock_t *mutex)
+{
+	pthread_mutexattr_t attr;
+
+	/* The hooks pass mutex attributes straight to glibc */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	int err = mutex_init(mutex, &attr);
+	assert(err == 0);
+	pthread_mutexattr_destroy(&attr);
+}
+
+static off_t shm_size(void)
+{
+	struct stat st;
+	int fd = shm_open("/hybris_shm_data", O_RDONLY, 0);
+
+	assert(fd >= 0);
+	int err = fstat(fd, &st);
+	assert(err == 0);
+	close(fd);
+
+	return st.st_size;
+}
+
+/* Runs fn in nprocs child processes and returns the average time per iteration */
+static double run(int nprocs, int iterations, void (*fn)(struct shared *, int, int),
+                  struct shared *shared)
+{
+	double start = now();
+	int i, status;
+
+	for (i = 0; i < nprocs; i++) {
+		if (fork() == 0) {
+			fn(shared, i, iterations);
+			_exit(0);
+		}
+	}
+
+	for (i = 0; i < nprocs; i++) {
+		wait(&status);
+		assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+
+	return (now() - start) * 1e9 / iterations;
+}
+
+static void uncontended(struct shared *shared, int index, int iterations)
+{
+	bionic_lock_t *mutex = &shared->mutexes[index];
+	int i, err;
+
+	for (i = 0; i < iterations; i++) {
+		err = mutex_lock(mutex);
+		assert(err == 0);
+		err = mutex_unlock(mutex);
+		assert(err == 0);
+	}
+}
+
+static void contended(struct shared *shared, int index, int iterations)
+{
+	int i, err;
+
+	for (i = 0; i < iterations; i++) {
+		err = mutex_lock(&shared->common_mutex);
+		assert(err == 0);
+		shared->counter++;
+		err = mutex_unlock(&shared->common_mutex);
+		assert(err == 0);
+	}
+}
+
+/* Each of two processes creates half of the objects, growing the region */
+static void create_objects(struct shared *shared, int index, int iterations)
+{
+	int i;
+
+	for (i = index; i < shared->nobjects; i += 2)
+		init_pshared_mutex(&shared->objects[i]);
+}
+
+/* ... and then uses all of them, including the ones created by the other */
+static void use_objects(struct shared *shared, int index, int iterations)
+{
+	int i, err;
+
+	for (i = 0; i < shared->nobjects; i++) {
+		err = mutex_lock(&shared->objects[i]);
+		assert(err == 0);
+		err = mutex_unlock(&shared->objects[i]);
+		assert(err == 0);
+	}
+}
+
+/* The hooks pass condition attributes straight to glibc, but not rwlock ones */
+static void init_attrs(pthread_condattr_t *cattr, bionic_lock_t *rwattr)
+{
+	pthread_condattr_init(cattr);
+	pthread_condattr_setpshared(cattr, PTHREAD_PROCESS_SHARED);
+	int err = rwlockattr_init(rwattr);
+	assert(err == 0);
+	err = rwlockattr_setpshared(rwattr, PTHREAD_PROCESS_SHARED);
+	assert(err == 0);
+}
+
+static void destroy_attrs(pthread_condattr_t *cattr, bionic_lock_t *rwattr)
+{
+	pthread_condattr_destroy(cattr);
+	rwlockattr_destroy(rwattr);
+}
+
+/* Creates and destroys as many objects of each kind as the soak has at once
+ * in count processes, so that their size classes have freed objects */
+static void warm_up(int count)
+{
+	pthread_condattr_t cattr;
+	bionic_lock_t rwattr;
+	bionic_lock_t *objects = calloc(3 * count, sizeof(bionic_lock_t));
+	int i, err;
+
+	assert(objects != NULL);
+	init_attrs(&cattr, &rwattr);
+
+	for (i = 0; i < count; i++) {
+		init_pshared_mutex(&objects[3 * i]);
+		err = cond_init(&objects[3 * i + 1], &cattr);
+		assert(err == 0);
+		err = rwlock_init(&objects[3 * i + 2], &rwattr);
+		assert(err == 0);
+	}
+
+	for (i = 0; i < count; i++) {
+		err = mutex_destroy(&objects[3 * i]);
+		assert(err == 0);
+		err = cond_destroy(&objects[3 * i + 1]);
+		assert(err == 0);
+		err = rwlock_destroy(&objects[3 * i + 2]);
+		assert(err == 0);
+	}
+
+	destroy_attrs(&cattr, &rwattr);
+	free(objects);
+}
+
+/* Creates and destroys pshared objects, which must not grow the region */
+static void soak(struct shared *shared, int index, int iterations)
+{
+	pthread_condattr_t cattr;
+	bionic_lock_t rwattr;
+	bionic_lock_t mutex, cond, rwlock;
+	int i, err;
+
+	init_attrs(&cattr, &rwattr);
+
+	for (i = 0; i < iterations; i++) {
+		init_pshared_mutex(&mutex);
+		err = cond_init(&cond, &cattr);
+		assert(err == 0);
+		err = rwlock_init(&rwlock, &rwattr);
+		assert(err == 0);
+
+		err = mutex_destroy(&mutex);
+		assert(err == 0);
+		err = cond_destroy(&cond);
+		assert(err == 0);
+		err = rwlock_destroy(&rwlock);
+		assert(err == 0);
+	}
+
+	destroy_attrs(&cattr, &rwattr);
+}
+
+int main(int argc, char **argv)
+{
+	int nprocs = argc > 1 ? atoi(argv[1]) : 4;
+	int iterations = argc > 2 ? atoi(argv[2]) : 1000000;
+	int nobjects = argc > 3 ? atoi(argv[3]) : 10000;
+	int cycles = argc > 4 ? atoi(argv[4]) : 1000000;
+	size_t size = sizeof(struct shared) + nprocs * sizeof(bionic_lock_t);
+	int i;
+
+	mutex_init = hook("pthread_mutex_init");
+	mutex_lock = hook("pthread_mutex_lock");
+	mutex_unlock = hook("pthread_mutex_unlock");
+	mutex_destroy = hook("pthread_mutex_destroy");
+	cond_init = hook("pthread_cond_init");
+	cond_destroy = hook("pthread_cond_destroy");
+	rwlockattr_init = hook("pthread_rwlockattr_init");
+	rwlockattr_setpshared = hook("pthread_rwlockattr_setpshared");
+	rwlockattr_destroy = hook("pthread_rwlockattr_destroy");
+	rwlock_init = hook("pthread_rwlock_init");
+	rwlock_destroy = hook("pthread_rwlock_destroy");
+
+	/* Holds the bionic side of the locks, which only store shm handles */
+	struct shared *shared = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	assert(shared != MAP_FAILED);
+
+	shared->nobjects = nobjects;
+	shared->objects = mmap(NULL, nobjects * sizeof(bionic_lock_t), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	assert(shared->objects != MAP_FAILED);
+
+	init_pshared_mutex(&shared->common_mutex);
+	for (i = 0; i < nprocs; i++)
+		init_pshared_mutex(&shared->mutexes[i]);
+
+	printf("%d processes, %d iterations\n", nprocs, iterations);
+	printf("uncontended lock/unlock: %.1f ns\n",
+		run(nprocs, iterations, uncontended, shared));
+	printf("contended lock/unlock:   %.1f ns\n",
+		run(nprocs, iterations, contended, shared));
+
+	assert(shared->counter == nprocs * iterations);
+
+	printf("create %d objects in 2 processes: %.1f ns per object\n", nobjects,
+		run(2, nobjects, create_objects, shared));
+	run(2, 1, use_objects, shared);
+
+	mutex_destroy(&shared->common_mutex);
+	for (i = 0; i < nprocs; i++)
+		mutex_destroy(&shared->mutexes[i]);
+	for (i = 0; i < nobjects; i++)
+		mutex_destroy(&shared->objects[i]);
+
+	munmap(shared->objects, nobjects * sizeof(bionic_lock_t));
+
+	/* The mutexes above were freed, but conditions and rwlocks may have size
+	 * classes of their own, which need freed objects too. Then the soak only
+	 * reuses objects. */
+	warm_up(nprocs);
+	off_t size_before = shm_size();
+	printf("%d create/destroy cycles in %d processes: %.1f ns per cycle\n", cycles, nprocs,
+		run(nprocs, cycles, soak, shared));
+	off_t size_after = shm_size();
+	printf("shm region: %ld bytes before, %ld bytes after\n",
+		(long) size_before, (long) size_after);
+	assert(size_after == size_before);
+	munmap(shared, size);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
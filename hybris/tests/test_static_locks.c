@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Stress test for the lazy translation of statically initialized bionic
+ * mutexes, conditions and rwlocks: many threads race on the first use of
+ * a freshly "static initialized" lock and then check mutual exclusion.
+ *
+ * Usage: test_static_locks [threads] [rounds]
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hybris/common/hooks.h>
+
+#define ITERATIONS 1000
+
+/* Large enough for any bionic pthread type, all static initializers are 0 */
+typedef struct {
+	int value[16];
+} bionic_lock_t;
+
+static int (*mutex_lock)(bionic_lock_t *);
+static int (*mutex_unlock)(bionic_lock_t *);
+static int (*mutex_destroy)(bionic_lock_t *);
+static int (*cond_wait)(bionic_lock_t *, bionic_lock_t *);
+static int (*cond_broadcast)(bionic_lock_t *);
+static int (*cond_destroy)(bionic_lock_t *);
+static int (*rwlock_wrlock)(bionic_lock_t *);
+static int (*rwlock_rdlock)(bionic_lock_t *);
+static int (*rwlock_unlock)(bionic_lock_t *);
+static int (*rwlock_destroy)(bionic_lock_t *);
+
+static bionic_lock_t mutex;
+static bionic_lock_t cond;
+static bionic_lock_t rwlock;
+static pthread_barrier_t barrier;
+static volatile int counter;
+static volatile int inside;
+static int started;
+
+static void *hook(const char *name)
+{
+	void *func = hybris_get_hooked_symbol(name, "test_static_locks");
+	assert(func != NULL);
+	return func;
+}
+
+static void *worker(void *arg)
+{
+	int i, err, was_inside;
+
+	/* Everybody hits the uninitialized locks at the same time */
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < ITERATIONS; i++) {
+		err = mutex_lock(&mutex);
+		assert(err == 0);
+		was_inside = inside++;
+		assert(was_inside == 0);
+		counter++;
+		inside--;
+		err = mutex_unlock(&mutex);
+		assert(err == 0);
+
+		err = rwlock_wrlock(&rwlock);
+		assert(err == 0);
+		was_inside = inside++;
+		assert(was_inside == 0);
+		counter++;
+		inside--;
+		err = rwlock_unlock(&rwlock);
+		assert(err == 0);
+
+		err = rwlock_rdlock(&rwlock);
+		assert(err == 0);
+		err = rwlock_unlock(&rwlock);
+		assert(err == 0);
+	}
+
+	/* Wait until all threads are done, exercising the condition */
+	err = mutex_lock(&mutex);
+	assert(err == 0);
+	started--;
+	if (started == 0) {
+		err = cond_broadcast(&cond);
+		assert(err == 0);
+	}
+	while (started > 0) {
+		err = cond_wait(&cond, &mutex);
+		assert(err == 0);
+	}
+	err = mutex_unlock(&mutex);
+	assert(err == 0);
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int nthreads = argc > 1 ? atoi(argv[1]) : 16;
+	int rounds = argc > 2 ? atoi(argv[2]) : 100;
+	pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+	int r, i;
+
+	mutex_lock = hook("pthread_mutex_lock");
+	mutex_unlock = hook("pthread_mutex_unlock");
+	mutex_destroy = hook("pthread_mutex_destroy");
+	cond_wait = hook("pthread_cond_wait");
+	cond_broadcast = hook("pthread_cond_broadcast");
+	cond_destroy = hook("pthread_cond_destroy");
+	rwlock_wrlock = hook("pthread_rwlock_wrlock");
+	rwlock_rdlock = hook("pthread_rwlock_rdlock");
+	rwlock_unlock = hook("pthread_rwlock_unlock");
+	rwlock_destroy = hook("pthread_rwlock_destroy");
+
+	for (r = 0; r < rounds; r++) {
+		/* PTHREAD_MUTEX_INITIALIZER and friends */
+		memset(&mutex, 0, sizeof(mutex));
+		memset(&cond, 0, sizeof(cond));
+		memset(&rwlock, 0, sizeof(rwlock));
+		counter = 0;
+		started = nthreads;
+
+		pthread_barrier_init(&barrier, NULL, nthreads);
+		for (i = 0; i < nthreads; i++) {
+			int err = pthread_create(&threads[i], NULL, worker, NULL);
+			assert(err == 0);
+		}
+		for (i = 0; i < nthreads; i++)
+			pthread_join(threads[i], NULL);
+		pthread_barrier_destroy(&barrier);
+
+		assert(counter == nthreads * ITERATIONS * 2);
+
+		mutex_destroy(&mutex);
+		cond_destroy(&cond);
+		rwlock_destroy(&rwlock);
+	}
+
+	printf("%d rounds with %d threads passed\n", rounds, nthreads);
+
+	free(threads);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Checks the damage a Wayland EGL client sends to the compositor: a stub
+ * compositor runs in a thread of this process, and records what it gets
+ * with each wl_surface.commit. Also checks the buffer age queried before
+ * drawing each frame against the buffers the compositor was given.
+ *
+ * Run with EGL_PLATFORM=wayland.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <wayland-client.h>
+#include <wayland-server.h>
+#include <wayland-egl.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define FRAMES 10
+#define MAX_RECTS 16
+
+typedef EGLBoolean (*PFNEGLBINDWAYLANDDISPLAYWL)(EGLDisplay dpy, struct wl_display *display);
+
+/* Stub compositor */
+
+struct rect {
+	int buffer;
+	int32_t x, y, width, height;
+};
+
+static struct {
+	pthread_mutex_t mutex;
+	int pending_count;
+	struct rect pending[MAX_RECTS];
+	int count;
+	struct rect committed[MAX_RECTS];
+	int commits;
+	/* The buffer attached with each commit */
+	struct wl_resource *presented[FRAMES];
+	struct wl_resource *attached;
+	struct wl_resource *frame;
+	struct wl_listener attached_destroy;
+} server = { PTHREAD_MUTEX_INITIALIZER };
+
+static void add_damage(int buffer, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+	pthread_mutex_lock(&server.mutex);
+	if (server.pending_count < MAX_RECTS) {
+		struct rect *rect = &server.pending[server.pending_count++];
+
+		rect->buffer = buffer;
+		rect->x = x;
+		rect->y = y;
+		rect->width = width;
+		rect->height = height;
+	}
+	pthread_mutex_unlock(&server.mutex);
+}
+
+static void attached_destroyed(struct wl_listener *listener, void *data)
+{
+	server.attached = NULL;
+	wl_list_remove(&server.attached_destroy.link);
+}
+
+static void surface_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static void surface_attach(struct wl_client *client, struct wl_resource *resource,
+                           struct wl_resource *buffer, int32_t x, int32_t y)
+{
+	if (buffer == server.attached)
+		return;
+
+	/* The previous buffer can be reused by the client right away */
+	if (server.attached) {
+		wl_buffer_send_release(server.attached);
+		wl_list_remove(&server.attached_destroy.link);
+	}
+
+	server.attached = buffer;
+	if (buffer) {
+		server.attached_destroy.notify = attached_destroyed;
+		wl_resource_add_destroy_listener(buffer, &server.attached_destroy);
+	}
+}
+
+static void surface_damage(struct wl_client *client, struct wl_resource *resource,
+                           int32_t x, int32_t y, int32_t width, int32_t height)
+{
+	add_damage(0, x, y, width, height);
+}
+
+static void surface_damage_buffer(struct wl_client *client, struct wl_resource *resource,
+                                  int32_t x, int32_t y, int32_t width, int32_t height)
+{
+	add_damage(1, x, y, width, height);
+}
+
+static void surface_frame(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	server.frame = wl_resource_create(client, &wl_callback_interface, 1, id);
+}
+
+static void surface_commit(struct wl_client *client, struct wl_resource *resource)
+{
+	pthread_mutex_lock(&server.mutex);
+	memcpy(server.committed, server.pending, sizeof(server.pending));
+	server.count = server.pending_count;
+	server.pending_count = 0;
+	if (server.commits < FRAMES)
+		server.presented[server.commits] = server.attached;
+	server.commits++;
+	pthread_mutex_unlock(&server.mutex);
+
+	if (server.frame) {
+		wl_callback_send_done(server.frame, 0);
+		wl_resource_destroy(server.frame);
+		server.frame = NULL;
+	}
+}
+
+static void surface_set_region(struct wl_client *client, struct wl_resource *resource,
+                               struct wl_resource *region)
+{
+}
+
+static void surface_set_int(struct wl_client *client, struct wl_resource *resource, int32_t value)
+{
+}
+
+static const struct wl_surface_interface surface_implementation = {
+	surface_destroy,
+	surface_attach,
+	surface_damage,
+	surface_frame,
+	surface_set_region,
+	surface_set_region,
+	surface_commit,
+	surface_set_int,
+	surface_set_int,
+	surface_damage_buffer,
+};
+
+static void region_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static void region_rect(struct wl_client *client, struct wl_resource *resource,
+                        int32_t x, int32_t y, int32_t width, int32_t height)
+{
+}
+
+static const struct wl_region_interface region_implementation = {
+	region_destroy,
+	region_rect,
+	region_rect,
+};
+
+static void compositor_create_surface(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	struct wl_resource *surface = wl_resource_create(client, &wl_surface_interface,
+			wl_resource_get_version(resource), id);
+	wl_resource_set_implementation(surface, &surface_implementation, NULL, NULL);
+}
+
+static void compositor_create_region(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	struct wl_resource *region = wl_resource_create(client, &wl_region_interface, 1, id);
+	wl_resource_set_implementation(region, &region_implementation, NULL, NULL);
+}
+
+static const struct wl_compositor_interface compositor_implementation = {
+	compositor_create_surface,
+	compositor_create_region,
+};
+
+static void bind_compositor(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	struct wl_resource *resource = wl_resource_create(client, &wl_compositor_interface, version, id);
+	wl_resource_set_implementation(resource, &compositor_implementation, NULL, NULL);
+}
+
+static void *server_thread(void *data)
+{
+	wl_display_run((struct wl_display *) data);
+	return NULL;
+}
+
+/* Client */
+
+static struct wl_compositor *compositor;
+
+static void registry_global(void *data, struct wl_registry *registry, uint32_t name,
+                            const char *interface, uint32_t version)
+{
+	if (strcmp(interface, "wl_compositor") == 0)
+		compositor = wl_registry_bind(registry, name, &wl_compositor_interface, version);
+}
+
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+static const struct wl_registry_listener registry_listener = {
+	registry_global,
+	registry_global_remove,
+};
+
+static void check_damage(const struct rect *expected, int count)
+{
+	int i;
+
+	pthread_mutex_lock(&server.mutex);
+	assert(server.count == count);
+	for (i = 0; i < count; i++) {
+		assert(server.committed[i].buffer == expected[i].buffer);
+		assert(server.committed[i].x == expected[i].x);
+		assert(server.committed[i].y == expected[i].y);
+		assert(server.committed[i].width == expected[i].width);
+		assert(server.committed[i].height == expected[i].height);
+	}
+	pthread_mutex_unlock(&server.mutex);
+}
+
+/* The number of frames since the buffer of a frame was last presented */
+static int presented_age(int frame)
+{
+	int i, age = 0;
+
+	pthread_mutex_lock(&server.mutex);
+	for (i = frame - 1; i >= 0; i--) {
+		if (server.presented[i] == server.presented[frame]) {
+			age = frame - i;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&server.mutex);
+
+	return age;
+}
+
+int main(int argc, char **argv)
+{
+	EGLConfig config;
+	EGLint num_config, age;
+	PFNEGLSWAPBUFFERSWITHDAMAGEEXTPROC swap_buffers_with_damage;
+	PFNEGLBINDWAYLANDDISPLAYWL bind_wayland_display;
+	pthread_t thread;
+	EGLBoolean ok;
+	int i, err;
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_NONE
+	};
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+
+	/* EGL coordinates, origin at the bottom left */
+	EGLint rects[] = {
+		10, 20, 30, 40,
+		0, 0, WIDTH, 1,
+	};
+	/* Buffer coordinates, origin at the top left */
+	const struct rect expected[] = {
+		{ 1, 10, HEIGHT - 20 - 40, 30, 40 },
+		{ 1, 0, HEIGHT - 1, WIDTH, 1 },
+	};
+	const struct rect full[] = {
+		{ 0, 0, 0, WIDTH, HEIGHT },
+	};
+
+	/* The compositor side */
+	struct wl_display *server_display = wl_display_create();
+	const char *socket = wl_display_add_socket_auto(server_display);
+	assert(socket != NULL);
+	struct wl_global *global = wl_global_create(server_display, &wl_compositor_interface, 4,
+			NULL, bind_compositor);
+	assert(global != NULL);
+
+	bind_wayland_display = (PFNEGLBINDWAYLANDDISPLAYWL) eglGetProcAddress("eglBindWaylandDisplayWL");
+	assert(bind_wayland_display != NULL);
+	ok = bind_wayland_display(EGL_NO_DISPLAY, server_display);
+	assert(ok == EGL_TRUE);
+
+	err = pthread_create(&thread, NULL, server_thread, server_display);
+	assert(err == 0);
+
+	/* The client side */
+	struct wl_display *display = wl_display_connect(socket);
+	assert(display != NULL);
+
+	struct wl_registry *registry = wl_display_get_registry(display);
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+	assert(compositor != NULL);
+
+	struct wl_surface *wl_surface = wl_compositor_create_surface(compositor);
+	struct wl_egl_window *window = wl_egl_window_create(wl_surface, WIDTH, HEIGHT);
+
+	EGLDisplay dpy = eglGetDisplay((EGLNativeDisplayType) display);
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+
+	const char *extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+	assert(strstr(extensions, "EGL_EXT_buffer_age") != NULL);
+
+	ok = eglChooseConfig(dpy, config_attribs, &config, 1, &num_config);
+	assert(ok == EGL_TRUE);
+	assert(num_config == 1);
+
+	EGLSurface surface = eglCreateWindowSurface(dpy, config, (EGLNativeWindowType) window, NULL);
+	assert(surface != EGL_NO_SURFACE);
+	EGLContext context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+	assert(context != EGL_NO_CONTEXT);
+	ok = eglMakeCurrent(dpy, surface, surface, context);
+	assert(ok == EGL_TRUE);
+	eglSwapInterval(dpy, 0);
+
+	swap_buffers_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEEXTPROC)
+		eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+	assert(swap_buffers_with_damage != NULL);
+
+	for (i = 0; i < FRAMES; i++) {
+		/* Before drawing, so before the buffer is dequeued */
+		ok = eglQuerySurface(dpy, surface, EGL_BUFFER_AGE_EXT, &age);
+		assert(ok == EGL_TRUE);
+		printf("frame %d: buffer age %d\n", i, age);
+
+		glClearColor(i / (float) FRAMES, 0.0, 0.0, 1.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		if (i % 2) {
+			ok = eglSwapBuffers(dpy, surface);
+			assert(ok == EGL_TRUE);
+			wl_display_roundtrip(display);
+			check_damage(full, 1);
+		} else {
+			ok = swap_buffers_with_damage(dpy, surface, rects, 2);
+			assert(ok == EGL_TRUE);
+			wl_display_roundtrip(display);
+			check_damage(expected, 2);
+		}
+
+		assert(age == presented_age(i));
+	}
+
+	assert(server.commits == FRAMES);
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(dpy, context);
+	eglDestroySurface(dpy, surface);
+	wl_egl_window_destroy(window);
+	eglTerminate(dpy);
+	wl_surface_destroy(wl_surface);
+	wl_display_disconnect(display);
+
+	wl_display_terminate(server_display);
+	pthread_join(thread, NULL);
+	wl_display_destroy(server_display);
+
+	printf("%d frames with the expected damage\n", FRAMES);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
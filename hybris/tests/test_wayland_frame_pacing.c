@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Frame pacing benchmark for Wayland EGL windows, with and without the
+ * event dispatch thread (HYBRIS_WAYLAND_DISPATCH_THREAD). A stub compositor
+ * runs in a thread of this process: it "scans out" at a fixed refresh rate,
+ * releasing the previous buffer and sending the frame callbacks on each
+ * refresh, like a real compositor would.
+ *
+ * Run with EGL_PLATFORM=wayland.
+ *
+ * Usage: test_wayland_frame_pacing [frames] [refresh period in ms]
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <wayland-client.h>
+#include <wayland-server.h>
+#include <wayland-egl.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define MAX_CALLBACKS 8
+
+typedef EGLBoolean (*PFNEGLBINDWAYLANDDISPLAYWL)(EGLDisplay dpy, struct wl_display *display);
+
+/* Stub compositor */
+
+struct buffer_ref {
+	struct wl_resource *resource;
+	struct wl_listener destroy;
+};
+
+static struct {
+	int period;
+	struct wl_event_source *vblank;
+	struct buffer_ref attached, next, scanout;
+	int ncallbacks;
+	struct wl_resource *callbacks[MAX_CALLBACKS];
+	int npending;
+	struct wl_resource *pending[MAX_CALLBACKS];
+} server;
+
+static void buffer_ref_destroyed(struct wl_listener *listener, void *data)
+{
+	struct buffer_ref *ref = wl_container_of(listener, ref, destroy);
+
+	ref->resource = NULL;
+	wl_list_remove(&ref->destroy.link);
+}
+
+static void buffer_ref_set(struct buffer_ref *ref, struct wl_resource *resource)
+{
+	if (ref->resource)
+		wl_list_remove(&ref->destroy.link);
+
+	ref->resource = resource;
+	if (resource) {
+		ref->destroy.notify = buffer_ref_destroyed;
+		wl_resource_add_destroy_listener(resource, &ref->destroy);
+	}
+}
+
+/* Shows the last committed buffer, and releases the one it replaces */
+static int vblank(void *data)
+{
+	int i;
+
+	if (server.next.resource) {
+		if (server.scanout.resource && server.scanout.resource != server.next.resource)
+			wl_buffer_send_release(server.scanout.resource);
+		buffer_ref_set(&server.scanout, server.next.resource);
+		buffer_ref_set(&server.next, NULL);
+	}
+
+	for (i = 0; i < server.ncallbacks; i++) {
+		wl_callback_send_done(server.callbacks[i], 0);
+		wl_resource_destroy(server.callbacks[i]);
+	}
+	server.ncallbacks = 0;
+
+	wl_event_source_timer_update(server.vblank, server.period);
+	return 0;
+}
+
+static void surface_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static void surface_attach(struct wl_client *client, struct wl_resource *resource,
+                           struct wl_resource *buffer, int32_t x, int32_t y)
+{
+	buffer_ref_set(&server.attached, buffer);
+}
+
+static void surface_damage(struct wl_client *client, struct wl_resource *resource,
+                           int32_t x, int32_t y, int32_t width, int32_t height)
+{
+}
+
+static void surface_frame(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	struct wl_resource *callback = wl_resource_create(client, &wl_callback_interface, 1, id);
+
+	assert(server.npending < MAX_CALLBACKS);
+	server.pending[server.npending++] = callback;
+}
+
+static void surface_commit(struct wl_client *client, struct wl_resource *resource)
+{
+	int i;
+
+	/* A buffer replaced before it was shown is released right away */
+	if (server.next.resource && server.next.resource != server.attached.resource)
+		wl_buffer_send_release(server.next.resource);
+	buffer_ref_set(&server.next, server.attached.resource);
+
+	for (i = 0; i < server.npending; i++) {
+		assert(server.ncallbacks < MAX_CALLBACKS);
+		server.callbacks[server.ncallbacks++] = server.pending[i];
+	}
+	server.npending = 0;
+}
+
+static void surface_set_region(struct wl_client *client, struct wl_resource *resource,
+                               struct wl_resource *region)
+{
+}
+
+static void surface_set_int(struct wl_client *client, struct wl_resource *resource, int32_t value)
+{
+}
+
+static const struct wl_surface_interface surface_implementation = {
+	surface_destroy,
+	surface_attach,
+	surface_damage,
+	surface_frame,
+	surface_set_region,
+	surface_set_region,
+	surface_commit,
+	surface_set_int,
+	surface_set_int,
+	surface_damage,
+};
+
+static void compositor_create_surface(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	struct wl_resource *surface = wl_resource_create(client, &wl_surface_interface,
+			wl_resource_get_version(resource), id);
+	wl_resource_set_implementation(surface, &surface_implementation, NULL, NULL);
+}
+
+static void compositor_create_region(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	/* Never used by EGL */
+	wl_client_post_no_memory(client);
+}
+
+static const struct wl_compositor_interface compositor_implementation = {
+	compositor_create_surface,
+	compositor_create_region,
+};
+
+static void bind_compositor(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+	struct wl_resource *resource = wl_resource_create(client, &wl_compositor_interface, version, id);
+	wl_resource_set_implementation(resource, &compositor_implementation, NULL, NULL);
+}
+
+static void *server_thread(void *data)
+{
+	wl_display_run((struct wl_display *) data);
+	return NULL;
+}
+
+/* Client */
+
+static struct wl_compositor *compositor;
+
+static void registry_global(void *data, struct wl_registry *registry, uint32_t name,
+                            const char *interface, uint32_t version)
+{
+	if (strcmp(interface, "wl_compositor") == 0)
+		compositor = wl_registry_bind(registry, name, &wl_compositor_interface, version);
+}
+
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+static const struct wl_registry_listener registry_listener = {
+	registry_global,
+	registry_global_remove,
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Renders frames with the dispatch thread on or off, and prints their pacing */
+static void run(struct wl_display *display, EGLDisplay dpy, EGLConfig config,
+                int frames, int dispatch_thread)
+{
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+	double interval_sum = 0, interval_sq = 0, interval_max = 0;
+	double swap_sum = 0, swap_max = 0;
+	double last = 0;
+	EGLBoolean ok;
+	int i;
+
+	/* Read when the native window is created */
+	setenv("HYBRIS_WAYLAND_DISPATCH_THREAD", dispatch_thread ? "1" : "0", 1);
+
+	struct wl_surface *wl_surface = wl_compositor_create_surface(compositor);
+	struct wl_egl_window *window = wl_egl_window_create(wl_surface, WIDTH, HEIGHT);
+
+	EGLSurface surface = eglCreateWindowSurface(dpy, config, (EGLNativeWindowType) window, NULL);
+	assert(surface != EGL_NO_SURFACE);
+	EGLContext context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+	assert(context != EGL_NO_CONTEXT);
+	ok = eglMakeCurrent(dpy, surface, surface, context);
+	assert(ok == EGL_TRUE);
+	eglSwapInterval(dpy, 1);
+
+	/* The first frames only fill the pipeline */
+	for (i = -3; i < frames; i++) {
+		glClearColor((i & 1) ? 1.0 : 0.0, 0.0, 0.0, 1.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		double start = now();
+		ok = eglSwapBuffers(dpy, surface);
+		double end = now();
+		assert(ok == EGL_TRUE);
+
+		if (i >= 0) {
+			double interval = end - last;
+
+			interval_sum += interval;
+			interval_sq += interval * interval;
+			if (interval > interval_max)
+				interval_max = interval;
+
+			swap_sum += end - start;
+			if (end - start > swap_max)
+				swap_max = end - start;
+		}
+		last = end;
+	}
+
+	double mean = interval_sum / frames;
+	double jitter = sqrt(interval_sq / frames - mean * mean);
+
+	printf("%-18s %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+		dispatch_thread ? "dispatch thread" : "render thread",
+		mean * 1e3, jitter * 1e3, interval_max * 1e3,
+		swap_sum / frames * 1e3, swap_max * 1e3);
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(dpy, context);
+	eglDestroySurface(dpy, surface);
+	wl_egl_window_destroy(window);
+	wl_surface_destroy(wl_surface);
+	wl_display_roundtrip(display);
+}
+
+int main(int argc, char **argv)
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 300;
+	EGLConfig config;
+	EGLint num_config;
+	PFNEGLBINDWAYLANDDISPLAYWL bind_wayland_display;
+	pthread_t thread;
+	EGLBoolean ok;
+	int err;
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_NONE
+	};
+
+	server.period = argc > 2 ? atoi(argv[2]) : 16;
+
+	/* The compositor side */
+	struct wl_display *server_display = wl_display_create();
+	const char *socket = wl_display_add_socket_auto(server_display);
+	assert(socket != NULL);
+	struct wl_global *global = wl_global_create(server_display, &wl_compositor_interface, 3,
+			NULL, bind_compositor);
+	assert(global != NULL);
+
+	server.vblank = wl_event_loop_add_timer(wl_display_get_event_loop(server_display), vblank, NULL);
+	wl_event_source_timer_update(server.vblank, server.period);
+
+	bind_wayland_display = (PFNEGLBINDWAYLANDDISPLAYWL) eglGetProcAddress("eglBindWaylandDisplayWL");
+	assert(bind_wayland_display != NULL);
+	ok = bind_wayland_display(EGL_NO_DISPLAY, server_display);
+	assert(ok == EGL_TRUE);
+
+	err = pthread_create(&thread, NULL, server_thread, server_display);
+	assert(err == 0);
+
+	/* The client side */
+	struct wl_display *display = wl_display_connect(socket);
+	assert(display != NULL);
+
+	struct wl_registry *registry = wl_display_get_registry(display);
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+	assert(compositor != NULL);
+
+	EGLDisplay dpy = eglGetDisplay((EGLNativeDisplayType) display);
+	ok = eglInitialize(dpy, NULL, NULL);
+	assert(ok == EGL_TRUE);
+	ok = eglChooseConfig(dpy, config_attribs, &config, 1, &num_config);
+	assert(ok == EGL_TRUE);
+	assert(num_config == 1);
+
+	printf("%d frames, %d ms refresh period, times in ms\n", frames, server.period);
+	printf("%-18s %8s %8s %8s %8s %8s\n", "events read by", "interval", "jitter",
+		"worst", "swap", "worst");
+
+	run(display, dpy, config, frames, 0);
+	run(display, dpy, config, frames, 1);
+
+	eglTerminate(dpy);
+	wl_display_disconnect(display);
+
+	wl_display_terminate(server_display);
+	pthread_join(thread, NULL);
+	wl_display_destroy(server_display);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Converts a log written with HYBRIS_LOGGING_FORMAT=binary into the JSON
+ * trace event format, which can be loaded by systrace (catapult) and the
+ * Perfetto UI.
+ *
+ * Usage: hybris-trace-decode [log file] [json file]
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+
+static const char *level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static void print_string(FILE *out, const char *s)
+{
+	fputc('"', out);
+	for (; *s; s++) {
+		unsigned char c = *s;
+
+		if (c == '"' || c == '\\')
+			fprintf(out, "\\%c", c);
+		else if (c == '\n')
+			fputs("\\n", out);
+		else if (c < 0x20)
+			fprintf(out, "\\u%04x", c);
+		else
+			fputc(c, out);
+	}
+	fputc('"', out);
+}
+
+static void print_record(FILE *out, const struct hybris_log_record *record,
+                         const char *name, const char *args)
+{
+	fprintf(out, "{\"pid\":%u,\"tid\":%u,\"ts\":%.3f,", record->pid, record->tid,
+		record->timestamp / 1000.0);
+
+	switch (record->type) {
+	case 'B':
+		fputs("\"ph\":\"B\",\"cat\":\"hybris\",\"name\":", out);
+		print_string(out, name);
+		break;
+	case 'E':
+		fputs("\"ph\":\"E\"", out);
+		break;
+	case 'C':
+		fputs("\"ph\":\"C\",\"cat\":\"hybris\",\"name\":", out);
+		print_string(out, name);
+		fprintf(out, ",\"args\":{\"value\":%g}", strtod(args, NULL));
+		break;
+	default:
+		fputs("\"ph\":\"i\",\"s\":\"t\",\"cat\":\"log\",\"name\":", out);
+		print_string(out, name);
+		fprintf(out, ",\"args\":{\"level\":\"%s\",\"message\":",
+			record->level < 4 ? level_names[record->level] : "?");
+		print_string(out, args);
+		fputc('}', out);
+		break;
+	}
+
+	fputc('}', out);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin, *out = stdout;
+	const size_t header_size = offsetof(struct hybris_log_record, text);
+	size_t size = 0, capacity = 1 << 20, offset = 0, n;
+	unsigned long events = 0;
+	char *data;
+
+	if (argc > 1 && !(in = fopen(argv[1], "rb"))) {
+		perror(argv[1]);
+		return 1;
+	}
+	if (argc > 2 && !(out = fopen(argv[2], "w"))) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	/* Records are 8-byte aligned within the file, keep them so in memory */
+	data = malloc(capacity);
+	while (data && (n = fread(data + size, 1, capacity - size, in)) > 0) {
+		size += n;
+		if (size == capacity)
+			data = realloc(data, capacity *= 2);
+	}
+	if (!data) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	fputs("{\"traceEvents\":[\n", out);
+
+	while (offset + header_size <= size) {
+		const struct hybris_log_record *record;
+		const char *name, *args, *end;
+
+		/* Every process writes this header when it starts logging */
+		if (memcmp(data + offset, HYBRIS_LOG_BINARY_MAGIC, 8) == 0) {
+			offset += 8;
+			continue;
+		}
+
+		record = (const struct hybris_log_record *) (data + offset);
+		if (record->size < header_size + 2 || offset + record->size > size) {
+			fprintf(stderr, "Corrupted or truncated record at offset %zu\n", offset);
+			break;
+		}
+
+		end = data + offset + record->size;
+		name = record->text;
+		args = name + strnlen(name, end - name) + 1;
+		if (args >= end)
+			args = "";
+
+		if (events++)
+			fputs(",\n", out);
+		print_record(out, record, name, args);
+
+		offset += record->size;
+	}
+
+	fputs("\n],\"displayTimeUnit\":\"ns\"}\n", out);
+
+	fprintf(stderr, "%lu events\n", events);
+
+	free(data);
+	if (in != stdin)
+		fclose(in);
+	if (out != stdout)
+		fclose(out);
+
+	return 0;
+}
+
+// vim:ts=4:sw=4:noexpandtab
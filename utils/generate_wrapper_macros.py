@@ -107,13 +107,6 @@ print """
         *(fptr) = (void *) android_dlsym(name##_handle, sym); \\
     }
 
-#define HYBRIS_LIBRARY_INITIALIZE(name, path) \\
-    void *name##_handle; \\
-    void hybris_##name##_initialize() \\
-    { \\
-        name##_handle = android_dlopen(path, RTLD_LAZY); \\
-    }
-
 #define HYBRIS_LIRBARY_CHECK_SYMBOL(name) \\
     bool hybris_##name##_check_for_symbol(const char *sym) \\
     { \\
@@ -122,6 +115,19 @@ print """
 
 """
 
+# Lazy binding (the default): each wrapper resolves its symbol on first call
+
+print """
+#ifndef HYBRIS_BINDING_EAGER
+
+#define HYBRIS_LIBRARY_INITIALIZE(name, path) \\
+    void *name##_handle; \\
+    void hybris_##name##_initialize() \\
+    { \\
+        name##_handle = android_dlopen(path, RTLD_LAZY); \\
+    }
+"""
+
 for count in range(MAX_ARGS):
     args = ['a%d' % (x+1) for x in range(count)]
     names = ['n%d' % (x+1) for x in range(count)]
@@ -167,6 +173,102 @@ for count in range(MAX_ARGS):
     {END}
 """.format(**locals())
 
+# Eager binding: the library is opened and the whole table resolved from a
+# constructor, so that the wrappers jump straight through their pointer
+
+print """
+#else /* HYBRIS_BINDING_EAGER */
+
+/**
+ * Eager binding, for libraries whose entry points are called often enough
+ * that checking on every call whether they are resolved shows, such as GL.
+ * Define HYBRIS_BINDING_EAGER before including this header: the library is
+ * then opened when it is loaded, as glesv2 does, and each wrapper is a
+ * single jump through a pointer that is already set.
+ *
+ * Each wrapper adds its pointer to the table in the "hybris_binding_<name>"
+ * section, which the constructor walks using the bounds the linker defines.
+ **/
+
+struct hybris_binding
+{
+    const char *symbol;
+    void **fptr;
+};
+
+#define HYBRIS_LIBRARY_INITIALIZE(name, path) \\
+    void *name##_handle; \\
+    extern struct hybris_binding __start_hybris_binding_##name[] __attribute__((weak)); \\
+    extern struct hybris_binding __stop_hybris_binding_##name[] __attribute__((weak)); \\
+    void hybris_##name##_initialize() \\
+    { \\
+        struct hybris_binding *b; \\
+        name##_handle = android_dlopen(path, RTLD_LAZY); \\
+        if (!name##_handle) \\
+            return; \\
+        for (b = __start_hybris_binding_##name; b < __stop_hybris_binding_##name; b++) \\
+            *b->fptr = android_dlsym(name##_handle, b->symbol); \\
+    } \\
+    static void __attribute__((constructor)) hybris_##name##_bind() \\
+    { \\
+        hybris_##name##_initialize(); \\
+    }
+
+#define HYBRIS_BIND_SYMBOL(name, symbol, fptr) \\
+    static struct hybris_binding hybris_binding_##name##_##symbol \\
+        __attribute__((section("hybris_binding_" #name), used, aligned(sizeof(void *)))) = \\
+        { #symbol, (void **) &fptr }
+"""
+
+for count in range(MAX_ARGS):
+    args = ['a%d' % (x+1) for x in range(count)]
+    names = ['n%d' % (x+1) for x in range(count)]
+    wrapper_signature = ', '.join(['name', 'return_type', 'symbol'] + args)
+    signature = ', '.join(args)
+    signature_with_names = ', '.join(' '.join(x) for x in zip(args, names))
+    call_names = ', '.join(names)
+
+    print """
+#define HYBRIS_IMPLEMENT_FUNCTION_CHECKED{count}({wrapper_signature}) \\
+    static return_type (*hybris_##name##_##symbol)({signature}) FP_ATTRIB; \\
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \\
+    return_type symbol({signature_with_names}) \\
+    {BEGIN} \\
+        if (!hybris_##name##_##symbol) \\
+            return -EINVAL; \\
+        return hybris_##name##_##symbol({call_names}); \\
+    {END}
+
+#define HYBRIS_IMPLEMENT_FUNCTION{count}({wrapper_signature}) \\
+    static return_type (*hybris_##name##_##symbol)({signature}) FP_ATTRIB; \\
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \\
+    return_type symbol({signature_with_names}) \\
+    {BEGIN} \\
+        return hybris_##name##_##symbol({call_names}); \\
+    {END}
+""".format(**locals())
+
+for count in range(MAX_ARGS):
+    args = ['a%d' % (x+1) for x in range(count)]
+    names = ['n%d' % (x+1) for x in range(count)]
+    wrapper_signature = ', '.join(['name', 'symbol'] + args)
+    signature = ', '.join(args)
+    signature_with_names = ', '.join(' '.join(x) for x in zip(args, names))
+    call_names = ', '.join(names)
+    print """
+#define HYBRIS_IMPLEMENT_VOID_FUNCTION{count}({wrapper_signature}) \\
+    static void (*hybris_##name##_##symbol)({signature}) FP_ATTRIB; \\
+    HYBRIS_BIND_SYMBOL(name, symbol, hybris_##name##_##symbol); \\
+    void symbol({signature_with_names}) \\
+    {BEGIN} \\
+        hybris_##name##_##symbol({call_names}); \\
+    {END}
+""".format(**locals())
+
+print """
+#endif /* HYBRIS_BINDING_EAGER */
+"""
+
 # Print it again, so people wanting to append new macros will see it
 print AUTO_GENERATED_WARNING
 